@@ -37,7 +37,8 @@ inline Options & operator<<(Options & options, const ProgramOptions & arguments)
 		"night",
 		"imageType",
 		"cave",
-		"nolonely"
+		"nolonely",
+		"readahead"
 	};
 	for (auto & vars : arguments.getParameters())
 	{
@@ -80,6 +81,7 @@ int main(int argc, const char * argv[])
 	arguments.addParamType<std::string>("pipelineArgs", 'a', "arg", 1);
 	arguments.addParamType<std::string>("createColor", "createcolor", 1);
 	arguments.addParam("nolonely", "no-lonely");
+	arguments.addParamType<int>("readahead", "readahead", 1);
 	arguments.addParamType<std::string>("verbosity", "verbosity", 1); // critical, error, warn, info, debug, trace, off
 	arguments.addParam("verbose", "verbose"); // verbosity=debug
 	arguments.addParam("quiet", 'q', "quiet"); // verbosity=error
@@ -104,6 +106,7 @@ int main(int argc, const char * argv[])
 	arguments.addHelp("pipelineArgs", "Set library parameters.");
 	arguments.addHelp("createColor", "Create block color file from default.");
 	arguments.addHelp("nolonely", "Disable lonely checking.");
+	arguments.addHelp("readahead", "The amount of files to read ahead of workers. Default is 2, 0 disables it.");
 	arguments.addHelp("verbosity", "Specify exact verbosity level: critical, error, warn, info(default), debug, trace, off");
 	arguments.addHelp("verbose", "Display more output to the user.");
 	arguments.addHelp("quiet", "Silence all output.");
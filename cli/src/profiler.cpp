@@ -120,7 +120,7 @@ void MemoryProfiler::print() const
 	std::cout << "Sum allocations: " << sum_allocs << std::endl;
 	std::cout << "Sum deallocations: " << sum_deallocs << std::endl;
 	std::cout << "Diff allocations: " << diff_sum << std::endl;
-	std::cout << "Avg. allocation size, max allocation size: " << (sum_allocs / allocs) << " ; " << s_max_alloc_size << std::endl;
+	std::cout << "Avg. allocation size, max allocation size: " << (allocs > 0 ? sum_allocs / allocs : 0) << " ; " << s_max_alloc_size << std::endl;
 	std::cout << "Max allocation: " << sum_max << std::endl;
 }
 
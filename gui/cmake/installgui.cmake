@@ -27,6 +27,12 @@ if (PIXELMAP_USE_LIBDEFLATE)
 	install(FILES "${DEFLATE_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "deflate.txt")
 endif()
 install(FILES "${LZ4_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "lz4.txt")
+if (PIXELMAP_USE_SNAPPY)
+	install(FILES "${SNAPPY_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "snappy.txt")
+endif()
+if (PIXELMAP_USE_ZSTD)
+	install(FILES "${ZSTD_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "zstd.txt")
+endif()
 install(FILES "${PNG_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "png.txt")
 install(FILES "${GLM_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "glm.txt")
 install(FILES "${FMT_LICENSE_FILE}" TYPE DOC COMPONENT gui RENAME "fmt.txt")
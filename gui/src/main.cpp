@@ -3,6 +3,7 @@
 #include "gui.hpp"
 #include "pixelmap.hpp"
 #include "minecraft.hpp"
+#include "format/region.hpp"
 #include "timer.hpp"
 #include "log.hpp"
 #include "libraryoptions.hpp"
@@ -142,6 +143,11 @@ int main(int, char**)
 	std::vector<OutputType> output_types_type = {TYPE_FILE, TYPE_DIRECTORY, TYPE_DIRECTORY};
 	std::size_t output_type_selected = 0;
 	std::string outputFile = "image.png", outputPath = "map";
+	// Region headers are indexed with the output, so the world info can use them
+	auto indexFile = [&output_types_type, &output_type_selected, &outputFile, &outputPath]() {
+		bool folder = output_types_type[output_type_selected] == TYPE_DIRECTORY;
+		return region::getIndexFile(folder ? outputPath : outputFile, folder);
+	};
 	int workers = std::thread::hardware_concurrency();
 	bool auto_close = false;
 	std::string colors = "blockcolor.conf";
@@ -163,10 +169,10 @@ int main(int, char**)
 
 	if (!minecraft_paths.empty())
 	{
-		worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path) {
+		worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path, const std::string & index) {
 			window.refresh();
-			return Minecraft::getWorldInfo(path);
-		}, minecraft_paths[minecraft_path_selected]);
+			return Minecraft::getWorldInfo(path, index);
+		}, minecraft_paths[minecraft_path_selected], indexFile());
 	}
 
 	while (window.alive())
@@ -215,11 +221,11 @@ int main(int, char**)
 							ImGui::EndTabItem();
 							if (prev != minecraft_path_selected && !minecraft_paths.empty())
 							{
-								worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path) {
-									auto world = Minecraft::getWorldInfo(path);
+								worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path, const std::string & index) {
+									auto world = Minecraft::getWorldInfo(path, index);
 									window.refresh();
 									return world;
-								}, minecraft_paths[minecraft_path_selected]);
+								}, minecraft_paths[minecraft_path_selected], indexFile());
 								window.refresh();
 							}
 						}
@@ -240,11 +246,11 @@ int main(int, char**)
 							}
 							else if (custom_path_timer.shouldUpdate())
 							{
-								worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path) {
-									auto world = Minecraft::getWorldInfo(path);
+								worldInfoWorker = std::async(std::launch::async, [&window](const std::string & path, const std::string & index) {
+									auto world = Minecraft::getWorldInfo(path, index);
 									window.refresh();
 									return world;
-								}, custom_path);
+								}, custom_path, indexFile());
 								window.refresh();
 							}
 							ImGui::EndTabItem();
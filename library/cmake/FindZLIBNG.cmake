@@ -0,0 +1,48 @@
+if(ZLIBNG_PREFER_STATIC_LIB)
+    set(ZLIBNG_ORIG_CMAKE_FIND_LIBRARY_SUFFIXES ${CMAKE_FIND_LIBRARY_SUFFIXES})
+    if(WIN32)
+        set(CMAKE_FIND_LIBRARY_SUFFIXES .a .lib ${CMAKE_FIND_LIBRARY_SUFFIXES})
+    else()
+        set(CMAKE_FIND_LIBRARY_SUFFIXES .a ${CMAKE_FIND_LIBRARY_SUFFIXES})
+    endif()
+endif()
+
+if(UNIX)
+    find_package(PkgConfig QUIET)
+    pkg_check_modules(_ZLIBNG QUIET zlib-ng)
+endif()
+
+find_path(ZLIBNG_INCLUDE_DIR
+    NAMES zlib-ng.h
+    HINTS ${_ZLIBNG_INCLUDEDIR})
+find_library(ZLIBNG_LIBRARY
+    NAMES z-ng zlib-ng zlibstatic-ng
+    HINTS ${_ZLIBNG_LIBDIR})
+
+set(ZLIBNG_INCLUDE_DIRS ${ZLIBNG_INCLUDE_DIR})
+set(ZLIBNG_LIBRARIES ${ZLIBNG_LIBRARY})
+
+if(_ZLIBNG_VERSION)
+    set(ZLIBNG_VERSION ${_ZLIBNG_VERSION})
+elseif(ZLIBNG_INCLUDE_DIR)
+    file(STRINGS "${ZLIBNG_INCLUDE_DIR}/zlib-ng.h" ZLIBNG_VERSION_STR
+        REGEX "^#define[\t ]+ZLIBNG_VERSION[\t ]+\"[^\"]+\"")
+    if(ZLIBNG_VERSION_STR MATCHES "\"([^\"]+)\"")
+        set(ZLIBNG_VERSION "${CMAKE_MATCH_1}")
+    endif()
+endif()
+
+include(FindPackageHandleStandardArgs)
+
+find_package_handle_standard_args(ZLIBNG
+    REQUIRED_VARS
+        ZLIBNG_INCLUDE_DIR
+        ZLIBNG_LIBRARY
+    VERSION_VAR ZLIBNG_VERSION)
+
+mark_as_advanced(ZLIBNG_INCLUDE_DIR ZLIBNG_LIBRARY)
+
+if(ZLIBNG_PREFER_STATIC_LIB)
+    set(CMAKE_FIND_LIBRARY_SUFFIXES ${ZLIBNG_ORIG_CMAKE_FIND_LIBRARY_SUFFIXES})
+    unset(ZLIBNG_ORIG_CMAKE_FIND_LIBRARY_SUFFIXES)
+endif()
@@ -16,6 +16,8 @@ include(FetchContent_MakeAvailableExcludeFromAll)
 set(ZLIB_VERSION 1.3.1)
 set(DEFLATE_VERSION 1.24)
 set(LZ4_VERSION 1.10.0)
+set(SNAPPY_VERSION 1.2.2)
+set(ZSTD_VERSION 1.5.7)
 set(PNG_VERSION 1.6.48)
 set(GLM_VERSION 1.0.1)
 set(FMT_VERSION 11.2.0)
@@ -74,6 +76,13 @@ if (PIXELMAP_USE_LIBDEFLATE)
 	set(DEFLATE_LICENSE_FILE "${deflate_SOURCE_DIR}/COPYING" PARENT_SCOPE)
 endif()
 
+# zlib-ng
+# Note: Its targets are named as the ones from zlib, so it cannot be fetched
+# into the same project
+if (PIXELMAP_USE_ZLIBNG)
+	find_package(ZLIBNG REQUIRED)
+endif()
+
 # lz4
 FetchContent_Declare(
 	LZ4
@@ -95,6 +104,56 @@ set(LZ4_INCLUDE_DIRS "${LZ4_INCLUDE_DIR}/lib")
 add_subdirectory("${lz4_SOURCE_DIR}/build/cmake" "${lz4_BINARY_DIR}")
 set(LZ4_LICENSE_FILE "${lz4_SOURCE_DIR}/LICENSE" PARENT_SCOPE)
 
+# snappy
+if (PIXELMAP_USE_SNAPPY)
+	FetchContent_Declare(
+		SNAPPY
+		GIT_REPOSITORY "https://github.com/google/snappy.git"
+		GIT_TAG "${SNAPPY_VERSION}"
+		EXCLUDE_FROM_ALL
+	)
+
+	set(SNAPPY_BUILD_TESTS OFF)
+	set(SNAPPY_BUILD_BENCHMARKS OFF)
+	set(SNAPPY_INSTALL OFF)
+	FetchContent_MakeAvailable(SNAPPY)
+	set(SNAPPY_LIBRARY snappy)
+	set(SNAPPY_LIBRARIES ${SNAPPY_LIBRARY})
+	set(SNAPPY_INCLUDE_DIRS "${snappy_SOURCE_DIR}" "${snappy_BINARY_DIR}")
+	set(SNAPPY_LICENSE_FILE "${snappy_SOURCE_DIR}/COPYING" PARENT_SCOPE)
+endif()
+
+# zstd
+if (PIXELMAP_USE_ZSTD)
+	FetchContent_Declare(
+		ZSTD
+		GIT_REPOSITORY "https://github.com/facebook/zstd.git"
+		GIT_TAG "v${ZSTD_VERSION}"
+		SOURCE_SUBDIR "build/cmake"
+		EXCLUDE_FROM_ALL
+	)
+
+	set(ZSTD_BUILD_PROGRAMS OFF)
+	set(ZSTD_BUILD_TESTS OFF)
+	set(ZSTD_BUILD_CONTRIB OFF)
+	set(ZSTD_LEGACY_SUPPORT OFF)
+	set(ZSTD_BUILD_SHARED ${BUILD_SHARED_LIBS})
+	if (${BUILD_SHARED_LIBS})
+		set(ZSTD_BUILD_STATIC OFF)
+	else()
+		set(ZSTD_BUILD_STATIC ON)
+	endif()
+	FetchContent_MakeAvailable(ZSTD)
+	if (${BUILD_SHARED_LIBS})
+		set(ZSTD_LIBRARY libzstd_shared)
+	else()
+		set(ZSTD_LIBRARY libzstd_static)
+	endif()
+	set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+	set(ZSTD_INCLUDE_DIRS "${zstd_SOURCE_DIR}/lib")
+	set(ZSTD_LICENSE_FILE "${zstd_SOURCE_DIR}/LICENSE" PARENT_SCOPE)
+endif()
+
 # png
 FetchContent_Declare(
 	PNG
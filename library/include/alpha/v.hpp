@@ -8,7 +8,7 @@
 namespace alpha
 {
 
-class V : public NBT::Visitor
+class V final : public NBT::Visitor
 {
 public:
 	V(Chunk & chunk);
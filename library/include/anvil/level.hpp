@@ -45,7 +45,7 @@ private:
 };
 
 // A class based on level reader
-class LevelReader : public NBT::Visitor
+class LevelReader final : public NBT::Visitor
 {
 public:
 	LevelReader(Level & level);
@@ -15,6 +15,10 @@ public:
     
     bool visit(const NBT::Value & value);
     bool visit(const NBT::Tag & tag);
+    // Find the version without visiting anything else
+    NBT::Scan scan(const NBT::Tag & tag);
+    // Paths needed by the version, or nullptr to read everything
+    virtual const NBT::Query * query() const;
 protected:
     Chunk & chunk;
     SectionData section;
@@ -13,6 +13,7 @@ public:
 	V18(Chunk & chunk) : V(chunk) {}
 
 	bool visit(const NBT::Tag & tag) override;
+	const NBT::Query * query() const override;
 private:
 	// Block IDs
 	//std::vector<uint16_t> blocks;
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef BEDROCK_FILERANGES_HPP
+#define BEDROCK_FILERANGES_HPP
+
+#include "format/leveldb.hpp"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bedrock
+{
+
+/**
+ * @brief A level file parsed in ranges of data blocks
+ * Ranges are claimed in order by any thread, including the one owning the
+ * file, so helpers that start late will find nothing left. Nobody waits on
+ * the others, as whoever finishes the last range finishes the file.
+ */
+class FileRanges
+{
+public:
+	typedef LevelDB::LevelReader::BlockHandle BlockHandle;
+	// Parse a range of blocks, returning an error if failed
+	typedef std::function<std::string(std::size_t, VectorView<const BlockHandle>)> ParseFunction;
+	// Called once when all ranges are parsed
+	typedef std::function<void(FileRanges &)> FinishFunction;
+
+	/**
+	 * @brief Constructor
+	 * @param blocks The blocks to parse, sorted by offset
+	 * @param count The amount of ranges to split the blocks into
+	 * @param parse The function to parse a range with
+	 * @param finish The function to call when all ranges are parsed
+	 */
+	FileRanges(std::vector<BlockHandle> && blocks, std::size_t count, ParseFunction && parse, FinishFunction && finish);
+
+	/**
+	 * @brief Parse ranges until none are left
+	 * The thread parsing the last range calls the finish function.
+	 */
+	void work();
+
+	/**
+	 * @brief Get the amount of ranges
+	 */
+	std::size_t size() const { return errors.size(); }
+
+	/**
+	 * @brief Get the blocks of a range
+	 * @param i The index of the range
+	 */
+	VectorView<const BlockHandle> range(std::size_t i) const;
+
+	/**
+	 * @brief Get the error of a range, empty if none
+	 * @param i The index of the range
+	 */
+	const std::string & error(std::size_t i) const { return errors[i]; }
+
+private:
+	std::vector<BlockHandle> blocks;
+	std::vector<std::string> errors;
+	ParseFunction parse;
+	FinishFunction finish;
+	std::atomic_size_t next{0};
+	std::atomic_size_t done{0};
+};
+
+} // namespace bedrock
+
+#endif // BEDROCK_FILERANGES_HPP
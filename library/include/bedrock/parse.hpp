@@ -2,6 +2,8 @@
 #ifndef BEDROCK_PARSE_HPP
 #define BEDROCK_PARSE_HPP
 
+#include "vectorview.hpp"
+
 #include <vector>
 
 #include <cstdint>
@@ -15,11 +17,24 @@ namespace parse
 		int8_t index = -1; // Optional
 	};
 
-	ChunkKey read_chunk_key(const std::vector<uint8_t> & key);
+	ChunkKey read_chunk_key(const VectorView<const uint8_t> & key);
+
+	/**
+	 * @brief Check if a range of table keys may contain chunk data
+	 * Every key within the range shares the prefix the bounds have in
+	 * common, and the byte after it lies between those of the bounds,
+	 * which is enough to rule out keys of other kinds or of other
+	 * dimensions.
+	 * @param lower The key below the range, empty if unbounded
+	 * @param upper The last possible key of the range
+	 * @param dimension The dimension to look for
+	 * @return False if the range has no chunk data, true if it may have
+	 */
+	bool may_contain_chunk_data(const VectorView<const uint8_t> & lower, const VectorView<const uint8_t> & upper, int32_t dimension);
 
 	namespace mc
 	{
-		bool is_key_sub_chunk_prefix(const std::vector<uint8_t> & key);
+		bool is_key_sub_chunk_prefix(const VectorView<const uint8_t> & key);
 	}
 } // namespace parse
 
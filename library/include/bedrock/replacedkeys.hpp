@@ -0,0 +1,73 @@
+#pragma once
+#ifndef BEDROCK_REPLACEDKEYS_HPP
+#define BEDROCK_REPLACEDKEYS_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bedrock
+{
+
+/**
+ * @brief Keys replaced by newer files, resolved one pass at a time
+ * The files of a pass are replaced by the keys of every pass before it, so
+ * a pass is ready as soon as the files before it are read. Files are read
+ * by any thread, and whoever reads the last file of a pass announces the
+ * passes it makes ready. Nobody waits on the others to finish reading.
+ */
+class ReplacedKeys
+{
+public:
+	// User keys, sorted and unique
+	typedef std::shared_ptr<const std::vector<std::string>> Keys;
+	// Read the sorted keys of a file within a pass
+	typedef std::function<std::vector<std::string>(std::size_t, std::size_t)> ReadFunction;
+	// Called once for each pass when ready, in order, with the keys replacing its files
+	typedef std::function<void(std::size_t, const Keys &)> ReadyFunction;
+
+	/**
+	 * @brief Constructor
+	 * @param files The amount of files in each pass, newest first
+	 * @param read The function to read the keys of a file with
+	 * @param ready The function to call when a pass is ready
+	 */
+	ReplacedKeys(std::vector<std::size_t> files, ReadFunction && read, ReadyFunction && ready);
+
+	/**
+	 * @brief Announce the first pass, as nothing replaces it
+	 */
+	void start();
+
+	/**
+	 * @brief Read the keys of a file
+	 * Every file of every pass but the last has to be read once, as
+	 * nothing is older than the last pass.
+	 * @param pass The index of the pass
+	 * @param file The index of the file within the pass
+	 */
+	void work(std::size_t pass, std::size_t file);
+
+	/**
+	 * @brief Get the amount of passes
+	 */
+	std::size_t size() const { return left.size(); }
+
+private:
+	std::vector<std::size_t> left;
+	std::vector<std::vector<std::string>> found;
+	Keys keys;
+	std::size_t announced = 0;
+	bool started = false;
+	std::mutex mutex;
+	ReadFunction read;
+	ReadyFunction ready;
+
+	void announce();
+};
+
+} // namespace bedrock
+
+#endif // BEDROCK_REPLACEDKEYS_HPP
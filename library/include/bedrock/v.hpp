@@ -14,7 +14,7 @@ class V : public LevelDB::Visitor
 public:
 	V(World & world);
     
-    void visit(const std::vector<uint8_t> & key, const LevelDB::VectorData & data);
+    void visit(const LevelDB::VectorData & key, const LevelDB::VectorData & data);
 protected:
     World & world;
 	// Namespace/Index translate table
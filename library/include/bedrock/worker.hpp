@@ -6,6 +6,10 @@
 
 #include "lightsource.hpp"
 
+#include <future>
+#include <string>
+#include <vector>
+
 namespace LevelDB
 {
 class LevelFile;
@@ -41,11 +45,31 @@ private:
 
 	/**
 	 * @brief Working on a level file
+	 * Large files are parsed over several threads, and the file is
+	 * finished by the thread parsing the last part, without waiting.
 	 * @param file Data from a level file
 	 * @param dimension The dimension to read from the file
-	 * @return A world from the file, chunks being prerendered
+	 * @param replaced Keys in newer files, replacing those in this file
+	 * @param result Where to put the world from the file, chunks being prerendered
+	 */
+	void workFile(std::shared_ptr<LevelDB::LevelFile> file, int32_t dimension, std::shared_ptr<const std::vector<std::string>> replaced, std::shared_ptr<std::promise<std::shared_ptr<bedrock::World>>> result);
+
+	/**
+	 * @brief Finish a parsed level file
+	 * @param file Data from a level file
+	 * @param world The world parsed from the file
+	 * @param error True if the parsing failed
+	 * @return The world, chunks being prerendered
+	 */
+	std::shared_ptr<bedrock::World> finishFile(std::shared_ptr<LevelDB::LevelFile> file, std::shared_ptr<bedrock::World> world, bool error);
+
+	/**
+	 * @brief Working on the log files
+	 * @param files Data from the log files, oldest first
+	 * @param dimension The dimension to read from the files
+	 * @return A world from the logs, chunks being prerendered
 	 */
-	std::shared_ptr<bedrock::World> workFile(std::shared_ptr<LevelDB::LevelFile> file, int32_t dimension);
+	std::shared_ptr<bedrock::World> workLog(std::vector<std::shared_ptr<LevelDB::LevelFile>> files, int32_t dimension);
 
 	/**
 	 * @brief Merge two worlds
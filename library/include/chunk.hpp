@@ -34,6 +34,8 @@ struct TileData
 };
 
 // A section storing all tiles for that section
+// Blocks are packed with as few bits as their indices need, where a section
+// of only one block keeps that single index. Light is only stored when set.
 // It works along with allocate on write, and can be reused
 class SectionData
 {
@@ -53,17 +55,23 @@ public:
 	void transform(const std::function<uint16_t(uint16_t)> & c);
 
 	int32_t getY() const { return y; }
-	const TileData & getTile(const utility::BlockPosition & pos) const;
+	TileData getTile(const utility::BlockPosition & pos) const;
 	bool allocated() const;
 
 	void clear();
 
 private:
-	std::vector<TileData> data;
+	// Indices packed in little endian, or a single index for the whole section when bits is 0
+	std::vector<uint64_t> blocks;
+	// Nibbles of light for each tile
+	std::vector<uint8_t> blockLight, skyLight;
 	BlockOrder blockOrder = BlockOrder::YZX;
 	int32_t y = 0;
+	// Width of the packed indices, with the mask to read one
+	uint8_t bits = 0;
+	uint16_t mask = 0xFFFF;
 
-	void allocate();
+	uint16_t getIndex(std::size_t i) const;
 };
 
 // Chunk storing all sections
@@ -93,7 +101,7 @@ public:
 
 	bool isValid() const;
 	bool hasSection(const utility::BlockPosition & pos) const;
-	const TileData & getTile(const utility::BlockPosition & pos) const;
+	TileData getTile(const utility::BlockPosition & pos) const;
 	const SectionData & getSection(const utility::BlockPosition & pos) const;
 	int32_t getHeight(const utility::PlanePosition & pos) const;
 	int32_t getMinY() const { return minY; }
@@ -116,6 +124,7 @@ private:
 	} palette;
 	PaletteType paletteType = PaletteType::UNKNOWN;
 	std::vector<int32_t> heightMap;
+	bool hasHeightMap = false;
 	int32_t dataVersion = 0;
 	int32_t xPos = 0, zPos = 0, yPos = 0, maxY, minY;
 
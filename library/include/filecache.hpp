@@ -0,0 +1,130 @@
+#pragma once
+#ifndef FILE_CACHE_HPP
+#define FILE_CACHE_HPP
+
+#include "platform.hpp"
+
+#include <mutex>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <string>
+
+/**
+ * @brief Cache of open files
+ * Keeps a limited amount of files open, closing the least recently used
+ * one when full. Files are borrowed only for the duration of a read or a
+ * mapping, and all reads are positional, so any amount of threads may
+ * share a file without sharing any seek state. Idle files are reopened
+ * when borrowed again if they have changed since they were opened.
+ */
+class FileCache
+{
+	struct Entry
+	{
+		platform::file::Handle handle = platform::file::INVALID_HANDLE;
+		uint64_t size = 0;
+		int64_t modified = 0;
+		std::size_t users = 0;
+		// Note: Keys of the map are never moved
+		const std::string * file = nullptr;
+		// Position among idle files, only valid when not borrowed
+		std::list<Entry *>::iterator order;
+	};
+public:
+	/**
+	 * @brief A borrowed file
+	 * The file is kept open until the borrow is released.
+	 */
+	class Handle
+	{
+	public:
+		Handle() = default;
+		Handle(const Handle &) = delete;
+		Handle(Handle && other) noexcept;
+		~Handle();
+
+		Handle & operator=(const Handle &) = delete;
+		Handle & operator=(Handle && other) noexcept;
+
+		/**
+		 * @brief Check if the file was opened
+		 */
+		explicit operator bool() const { return entry != nullptr; }
+
+		/**
+		 * @brief Get the size of the file
+		 * @return The size of the file when it was opened
+		 */
+		uint64_t size() const;
+
+		/**
+		 * @brief Read from a specific offset of the file
+		 * @param out Where to store the read data
+		 * @param size The amount of bytes to read
+		 * @param offset The offset to read from
+		 * @return The amount of bytes read, negative if error
+		 */
+		std::ptrdiff_t read(void * out, std::size_t size, uint64_t offset) const;
+
+		/**
+		 * @brief Map the whole file into memory
+		 * The mapping stays valid after the file is returned.
+		 * @param size The size of the mapped memory
+		 * @return Valid pointer for success, NULL if error
+		 */
+		std::shared_ptr<void> map(std::size_t & size) const;
+
+		/**
+		 * @brief Return the file to the cache
+		 */
+		void release();
+
+	private:
+		friend class FileCache;
+		Handle(FileCache * cache, Entry * entry);
+
+		FileCache * cache = nullptr;
+		Entry * entry = nullptr;
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param capacity Amount of files to keep open
+	 */
+	explicit FileCache(std::size_t capacity);
+	~FileCache();
+
+	/**
+	 * @brief Get the cache shared by the whole process
+	 * The capacity is based on the amount of file descriptors available.
+	 * @return The shared cache
+	 */
+	static FileCache & global();
+
+	/**
+	 * @brief Borrow a file, opening it if needed
+	 * @param file The file to borrow
+	 * @return The borrowed file, empty on failure
+	 */
+	Handle acquire(const std::string & file);
+
+	/**
+	 * @brief Close all files not currently borrowed
+	 * Should be called when files may have changed on disk.
+	 */
+	void clear();
+
+private:
+	std::mutex mutex;
+	std::unordered_map<std::string, Entry> files;
+	// Files not borrowed, least recently used first
+	std::list<Entry *> idle;
+	std::size_t capacity;
+
+	void release(Entry * entry);
+	bool evict();
+	bool open(Entry & entry);
+};
+
+#endif // FILE_CACHE_HPP
@@ -13,6 +13,7 @@
 #include <iterator>
 #include <functional>
 #include <unordered_map>
+#include <map>
 
 namespace LevelDB
 {
@@ -52,9 +53,53 @@ namespace LevelDB
 		// Get region timestamp
 		uint64_t getModifiedTimestamp() const;
 
+		// Level of the file, negative if unknown
+		int level() const { return _level; }
+		// Range of user keys in the file, empty if unknown
+		const std::vector<uint8_t> & smallest() const { return _smallest; }
+		const std::vector<uint8_t> & largest() const { return _largest; }
+		// Read the user keys of the file, sorted and unique. Only blocks
+		// accepted by the filter are read, as for LevelReader::blocks.
+		// Note: Reads through its own handle, so it may be called while
+		// the file is used elsewhere
+		std::vector<std::string> readKeys(std::function<bool(const VectorData &, const VectorData &)> filter) const;
+
 	private:
+		friend class LevelDB;
+
 		std::string _file;
 		std::string _path;
+		int _level = -1;
+		uint64_t _number = 0;
+		std::vector<uint8_t> _smallest, _largest;
+	};
+
+	// Live files of a database, as described by its manifest
+	struct Version
+	{
+		struct File
+		{
+			int level;
+			uint64_t number;
+			uint64_t size;
+			// Internal keys
+			std::vector<uint8_t> smallest, largest;
+		};
+
+		std::vector<File> files;
+		uint64_t logNumber = 0;
+		uint64_t prevLogNumber = 0;
+		uint64_t nextFileNumber = 0;
+		uint64_t lastSequence = 0;
+	};
+
+	// Strip the sequence number and type from a key in a table
+	VectorData userKey(const VectorData & key);
+
+	// Inclusive range of user keys
+	struct KeyRange
+	{
+		VectorData lower, upper;
 	};
 
 	class LevelDB
@@ -95,14 +140,32 @@ namespace LevelDB
 
 		std::size_t size() const;
 
-		std::shared_ptr<LevelFile> getLog() const;
+		// Logs not yet written to tables, ordered from oldest to newest
+		std::vector<std::shared_ptr<LevelFile>> getLogs() const;
+
+		// Files grouped into passes, newest first. The keys of every pass
+		// before replace those in a pass, while files within a pass never
+		// replace each other. Without a manifest all files share one pass.
+		std::vector<std::vector<std::shared_ptr<LevelFile>>> passes();
+
+		// Visit the newest values of a chunk, read from only the parts of
+		// the files that may contain it. Keys are visited without trailer.
+		bool getChunk(int32_t x, int32_t z, int32_t dimension, std::function<void(const VectorData &, const VectorData &)> visit);
+		// Visit the newest values of all chunks within an inclusive range
+		bool getChunks(int32_t x1, int32_t z1, int32_t x2, int32_t z2, int32_t dimension, std::function<void(const VectorData &, const VectorData &)> visit);
 
 	private:
 		std::string path;
 		Levels levels;
-		std::string log;
+		std::vector<std::string> logs;
 
 		void populateFromPath();
+		// Read the version pointed to by CURRENT
+		bool readManifest(Version & version) const;
+		// Keep only the live files, ordered from oldest to newest
+		void applyVersion(const Version & version);
+		// Visit the newest value of each user key within the sorted ranges
+		bool get(const std::vector<KeyRange> & ranges, const std::function<void(const VectorData &, const VectorData &)> & visit);
 	};
 
 	class Visitor
@@ -110,7 +173,7 @@ namespace LevelDB
 	protected:
 		virtual ~Visitor() = default;
 	public:
-		virtual void visit(const std::vector<uint8_t> & key, const VectorData & data) = 0;
+		virtual void visit(const VectorData & key, const VectorData & data) = 0;
 	};
 
 	class Reader
@@ -121,8 +184,8 @@ namespace LevelDB
 		std::ptrdiff_t parse(VectorView<uint8_t> data, Visitor & visitor);
 
 		// Parse the data with a pair of functions
-		std::ptrdiff_t parse(std::vector<uint8_t> & data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit);
-		virtual std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit) = 0;
+		std::ptrdiff_t parse(std::vector<uint8_t> & data, std::function<void(const VectorData &, const VectorData &)> visit);
+		virtual std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &)> visit) = 0;
 
 		// Get previous error as a string
 		const std::string & getError() const { return error; }
@@ -138,15 +201,72 @@ namespace LevelDB
 	class LevelReader : public Reader
 	{
 	public:
+		// Location of a data block in a table
+		struct BlockHandle
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+
 		using Reader::parse;
-		std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &)> visit);
+
+		// Get the data blocks from the index, sorted by offset
+		std::ptrdiff_t blocks(VectorView<uint8_t> data, std::vector<BlockHandle> & handles);
+		// Get the data blocks accepted by the filter, which is given the
+		// keys bounding each block: lower < key <= upper. The lower key is
+		// empty for the first block.
+		std::ptrdiff_t blocks(VectorView<uint8_t> data, std::vector<BlockHandle> & handles, std::function<bool(const VectorData &, const VectorData &)> filter);
+
+		// Parse only a set of data blocks, in the order given
+		std::ptrdiff_t parse(VectorView<uint8_t> data, VectorView<const BlockHandle> handles, Visitor & visitor);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, VectorView<const BlockHandle> handles, std::function<void(const VectorData &, const VectorData &)> visit);
+
+		// Visit the newest entry of each sorted user key found. Only blocks
+		// that may contain the keys are read, using the bloom filter if
+		// the table has one.
+		std::ptrdiff_t get(VectorView<uint8_t> data, VectorView<const VectorData> keys, std::function<void(const VectorData &, const VectorData &)> visit);
+		// Visit the newest entry of each user key within the sorted and
+		// disjoint ranges. Only blocks overlapping the ranges are read.
+		std::ptrdiff_t scan(VectorView<uint8_t> data, VectorView<const KeyRange> ranges, std::function<void(const VectorData &, const VectorData &)> visit);
+
+	private:
+		// Get the handles of the metaindex and index blocks
+		std::ptrdiff_t footer(VectorView<uint8_t> data, BlockHandle & metaindex, BlockHandle & index);
+		// Visit each data block in the index with the keys bounding it
+		std::ptrdiff_t index(VectorView<uint8_t> data, const std::function<void(const VectorData &, const VectorData &, const BlockHandle &)> & visit);
 	};
 
 	class LogReader : public Reader
 	{
 	public:
 		using Reader::parse;
-		std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &)> visit);
+		// Visit all entries with the type of each, which is 0 for deleted
+		// keys and 1 for values
+		std::ptrdiff_t entries(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &, uint8_t)> visit);
+
+	protected:
+		// Visit all records, with fragmented records put together
+		std::ptrdiff_t parseRecords(VectorView<uint8_t> data, const std::function<std::ptrdiff_t(const VectorData &)> & visit);
+
+	private:
+		// Visit all entries of a write batch
+		std::ptrdiff_t parseBatch(const VectorData & batch, const std::function<void(const VectorData &, const VectorData &, uint8_t)> & visit);
+	};
+
+	// Manifests are logs of edits to the set of live files
+	class ManifestReader : private LogReader
+	{
+	public:
+		using LogReader::getError;
+
+		// Apply all edits to the version
+		std::ptrdiff_t parse(std::vector<uint8_t> & data, Version & version);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, Version & version);
+
+	private:
+		std::ptrdiff_t parseEdit(const VectorData & edit, std::map<uint64_t, Version::File> & files, Version & version);
 	};
 
 } // namespace LevelDB
@@ -3,19 +3,19 @@
 #define NBT_HPP
 
 #include "vectorview.hpp"
+#include "format/nbtnames.hpp"
 
 #include <vector>
 #include <string>
-#include <memory>
 #include <iostream>
 #include <functional>
 #include <variant>
+#include <limits>
+#include <initializer_list>
 
 // Experimental features
 #define USE_STRING_VIEW
 #define USE_VECTOR_VIEW
-#define USE_VARIANT
-#define USE_SMART_ALLOCATION
 
 namespace NBT
 {
@@ -62,10 +62,16 @@ namespace NBT
 	using NBTLongArray = NBTArray<int64_t>;
 
 	// A value of a tag
+	// Note: Arrays refers to the parsed data, and are transformed in place
+	// the first time they are retrieved
 	class Value
 	{
 	public:
 		Value(Endianess _endian) : endian(_endian) {}
+		// Copies refer to the same data, so it is transformed before copying
+		Value(const Value & other);
+		Value & operator=(const Value & other);
+
 		// Getting value
 		template<typename T>
 		operator T() const { return get<T>(); }
@@ -89,11 +95,7 @@ namespace NBT
 		const T & get() const
 		{
 			transform();
-			#ifdef USE_VARIANT
-			return std::get<T>(*value);
-			#else
-			return *reinterpret_cast<T *>(value.get());
-			#endif
+			return std::get<T>(value);
 		}
 
 		// List size
@@ -107,7 +109,6 @@ namespace NBT
 		inline bool operator==(Type t) const { return type() == t; }
 
 	private:
-		#ifdef USE_VARIANT
 		using NBTType = std::variant<
 			int8_t,
 			int16_t,
@@ -119,32 +120,16 @@ namespace NBT
 			NBTByteArray,
 			NBTIntArray,
 			NBTLongArray>;
-		std::shared_ptr<NBTType> value;
-		#else
-		std::shared_ptr<void> value;
-		#endif
+		NBTType value;
 		Type _type = TAG_End;
 		Endianess endian;
-		std::shared_ptr<bool> _transformed = std::make_shared<bool>(false);
+		mutable bool _transformed = false;
 
 		template<typename T>
 		void store(T v)
 		{
-			#ifdef USE_SMART_ALLOCATION
-			if (value.get())
-				*value = v;
-			else
-			#endif
-			#ifdef USE_VARIANT
-			value = std::make_shared<NBTType>(v);
-			#else
-			value = std::make_shared<T>(v);
-			#endif
-			#ifdef USE_SMART_ALLOCATION
-			*_transformed = false;
-			#else
-			_transformed = std::make_shared<bool>(false);
-			#endif
+			value = v;
+			_transformed = false;
 		}
 		// Convert to correct endianess
 		void transform() const;
@@ -167,8 +152,22 @@ namespace NBT
 		bool isName(const NBTString & str) const;
 		bool isName(const char * str) const;
 
+		// Identifier of the name, for switching on known names
+		Id id() const
+		{
+			if (!_identified)
+			{
+				_id = identify(name);
+				_identified = true;
+			}
+			return _id;
+		}
+
 	private:
 		NBTString name;
+		// Identifier is found once when requested
+		mutable Id _id = Id::UNKNOWN;
+		mutable bool _identified = false;
 	};
 
 	// Easier output for tag objects
@@ -206,6 +205,86 @@ namespace NBT
 		virtual bool visit(const Tag &) = 0;
 	};
 
+	// What to do with a scanned tag
+	enum class Scan : uint8_t
+	{
+		SKIP, // Continue past the tag
+		ENTER, // Continue into the compound
+		STOP, // Stop scanning
+	};
+
+	// Paths to read, compiled into a tree matched while parsing
+	// Names are separated by '.', "[]" marks a list where the rest of the path
+	// applies to each element, and "{a,b}" reads several names at the same place
+	// Note: A path ending on a structure reads all of it
+	class Query
+	{
+	public:
+		Query(std::initializer_list<std::string_view> paths);
+
+		// Node of the root compound
+		static constexpr std::size_t ROOT = 0;
+		// Node where nothing matches
+		static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+		// Node where everything matches
+		static constexpr std::size_t ALL = NONE - 1;
+
+		// Match the name of a tag within a node, returning the node for its content
+		std::size_t match(std::size_t node, const NBTString & name) const;
+		// Amount of names to read within a node
+		std::size_t size(std::size_t node) const;
+
+	private:
+		struct Node
+		{
+			std::string name;
+			std::vector<std::size_t> children;
+			bool leaf = false;
+		};
+		std::vector<Node> nodes;
+
+		// Add a path
+		void add(std::string_view path);
+		// Get the node of a name within a node, adding it if missing
+		std::size_t insert(std::size_t node, std::string_view name);
+	};
+
+	// Location of a tag within the data
+	struct IndexEntry
+	{
+		uint32_t offset; // Start of the tag, at its type
+		uint32_t length; // Size of the whole tag, including type and name
+		uint32_t parent; // Entry of the compound it is within
+		uint16_t name_length;
+		Type type;
+	};
+
+	/*
+	 * Locations of the tags within compounds, built in one pass without
+	 * reading any values. Lists are indexed as a whole, without their elements.
+	 * As only offsets are stored, it can be cached together with the data.
+	 */
+	class Index
+	{
+	public:
+		// Parent of tags directly within the root
+		static constexpr uint32_t ROOT = std::numeric_limits<uint32_t>::max();
+
+		// Find a tag by its path within the root, with compounds separated by dots
+		const IndexEntry * find(std::vector<uint8_t> & data, std::string_view path) const
+		{
+			return find(VectorView<uint8_t>{data.data(), data.size()}, path);
+		}
+		const IndexEntry * find(VectorView<uint8_t> data, std::string_view path) const;
+
+		const std::vector<IndexEntry> & entries() const { return items; }
+		void clear() { items.clear(); }
+
+	private:
+		friend class Reader;
+		std::vector<IndexEntry> items;
+	};
+
 	// Reads all content for NBT
 	class Reader
 	{
@@ -214,10 +293,39 @@ namespace NBT
 		std::ptrdiff_t parse(std::vector<uint8_t> & data, Visitor & visitor, Endianess endian);
 		std::ptrdiff_t parse(VectorView<uint8_t> data, Visitor & visitor, Endianess endian);
 
+		// Parse the data with the byte order and the visitor resolved at compile time
+		// Note: Defined in format/nbtparser.hpp
+		template<Endianess E, class V>
+		std::ptrdiff_t parse(std::vector<uint8_t> & data, V & visitor)
+		{
+			return parse<E>(VectorView<uint8_t>{data.data(), data.size()}, visitor);
+		}
+		template<Endianess E, class V>
+		std::ptrdiff_t parse(VectorView<uint8_t> data, V & visitor);
+
 		// Parse the data with a pair of functions
 		std::ptrdiff_t parse(std::vector<uint8_t> & data, std::function<bool(const Tag &)> tag, std::function<bool(const Value &)> value, Endianess endian);
 		std::ptrdiff_t parse(VectorView<uint8_t> data, std::function<bool(const Tag &)> tag, std::function<bool(const Value &)> value, Endianess endian);
 
+		// Parse the data with a visitor, only reading what matches the query
+		// Note: Stops when all names within the root have been read
+		std::ptrdiff_t parse(std::vector<uint8_t> & data, const Query & query, Visitor & visitor, Endianess endian);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, const Query & query, Visitor & visitor, Endianess endian);
+
+		// Index the tags of the compounds, skipping past their values
+		std::ptrdiff_t index(std::vector<uint8_t> & data, Index & index, Endianess endian);
+		std::ptrdiff_t index(VectorView<uint8_t> data, Index & index, Endianess endian);
+
+		// Parse a single indexed tag with everything within it
+		// Note: Returns where the tag ends
+		std::ptrdiff_t parse(std::vector<uint8_t> & data, const IndexEntry & entry, Visitor & visitor, Endianess endian);
+		std::ptrdiff_t parse(VectorView<uint8_t> data, const IndexEntry & entry, Visitor & visitor, Endianess endian);
+
+		// Scan tags of entered compounds, skipping past everything else without reading it
+		// Note: Lists are never entered, and stopping returns where it stopped
+		std::ptrdiff_t scan(std::vector<uint8_t> & data, std::function<Scan(const Tag &)> tag, Endianess endian);
+		std::ptrdiff_t scan(VectorView<uint8_t> data, std::function<Scan(const Tag &)> tag, Endianess endian);
+
 		// Get previous error as a string
 		const std::string & getError() const { return error; }
 
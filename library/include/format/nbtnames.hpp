@@ -0,0 +1,129 @@
+#pragma once
+#ifndef NBTNAMES_HPP
+#define NBTNAMES_HPP
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+/*
+ * Tag names known to the visitors, identified by a perfect hash built at
+ * compile time, so visitors can switch on them instead of comparing strings
+ * Note: Add new names to the end of the list
+ */
+#define NBT_NAMES(X) \
+	X(Level) \
+	X(V) \
+	X(DataVersion) \
+	X(xPos) \
+	X(yPos) \
+	X(zPos) \
+	X(Sections) \
+	X(sections) \
+	X(Y) \
+	X(BlockLight) \
+	X(SkyLight) \
+	X(Blocks) \
+	X(Add) \
+	X(Data) \
+	X(HeightMap) \
+	X(Heightmaps) \
+	X(WORLD_SURFACE) \
+	X(Palette) \
+	X(palette) \
+	X(Name) \
+	X(name) \
+	X(Properties) \
+	X(BlockStates) \
+	X(block_states) \
+	X(data) \
+	X(biomes) \
+	X(Entities) \
+	X(TileEntities) \
+	X(TileTicks) \
+	X(PostProcessing) \
+	X(Structures) \
+	X(structures) \
+	X(CarvingMasks) \
+	X(Lights) \
+	X(blending_data) \
+	X(block_entities) \
+	X(block_ticks) \
+	X(fluid_ticks)
+
+namespace NBT
+{
+
+	// Identifier of a tag name
+	enum class Id : uint8_t
+	{
+		UNKNOWN, // Not a known name
+		EMPTY, // Root and end tags
+		#define NBT_NAME_ID(name) name,
+		NBT_NAMES(NBT_NAME_ID)
+		#undef NBT_NAME_ID
+	};
+
+	namespace names
+	{
+		// Names of each identifier
+		constexpr std::string_view strings[] = {
+			"",
+			"",
+			#define NBT_NAME_STRING(name) #name,
+			NBT_NAMES(NBT_NAME_STRING)
+			#undef NBT_NAME_STRING
+		};
+		constexpr std::size_t COUNT = sizeof(strings) / sizeof(strings[0]);
+		static_assert(COUNT < 256, "Identifiers are stored as bytes");
+
+		// Slots of the hash table, kept sparse to quickly find a seed
+		constexpr std::size_t SLOTS = 512;
+
+		// FNV-1a with a seed
+		constexpr uint32_t hash(uint32_t seed, std::string_view str)
+		{
+			uint32_t h = 2166136261u ^ seed;
+			for (auto c : str)
+				h = (h ^ uint8_t(c)) * 16777619u;
+			return h;
+		}
+
+		struct Table
+		{
+			uint32_t seed = 0;
+			std::array<uint8_t, SLOTS> slots{};
+		};
+
+		// Find a seed where no names share a slot
+		constexpr Table build()
+		{
+			for (uint32_t seed = 0;; ++seed)
+			{
+				Table table;
+				table.seed = seed;
+				bool collision = false;
+				for (std::size_t i = std::size_t(Id::EMPTY); i < COUNT && !collision; ++i)
+				{
+					auto & slot = table.slots[hash(seed, strings[i]) % SLOTS];
+					collision = slot != 0;
+					slot = uint8_t(i);
+				}
+				if (!collision)
+					return table;
+			}
+		}
+
+		constexpr Table table = build();
+	} // namespace names
+
+	// Identify a name, which is UNKNOWN for names not in the list
+	constexpr Id identify(std::string_view name)
+	{
+		auto i = names::table.slots[names::hash(names::table.seed, name) % names::SLOTS];
+		return i != 0 && names::strings[i] == name ? Id(i) : Id::UNKNOWN;
+	}
+
+} // namespace NBT
+
+#endif // NBTNAMES_HPP
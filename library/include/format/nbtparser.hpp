@@ -0,0 +1,487 @@
+#pragma once
+#ifndef NBTPARSER_HPP
+#define NBTPARSER_HPP
+
+#include "format/nbt.hpp"
+#include "util/endianess.hpp"
+
+#include <array>
+#include <string>
+
+namespace NBT
+{
+
+/*
+ * Reading of the raw data, with the byte order resolved at compile time
+ */
+namespace detail
+{
+	typedef int UndefinedType;
+	typedef uint8_t ItType;
+
+	// Deepest nesting allowed by Minecraft
+	constexpr std::size_t MAX_DEPTH = 512;
+
+	// Stack with a fixed capacity, so parsing does not allocate
+	template<typename T, std::size_t N = MAX_DEPTH>
+	class Stack
+	{
+	public:
+		bool empty() const { return count == 0; }
+		bool full() const { return count == N; }
+		std::size_t size() const { return count; }
+		T & top() { return items[count - 1]; }
+		// Returns false when full
+		bool push(const T & item)
+		{
+			if (full())
+				return false;
+			items[count++] = item;
+			return true;
+		}
+		void pop()
+		{
+			if (count > 0)
+				--count;
+		}
+
+	private:
+		std::array<T, N> items;
+		std::size_t count = 0;
+	};
+
+	// Read a type
+	inline UndefinedType read_type(ItType *& ptr)
+	{
+		return static_cast<UndefinedType>(static_cast<int8_t>(*ptr++));
+	}
+
+	// Read a number
+	template<Endianess E, typename T, uint32_t bytes = sizeof(T)>
+	inline T read_number(ItType *& ptr)
+	{
+		T value{};
+		if constexpr (E == Endianess::BIG)
+			value = endianess::fromBig<T, ItType *, bytes>(ptr);
+		else
+			value = endianess::fromLittle<T, ItType *, bytes>(ptr);
+		ptr += bytes;
+		return value;
+	}
+
+	// Read a string
+	template<Endianess E>
+	inline NBTString read_string(ItType *& ptr)
+	{
+		auto len = static_cast<std::size_t>(read_number<E, uint16_t>(ptr));
+		NBTString name(reinterpret_cast<const char *>(ptr), len);
+		ptr += len;
+		return name;
+	}
+
+	// Read a list
+	template<Endianess E, typename T>
+	inline NBTArray<T> read_list(ItType *& ptr)
+	{
+		auto len = static_cast<std::size_t>(read_number<E, int32_t>(ptr));
+		auto p = reinterpret_cast<T *>(ptr);
+		NBTArray<T> values(p, p + len);
+		ptr += sizeof(T) * len;
+		return values;
+	}
+
+	// Skip a string
+	template<Endianess E>
+	inline void skip_string(ItType *& ptr)
+	{
+		ptr += read_number<E, int16_t>(ptr);
+	}
+
+	// Skip a list
+	template<Endianess E, typename T>
+	inline void skip_list(ItType *& ptr)
+	{
+		ptr += sizeof(T) * static_cast<std::size_t>(read_number<E, int32_t>(ptr));
+	}
+
+	// Read a value
+	template<Endianess E, class S>
+	bool read_value(ItType *& ptr, UndefinedType type, Value & value, S & stack)
+	{
+		switch (type)
+		{
+		case TAG_End:
+			value.set();
+			stack.pop();
+			break;
+		case TAG_Byte:
+			value.set(read_number<E, int8_t>(ptr));
+			break;
+		case TAG_Short:
+			value.set(read_number<E, int16_t>(ptr));
+			break;
+		case TAG_Int:
+			value.set(read_number<E, int32_t>(ptr));
+			break;
+		case TAG_Long:
+			value.set(read_number<E, int64_t>(ptr));
+			break;
+		case TAG_Float:
+			value.set(read_number<E, float>(ptr));
+			break;
+		case TAG_Double:
+			value.set(read_number<E, double>(ptr));
+			break;
+		case TAG_Byte_Array:
+			value.set(read_list<E, int8_t>(ptr));
+			break;
+		case TAG_String:
+			value.set(read_string<E>(ptr));
+			break;
+		case TAG_List:
+			{
+				auto tag_type = read_type(ptr);
+				auto count = read_number<E, int32_t>(ptr);
+				value.set(TAG_List, count);
+				// Only add for list with actual values
+				if (count > 0 && !stack.push({ tag_type, count }))
+					return false;
+			}
+			break;
+		case TAG_Compound:
+			value.set(TAG_Compound, 0);
+			if (!stack.push({ TAG_Compound, -1 }))
+				return false;
+			break;
+		case TAG_Int_Array:
+			value.set(read_list<E, int32_t>(ptr));
+			break;
+		case TAG_Long_Array:
+			value.set(read_list<E, int64_t>(ptr));
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+
+	// Read a tag
+	template<Endianess E, class S>
+	bool read_tag(ItType *& ptr, UndefinedType type, Tag & tag, S & stack)
+	{
+		// Special handling for end tag
+		if (type != TAG_End)
+			tag.setName(read_string<E>(ptr));
+		else
+			tag.setName(NBTString());
+
+		return read_value<E>(ptr, type, tag, stack);
+	}
+
+	// Skip a value
+	template<Endianess E, class S>
+	bool skip_value(ItType *& ptr, UndefinedType type, S & stack)
+	{
+		switch (type)
+		{
+		case TAG_End:
+			stack.pop();
+			break;
+		case TAG_Byte:
+			ptr += sizeof(int8_t);
+			break;
+		case TAG_Short:
+			ptr += sizeof(int16_t);
+			break;
+		case TAG_Int:
+			ptr += sizeof(int32_t);
+			break;
+		case TAG_Long:
+			ptr += sizeof(int64_t);
+			break;
+		case TAG_Float:
+			ptr += sizeof(float);
+			break;
+		case TAG_Double:
+			ptr += sizeof(double);
+			break;
+		case TAG_Byte_Array:
+			skip_list<E, int8_t>(ptr);
+			break;
+		case TAG_String:
+			skip_string<E>(ptr);
+			break;
+		case TAG_List:
+			{
+				auto tag_type = read_type(ptr);
+				// Optimization for primitives
+				switch (tag_type)
+				{
+				case TAG_Byte:
+					skip_list<E, int8_t>(ptr);
+					break;
+				case TAG_Short:
+					skip_list<E, int16_t>(ptr);
+					break;
+				case TAG_Int:
+					skip_list<E, int32_t>(ptr);
+					break;
+				case TAG_Long:
+					skip_list<E, int64_t>(ptr);
+					break;
+				case TAG_Float:
+					skip_list<E, float>(ptr);
+					break;
+				case TAG_Double:
+					skip_list<E, double>(ptr);
+					break;
+				case TAG_Byte_Array:
+				case TAG_String:
+				case TAG_List:
+				case TAG_Compound:
+				case TAG_Int_Array:
+				case TAG_Long_Array:
+				case TAG_End:
+					{
+						auto count = read_number<E, int32_t>(ptr);
+						// Only add for list with actual values
+						if (count > 0 && !stack.push({ tag_type, count }))
+							return false;
+					}
+					break;
+				default:
+					return false;
+				}
+			}
+			break;
+		case TAG_Compound:
+			if (!stack.push({ TAG_Compound, -1 }))
+				return false;
+			break;
+		case TAG_Int_Array:
+			skip_list<E, int32_t>(ptr);
+			break;
+		case TAG_Long_Array:
+			skip_list<E, int64_t>(ptr);
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+} // namespace detail
+
+/*
+ * Parser with the byte order and the visitor resolved at compile time
+ * The visitor only needs the visit functions of Visitor, which are called
+ * directly when it is a concrete type.
+ */
+template<Endianess E, class V>
+class Parser
+{
+public:
+	Parser(V & _visitor) : visitor(_visitor) {}
+
+	// Parse the data, returning how much was read, or negative on error
+	std::ptrdiff_t parse(VectorView<uint8_t> data);
+
+	// Get previous error as a string
+	const std::string & getError() const { return error; }
+
+private:
+	V & visitor;
+	std::string error;
+
+	std::ptrdiff_t throwError(const std::string & err)
+	{
+		error = err;
+		return -1;
+	}
+};
+
+template<Endianess E, class V>
+std::ptrdiff_t Parser<E, V>::parse(VectorView<uint8_t> data)
+{
+	using namespace detail;
+	ItType * ptr = data.data();
+	Tag tag(E);
+	Value value(E);
+	bool skip_tag = false;
+	size_t skip_depth = 0;
+
+	struct StackData
+	{
+		UndefinedType tag;
+		int32_t list_size; // Negative value is a compound
+	};
+	Stack<StackData> stack;
+
+	// Failing to read a value may also be from nesting too deep
+	auto invalid = [this, &stack]()
+	{
+		return throwError(stack.full() ? "Too deep nesting" : "Invalid type found");
+	};
+
+	UndefinedType type;
+
+	// Read first element
+	if (data.empty())
+		return throwError("Invalid start of stream");
+	type = read_type(ptr);
+	if (type != TAG_Compound)
+		return throwError("Invalid start of stream");
+	tag.setName(read_string<E>(ptr));
+	if (!read_value<E>(ptr, type, tag, stack))
+		return invalid();
+	skip_tag = visitor.visit(tag);
+
+	while (ptr < data.data() + data.size() && !stack.empty())
+	{
+		// List
+		if (!stack.empty() && stack.top().list_size > 0)
+		{
+			type = stack.top().tag;
+
+			// Primitives in lists
+			if (type != TAG_Compound)
+				--stack.top().list_size;
+
+			if (skip_tag && skip_depth <= stack.size())
+			{
+				if (!skip_value<E>(ptr, type, stack))
+					return invalid();
+			}
+			else
+			{
+				skip_tag = false;
+				skip_depth = 0;
+
+				if (!read_value<E>(ptr, type, value, stack))
+					return invalid();
+
+				try
+				{
+					skip_tag = visitor.visit(value);
+				}
+				catch (std::bad_variant_access & e)
+				{
+					return throwError("Invalid value of list with type " + std::to_string(int32_t(value.type())));
+				}
+
+				if (skip_tag)
+				{
+					switch (type)
+					{
+					case TAG_List:
+						if (tag.count() == 0)
+						{
+							stack.pop();
+							skip_tag = false;
+							skip_depth = 0;
+							break;
+						}
+						[[fallthrough]];
+					case TAG_Compound:
+						skip_depth = stack.size();
+						break;
+					// May only be able to skip complex types
+					default:
+						skip_tag = false;
+						skip_depth = 0;
+						break;
+					}
+				}
+			}
+
+			// Primitives in lists
+			if (type != TAG_Compound)
+			{
+				// End of list
+				if (stack.top().list_size == 0)
+					stack.pop();
+			}
+		}
+		// Compound
+		else
+		{
+			type = read_type(ptr);
+
+			if (skip_tag && skip_depth <= stack.size())
+			{
+				if (type != TAG_End)
+					skip_string<E>(ptr);
+				if (!skip_value<E>(ptr, type, stack))
+					return invalid();
+			}
+			else
+			{
+				if (!read_tag<E>(ptr, type, tag, stack))
+					return invalid();
+
+				skip_tag = false;
+				skip_depth = 0;
+
+				try
+				{
+					skip_tag = visitor.visit(tag);
+				}
+				catch (std::bad_variant_access & e)
+				{
+					return throwError("Invalid type for " + std::string(tag.getName()));
+				}
+
+				if (skip_tag)
+				{
+					switch (type)
+					{
+					case TAG_List:
+						if (tag.count() == 0)
+						{
+							skip_tag = false;
+							skip_depth = 0;
+							break;
+						}
+						[[fallthrough]];
+					case TAG_Compound:
+						skip_depth = stack.size();
+						break;
+						// May only be able to skip complex types
+					default:
+						skip_depth = 0;
+						skip_tag = false;
+						break;
+					}
+				}
+			}
+
+			// Handle lists
+			if (type == TAG_End && !stack.empty() && stack.top().list_size > 0)
+			{
+				--stack.top().list_size;
+
+				// End of list
+				if (stack.top().list_size == 0)
+					stack.pop();
+			}
+		}
+	}
+
+	if (!stack.empty())
+		return throwError("Reached end of stream");
+
+	return std::distance(data.data(), ptr);
+}
+
+template<Endianess E, class V>
+std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, V & visitor)
+{
+	Parser<E, V> parser(visitor);
+	auto ret = parser.parse(data);
+	if (ret < 0)
+		error = parser.getError();
+	return ret;
+}
+
+} // namespace NBT
+
+#endif // NBTPARSER_HPP
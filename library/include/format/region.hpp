@@ -8,6 +8,8 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#include <tuple>
+#include <string_view>
 #include <memory>
 #include <iterator>
 
@@ -22,6 +24,16 @@ namespace region
 
 	using VectorData = VectorView<const uint8_t>;
 
+	/**
+	 * @brief Parse the name of a region file
+	 * @param name The file name, as r.<x>.<z>.<extension>
+	 * @param type The type of region decides the extension
+	 * @param x The x position of the region
+	 * @param z The z position of the region
+	 * @return True if a valid region file name, false otherwise
+	 */
+	bool parseFileName(std::string_view name, RegionType type, int & x, int & z);
+
 	/**
 	 * Data for a chunk to be used outside
 	 */
@@ -48,10 +60,79 @@ namespace region
 		int32_t xPos, zPos;
 		CompressionType compression_type = COMPRESSION_UNKNOWN;
 		VectorData data;
+		// Keeps data alive when not viewing a loaded region
+		std::shared_ptr<void> storage;
 	};
 
 	class RegionChunk;
 
+	// Name of the index file, kept with the output of a render
+	constexpr const char * INDEX_FILE = ".pixelmap-index";
+
+	/**
+	 * @brief Get the index file kept with the output of a render
+	 * @param output The output of the render
+	 * @param folder True if the output is a folder, otherwise the index is
+	 * kept next to the output file
+	 * @return The path of the index file
+	 */
+	std::string getIndexFile(const std::string & output, bool folder);
+
+	/**
+	 * Persistent index of all region headers in a folder
+	 * Note: Headers of other folders in the same file are kept, so one file
+	 * may serve every dimension of a world
+	 */
+	class RegionIndex
+	{
+	public:
+		/**
+		 * Header of a region file, valid for a specific file size and time
+		 */
+		struct Entry
+		{
+			struct Chunk
+			{
+				uint16_t i;
+				uint32_t location;
+				int32_t timestamp;
+			};
+			uint64_t size = 0;
+			int64_t modified = 0;
+			std::vector<Chunk> chunks;
+		};
+
+		/**
+		 * @brief Constructor
+		 * @param file The file to store the index in, empty to not store it
+		 * @param source The folder of the regions, as an entry is only valid for it
+		 * @param writable Whether to save the index, otherwise it is only read
+		 */
+		RegionIndex(const std::string & file, const std::string & source, bool writable = true) noexcept;
+
+		// Load index from file
+		bool load();
+		// Save index to file, if changed
+		bool save();
+
+		// Get entry of region, if still valid
+		const Entry * find(RegionType type, int x, int z, uint64_t size, int64_t modified) const;
+		// Replace entry of region
+		void update(RegionType type, int x, int z, Entry && entry);
+		// Remove entries of regions no longer existing
+		// Note: Existing regions are expected to be sorted
+		void retain(RegionType type, const std::vector<std::pair<int, int>> & existing);
+
+	private:
+		typedef std::tuple<RegionType, int, int> Key;
+		std::string file;
+		std::string source;
+		std::map<std::string, std::map<Key, Entry>> folders;
+		bool writable;
+		bool loaded = false;
+		bool dirty = false;
+	};
+
 	/**
 	 * Handles a specific region data
 	 */
@@ -108,12 +189,20 @@ namespace region
 		int getChunkTimestamp(int x, int z);
 		// Get a chunk from position
 		std::shared_ptr<ChunkData> getChunk(int x, int z);
+		// Get several chunks from positions, reading only their sectors
+		// Note: Chunks not found are left empty
+		std::vector<std::shared_ptr<ChunkData>> getChunks(const std::vector<std::pair<int, int>> & positions);
 		bool containsChunk(int x, int z) const;
 
 		// Iterate through each chunk
 		iterator begin();
 		iterator end();
 
+		// Load header from index
+		void loadHeader(const RegionIndex::Entry & entry);
+		// Store header for index
+		RegionIndex::Entry storeHeader() const;
+
 		inline int x() const { return rx; }
 		inline int z() const { return rz; }
 		inline int getAmountChunks() const { return amount_chunks; }
@@ -122,13 +211,19 @@ namespace region
 		int rx, rz;
 		RegionType type;
 		int amount_chunks = 0;
+		bool header_loaded = false;
+		// File size and modified time the header was loaded from
+		uint64_t header_size = 0;
+		int64_t header_modified = 0;
 		Headers headers;
-		std::vector<uint8_t> cache;
+		VectorData cache;
 		std::string path;
 		std::vector<std::shared_ptr<RegionChunk>> external_chunks;
 
 		bool loadHeader();
 		std::shared_ptr<ChunkData> getChunk(const Header & header);
+		// Read a chunk from the sectors starting at its offset
+		std::shared_ptr<ChunkData> readChunk(const Header & header, VectorData sectors);
 
 		void preloadCache();
 	};
@@ -161,8 +256,10 @@ namespace region
 	 */
 	class Region
 	{
-		typedef std::map<std::pair<int, int>, std::shared_ptr<RegionFile>> RegionsMap;
 	public:
+		// Note: A map keeps regions valid while others are added
+		typedef std::map<std::pair<int, int>, std::shared_ptr<RegionFile>> RegionsMap;
+
 		/**
 		 * Iterates through all regions
 		 */
@@ -217,12 +314,23 @@ namespace region
 			void ensureValidIterator();
 		};
 
-		explicit Region(const std::string & path, RegionType type = RegionType::ANVIL) noexcept;
+		/**
+		 * @brief Constructor
+		 * @param path The folder of the regions
+		 * @param type The type of regions
+		 * @param index The file to keep the headers in between runs, empty to not keep them
+		 * @param writable Whether to update the index file, otherwise it is only read
+		 * Note: The index is kept outside of the world, as it should not be modified
+		 */
+		explicit Region(const std::string & path, RegionType type = RegionType::ANVIL, const std::string & index = {}, bool writable = true) noexcept;
 
 		// Get timestamp of chunk
 		int getChunkTimestamp(int x, int z);
 		// Get chunk from coordinates
 		std::shared_ptr<ChunkData> getChunk(int x, int z);
+		// Get chunks from coordinates, in the same order
+		// Note: Chunks not found are left empty
+		std::vector<std::shared_ptr<ChunkData>> getChunks(const std::vector<std::pair<int, int>> & positions);
 
 		// Iterate through each region
 		// Note: This is recommended for scalable applications
@@ -238,10 +346,12 @@ namespace region
 		RegionType type;
 		RegionsMap regions;
 		RegionsMap::iterator region_it;
+		RegionIndex index;
 
 		friend iterator;
 
 		void populateFromPath();
+		RegionsMap::iterator findRegion(int x, int z);
 	};
 
 } // namespace region
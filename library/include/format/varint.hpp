@@ -29,6 +29,9 @@ void skip_varint(const uint8_t *& ptr);
 template<typename T>
 T read_varint(const uint8_t *& ptr)
 {
+	// Most values are small enough for a single byte
+	if ((*ptr & 128) == 0)
+		return T(*ptr++);
 	T v = 0;
 	// Try to avoid undefined behavior
 	auto size = sizeof(T) * 8;
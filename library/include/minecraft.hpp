@@ -92,9 +92,10 @@ namespace Minecraft
 		/**
 		 * @brief Get info about a path
 		 * @param path The path to the world
+		 * @param index The index file of a render to read region headers from, empty to read all of them
 		 * @return The info containing the information about the world
 		 */
-		std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path);
+		std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path, const std::string & index = {});
 	}
 
 	namespace BE
@@ -142,9 +143,10 @@ namespace Minecraft
 	/**
 	 * @brief Get info about a path
 	 * @param path The path to the world
+	 * @param index The index file of a render to read region headers from, empty to read all of them
 	 * @return The info containing the information about the world
 	 */
-	std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path);
+	std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path, const std::string & index = {});
 
 	/**
 	 * @brief Get the path Game version
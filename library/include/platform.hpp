@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <cstdint>
+#include <cstddef>
 
 #if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
 	#include <unistd.h>
@@ -106,18 +108,102 @@ namespace platform
 		std::size_t max();
 	}
 
+	/**
+	 * @brief File namespace
+	 * Handles files with positional reads, so several threads can read
+	 * from the same file at the same time.
+	 */
+	namespace file
+	{
+		/**
+		 * Native handle of an open file
+		 */
+		using Handle = std::intptr_t;
+		constexpr Handle INVALID_HANDLE = -1;
+
+		/**
+		 * @brief Open a file for reading
+		 * @param file The file to open
+		 * @return A handle to the file, INVALID_HANDLE if error
+		 */
+		Handle open(const std::string & file);
+
+		/**
+		 * @brief Check if the last failed open ran out of handles
+		 * Note: Only valid directly after open
+		 * @return True if too many files are open, false otherwise
+		 */
+		bool tooManyOpen();
+
+		/**
+		 * @brief Close a file
+		 * @param handle The handle to close
+		 */
+		void close(Handle handle);
+
+		/**
+		 * @brief Get the size of a file
+		 * @param handle The handle of the file
+		 * @return The size of the file
+		 */
+		uint64_t size(Handle handle);
+
+		/**
+		 * @brief Get the size and modified time of a file
+		 * @param handle The handle of the file
+		 * @param size The size of the file
+		 * @param modified The modified time of the file, in a platform specific unit
+		 * @return True on success, false otherwise or if the file has been removed
+		 */
+		bool stat(Handle handle, uint64_t & size, int64_t & modified);
+
+		/**
+		 * @brief Read from a specific offset of a file
+		 * @param handle The handle of the file
+		 * @param out Where to store the read data
+		 * @param size The amount of bytes to read
+		 * @param offset The offset to read from
+		 * @return The amount of bytes read, negative if error
+		 */
+		std::ptrdiff_t read(Handle handle, void * out, std::size_t size, uint64_t offset);
+	}
+
 	/**
 	 * @brief Memory map namespace
 	 * Handles file mapped memory.
 	 */
 	namespace mmap
 	{
+		/**
+		 * @brief Expected access pattern of mapped memory
+		 */
+		enum class Advice
+		{
+			NORMAL,
+			SEQUENTIAL,
+			RANDOM,
+			WILLNEED,
+			DONTNEED
+		};
+
 		/**
 		 * @brief Load the file to memory
-		 * @param file The file to load
+		 * The mapping is private, so any writes are never reflected
+		 * back to the file. The mapping stays valid after the file is
+		 * closed.
+		 * @param handle The handle of the file to load
+		 * @param size The size of the mapped memory
 		 * @return Valid pointer for success, NULL if error
 		 */
-		std::shared_ptr<void> load(const std::string & file);
+		std::shared_ptr<void> load(file::Handle handle, std::size_t & size);
+
+		/**
+		 * @brief Advise the system on how mapped memory will be accessed
+		 * @param ptr The mapped memory
+		 * @param size The size of the memory
+		 * @param advice The expected access pattern
+		 */
+		void advise(void * ptr, std::size_t size, Advice advice);
 	}
 
 } // platform
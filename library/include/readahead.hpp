@@ -0,0 +1,80 @@
+#pragma once
+#ifndef READAHEAD_HPP
+#define READAHEAD_HPP
+
+#include "sharedfile.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <unordered_map>
+#include <memory>
+
+/**
+ * @brief Loads files ahead of time
+ * Files are loaded on a separate thread in the order they were added,
+ * keeping at most a certain amount of files loaded and not yet released.
+ * This lets workers parse the current files while the next ones are being
+ * read from disk.
+ */
+class ReadAhead
+{
+	enum class State
+	{
+		QUEUED,
+		LOADING,
+		LOADED,
+		TAKEN
+	};
+public:
+	/**
+	 * @brief Constructor
+	 * @param depth Amount of files to load ahead, 0 disables it
+	 */
+	explicit ReadAhead(std::size_t depth);
+	~ReadAhead();
+
+	/**
+	 * @brief Add a file to be loaded ahead
+	 * @param file The file to load
+	 */
+	void enqueue(std::shared_ptr<SharedFile> file);
+
+	/**
+	 * @brief Acquire a file before using it
+	 * Waits if the file is currently being loaded. If the loading has not
+	 * yet started, it is left to the caller to load the file.
+	 * @param file The file to acquire
+	 */
+	void acquire(const std::shared_ptr<SharedFile> & file);
+
+	/**
+	 * @brief Release a file after using it
+	 * Frees a slot so the next file can be loaded.
+	 * @param file The file to release
+	 */
+	void release(const std::shared_ptr<SharedFile> & file);
+
+	/**
+	 * @brief Stop loading any more files
+	 * Files not yet released are forgotten, as their users may have been
+	 * cancelled. Files enqueued afterwards are loaded ahead again.
+	 */
+	void abort();
+
+private:
+	std::size_t depth;
+	std::size_t loaded = 0;
+	bool finish = false;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::queue<std::shared_ptr<SharedFile>> queue;
+	std::unordered_map<std::shared_ptr<SharedFile>, State> states;
+
+	void run();
+};
+
+#endif // READAHEAD_HPP
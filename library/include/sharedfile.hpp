@@ -2,8 +2,10 @@
 #ifndef SHARED_FILE_HPP
 #define SHARED_FILE_HPP
 
+#include "vectorview.hpp"
+
 #include <memory>
-#include <fstream>
+#include <string>
 #include <vector>
 
 #include <cstdint>
@@ -24,6 +26,8 @@ public:
 
 	/**
 	 * @brief Open a specific file
+	 * The file itself is borrowed from the file cache on each read, so
+	 * keeping a file open does not hold on to a file descriptor.
 	 * @param file The file to open
 	 * @return True on success, false otherwise
 	 */
@@ -52,23 +56,66 @@ public:
 	 */
 	std::vector<uint8_t> readAll();
 
+	/**
+	 * @brief Map the whole file into memory
+	 * The mapping stays valid after the file is closed, until unmapped.
+	 * Note: The file is expected to not shrink while mapped.
+	 * @return View of the file content, empty if not possible to map
+	 */
+	VectorView<uint8_t> map();
+
+	/**
+	 * @brief Release the mapped memory
+	 */
+	void unmap();
+
+	/**
+	 * @brief Load the whole file into memory
+	 * The file is mapped if possible, otherwise read into a buffer. The
+	 * content is kept until unloaded, so it is only loaded once.
+	 * @return View of the file content, empty on failure
+	 */
+	VectorView<uint8_t> load();
+
+	/**
+	 * @brief Release the loaded content
+	 */
+	void unload();
+
+	/**
+	 * @brief Get the owner of the loaded content
+	 * Views of the content stay valid while the owner is kept, even after
+	 * the file is unloaded.
+	 * @return Owner of the content, empty if not loaded
+	 */
+	std::shared_ptr<void> content() const;
+
 protected:
 
 	virtual bool read(uint8_t * out, std::size_t size);
+	void setFile(const std::string & file);
 	bool isOpen() const;
 	uint64_t size() const;
 	void seek(uint64_t offset);
 
 	void setError(const std::string & error);
 
+	bool ensureOpen();
+
 private:
-	std::shared_ptr<std::ifstream> _in;
+	// Map the file without recording an error on failure
+	VectorView<uint8_t> tryMap();
+
 	std::string _file;
+	bool _open = false;
+	uint64_t _offset = 0;
 
 	std::string _last_error;
-	std::size_t _size;
+	uint64_t _size = 0;
 
-	bool ensureOpen();
+	std::shared_ptr<void> _map;
+	std::size_t _map_size = 0;
+	std::shared_ptr<std::vector<uint8_t>> _buffer;
 };
 
 #endif // SHARED_FILE_HPP
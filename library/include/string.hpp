@@ -3,6 +3,7 @@
 #define STRING_HPP
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <algorithm>
 #include <cstdint>
@@ -68,6 +69,12 @@ public:
 		return s;
 	}
 
+	// Check if a string ends with a suffix
+	static inline bool endsWith(std::string_view s, std::string_view suffix)
+	{
+		return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+	}
+
 	// Check if a character is whitespace or null
 	static inline bool iswhite(int c)
 	{
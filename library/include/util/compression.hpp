@@ -12,6 +12,22 @@
 namespace Compression
 {
 
+// Libraries able to decompress zlib, zlib raw and gzip
+enum class Backend
+{
+	ZLIB,
+	LIBDEFLATE,
+	ZLIBNG
+};
+
+// Select backend for all threads, false if not built with it
+// Note: Defaults to the first built with of libdeflate, zlib-ng and zlib,
+// unless the environment variable PIXELMAP_DEFLATE names another
+bool setBackend(Backend backend);
+Backend getBackend();
+bool hasBackend(Backend backend);
+const char * getBackendName(Backend backend);
+
 std::vector<uint8_t> loadZLib(const std::vector<uint8_t> & compressed);
 std::vector<uint8_t> loadZLibRaw(const std::vector<uint8_t> & compressed);
 std::vector<uint8_t> loadGZip(const std::vector<uint8_t> & compressed);
@@ -19,8 +35,24 @@ std::vector<uint8_t> loadZLib(const VectorView<const uint8_t> & compressed);
 std::vector<uint8_t> loadZLibRaw(const VectorView<const uint8_t> & compressed);
 std::vector<uint8_t> loadGZip(const VectorView<const uint8_t> & compressed);
 
+// Decompress into a buffer, reusing its memory between calls
+// Hint is the expected decompressed size, used to size the buffer up front
+// Note: Decompressors are kept per thread, and data is empty on failure
+bool loadZLib(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint = 0);
+bool loadZLibRaw(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint = 0);
+bool loadGZip(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint = 0);
+
 std::vector<uint8_t> loadLZ4(const std::vector<uint8_t> & compressed);
 std::vector<uint8_t> loadLZ4(const VectorView<const uint8_t> & compressed);
+bool loadLZ4(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data);
+
+std::vector<uint8_t> loadSnappy(const std::vector<uint8_t> & compressed);
+std::vector<uint8_t> loadSnappy(const VectorView<const uint8_t> & compressed);
+bool loadSnappy(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data);
+
+std::vector<uint8_t> loadZstd(const std::vector<uint8_t> & compressed);
+std::vector<uint8_t> loadZstd(const VectorView<const uint8_t> & compressed);
+bool loadZstd(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint = 0);
 
 }
 
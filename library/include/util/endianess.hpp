@@ -6,6 +6,18 @@
 #include <cassert>
 #include <cstring>
 
+// Vector instructions for swapping arrays, as available to the compiler
+#if defined(__AVX2__)
+	#define ENDIANESS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ENDIANESS_SSE2
+	#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#define ENDIANESS_NEON
+	#include <arm_neon.h>
+#endif
+
 namespace endianess
 {
 	/*
@@ -183,6 +195,113 @@ namespace endianess
 	{
 		toLittle<T>(src, dst, bytes);
 	}
+
+	namespace internal
+	{
+		// Reverse the bytes of each value, one at a time
+		template<std::size_t bytes>
+		inline void swapScalar(uint8_t * data, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; ++i, data += bytes)
+				for (std::size_t j = 0; j < bytes / 2; ++j)
+				{
+					auto b = data[j];
+					data[j] = data[bytes - 1 - j];
+					data[bytes - 1 - j] = b;
+				}
+		}
+
+#ifdef ENDIANESS_SSE2
+		// Reverse the bytes of each value in 16 bytes
+		template<std::size_t bytes>
+		inline __m128i swap128(__m128i v)
+		{
+			// Swap the 16-bit words, then the bytes within them
+			if constexpr (bytes == 4)
+				v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			else if constexpr (bytes == 8)
+				v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+			return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		}
+#endif
+
+#ifdef ENDIANESS_AVX2
+		// Byte order within each 16 bytes for reversing the values
+		template<std::size_t bytes>
+		inline __m256i mask256()
+		{
+			if constexpr (bytes == 2)
+				return _mm256_setr_epi8(
+					1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+					1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+			else if constexpr (bytes == 4)
+				return _mm256_setr_epi8(
+					3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+					3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+			else
+				return _mm256_setr_epi8(
+					7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+					7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		}
+#endif
+	} // namespace internal
+
+	/*
+	 * Reverse the bytes of each value in an array, in place
+	 * Note: The data does not need to be aligned
+	 */
+	template<std::size_t bytes>
+	inline void swap(uint8_t * data, std::size_t count)
+	{
+		static_assert(bytes == 2 || bytes == 4 || bytes == 8, "Only 16, 32 and 64-bit values");
+		std::size_t i = 0;
+#ifdef ENDIANESS_AVX2
+		const auto mask = internal::mask256<bytes>();
+		for (; i + 32 / bytes <= count; i += 32 / bytes)
+		{
+			auto p = reinterpret_cast<__m256i *>(data + i * bytes);
+			_mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), mask));
+		}
+#endif
+#if defined(ENDIANESS_SSE2)
+		for (; i + 16 / bytes <= count; i += 16 / bytes)
+		{
+			auto p = reinterpret_cast<__m128i *>(data + i * bytes);
+			_mm_storeu_si128(p, internal::swap128<bytes>(_mm_loadu_si128(p)));
+		}
+#elif defined(ENDIANESS_NEON)
+		for (; i + 16 / bytes <= count; i += 16 / bytes)
+		{
+			auto p = data + i * bytes;
+			auto v = vld1q_u8(p);
+			if constexpr (bytes == 2)
+				v = vrev16q_u8(v);
+			else if constexpr (bytes == 4)
+				v = vrev32q_u8(v);
+			else
+				v = vrev64q_u8(v);
+			vst1q_u8(p, v);
+		}
+#endif
+		internal::swapScalar<bytes>(data + i * bytes, count - i);
+	}
+
+	/*
+	 * Convert an array in place from big or little endian to the native order
+	 */
+	template<typename T>
+	inline void fromBigArray(T * data, std::size_t count)
+	{
+		if (isLittle())
+			swap<sizeof(T)>(reinterpret_cast<uint8_t *>(data), count);
+	}
+
+	template<typename T>
+	inline void fromLittleArray(T * data, std::size_t count)
+	{
+		if (isBig())
+			swap<sizeof(T)>(reinterpret_cast<uint8_t *>(data), count);
+	}
 } // namespace endianess
 
 #endif // ENDIANESS_HPP
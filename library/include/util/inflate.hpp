@@ -0,0 +1,145 @@
+#pragma once
+#ifndef INFLATE_HPP
+#define INFLATE_HPP
+
+#include "vectorview.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+#include <stddef.h>
+
+/*
+ * Deflate backends used by Compression
+ * Each backend lives in its own source file, as not all of their headers
+ * can be included together.
+ */
+namespace Compression
+{
+namespace Inflate
+{
+
+// Largest possible expansion of deflate data
+constexpr std::size_t MAX_RATIO = 1032;
+
+// Container around the deflate data
+enum Format
+{
+	FORMAT_ZLIB,
+	FORMAT_RAW,
+	FORMAT_GZIP
+};
+
+// Decompress into data, sized from hint, which is emptied on failure
+using Function = bool (*)(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint);
+
+bool loadZLib(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint);
+#ifdef USE_LIBDEFLATE
+bool loadLibDeflate(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint);
+#endif
+#ifdef USE_ZLIBNG
+bool loadZLibNg(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint);
+#endif
+
+// Size of the buffer to start decompressing into
+// Note: Not the capacity of the buffer, as resizing to it would fill all of it
+inline std::size_t initialSize(std::size_t hint, std::size_t fallback)
+{
+	return hint > 0 ? hint : fallback;
+}
+
+// Window bits selecting the format for zlib compatible streams
+inline int windowBits(Format format)
+{
+	constexpr int MAX_WINDOW_BITS = 15;
+	switch (format)
+	{
+	case FORMAT_RAW: return -MAX_WINDOW_BITS;
+	case FORMAT_GZIP: return 16 + MAX_WINDOW_BITS;
+	default: return MAX_WINDOW_BITS;
+	}
+}
+
+/*
+ * Inflate with a zlib compatible stream, growing the buffer as needed
+ * Api provides the Stream type, the functions init, reset, inflate and end,
+ * as well as the codes OK, STREAM_END and BUF_ERROR.
+ * Note: The stream continues where it left off, so a too small hint only
+ * grows the buffer
+ */
+template<typename Api>
+bool loadStream(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint, std::size_t fallback)
+{
+	using Stream = typename Api::Stream;
+
+	// Setting up a stream allocates its state, so keep one for each thread
+	// and reset it between uses
+	struct Holder
+	{
+		Stream stream{};
+		bool init = false;
+		~Holder() { if (init) Api::end(&stream); }
+	};
+	thread_local Holder holder;
+
+	// Note: Not cleared, as the old content will be overwritten anyway
+	if (compressed.empty())
+	{
+		data.clear();
+		return false;
+	}
+
+	auto bits = windowBits(format);
+	Stream * stream = &holder.stream;
+	if (!holder.init)
+		holder.init = Api::init(stream, bits) == Api::OK;
+	else if (Api::reset(stream, bits) != Api::OK)
+		stream = nullptr;
+	if (!holder.init || !stream)
+	{
+		data.clear();
+		return false;
+	}
+
+	using In = decltype(stream->next_in);
+	using Avail = decltype(stream->avail_in);
+
+	// Inflate directly into the buffer
+	data.resize(initialSize(hint, fallback));
+
+	stream->next_in = const_cast<In>(compressed.data());
+	stream->avail_in = static_cast<Avail>(compressed.size());
+	stream->next_out = data.data();
+	stream->avail_out = static_cast<Avail>(data.size());
+
+	// Iterate through the stream
+	for (;;)
+	{
+		auto ret = Api::inflate(stream);
+		if (ret == Api::STREAM_END)
+			break;
+		if (ret != Api::OK && ret != Api::BUF_ERROR)
+		{
+			data.clear();
+			return false;
+		}
+		// Note: Truncated streams are kept as far as they go
+		if (stream->avail_out > 0)
+			break;
+		// Output is full, so make room for more
+		auto produced = data.size();
+		data.resize(data.size() << 1);
+		stream->next_out = data.data() + produced;
+		stream->avail_out = static_cast<Avail>(data.size() - produced);
+	}
+
+	data.resize(data.size() - stream->avail_out);
+
+	return true;
+}
+
+} // namespace Inflate
+} // namespace Compression
+
+#endif // INFLATE_HPP
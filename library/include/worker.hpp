@@ -6,6 +6,7 @@
 #include "render/render.hpp"
 #include "render/utility.hpp"
 #include "threadpool.hpp"
+#include "readahead.hpp"
 #include "eventhandler.hpp"
 #include "shared_value.hpp"
 #include "shared_counter.hpp"
@@ -174,6 +175,8 @@ protected:
 	bool _valid;
 	std::atomic_bool & run;
 	bool use_lonely;
+	// Note: Declared before the pool, so it outlives the tasks using it
+	ReadAhead readahead;
 	ThreadPool pool;
 	std::shared_ptr<RenderSettings> settings;
 	std::shared_ptr<struct RenderModule> mod;
@@ -198,6 +201,13 @@ protected:
 	EventHandler<void()> func_finishedExtras;
 
 	PerfStats perf;
+
+	/**
+	 * @brief Get the file to keep region headers in between renders
+	 * @param output The output path for finished work
+	 * @return The index file, kept with the output
+	 */
+	std::string indexFile(const std::string & output) const;
 };
 
 #endif // WORKER_BASE_HPP
@@ -46,76 +46,89 @@ bool alpha::V::visit(const NBT::Tag & tag)
 				palette::translate(chunk, std::move(sections[i]), id, blocks[i]);
 			}
 			level = false;
+			return true;
 		}
-		else if (tag.isName("xPos"))
+		switch (tag.id())
+		{
+		case NBT::Id::xPos:
 			chunk.setX(tag);
-		else if (tag.isName("zPos"))
+			break;
+		case NBT::Id::zPos:
 			chunk.setZ(tag);
-		else if (tag.isName("Blocks"))
-		{
-			auto source = tag.get<NBT::NBTByteArray>();
-			for (std::size_t n = 0; n < 8; ++n)
+			break;
+		case NBT::Id::Blocks:
 			{
-				auto & b = blocks[n];
-				if (b.empty())
-					b.resize(SECTION_SIZE);
-				convert_alpha<uint16_t>(source, b, n, [&source](uint16_t d, std::size_t i) -> uint16_t {
-					return (d & 0xFF00) | uint16_t(source[i]);
-				});
+				auto source = tag.get<NBT::NBTByteArray>();
+				for (std::size_t n = 0; n < 8; ++n)
+				{
+					auto & b = blocks[n];
+					if (b.empty())
+						b.resize(SECTION_SIZE);
+					convert_alpha<uint16_t>(source, b, n, [&source](uint16_t d, std::size_t i) -> uint16_t {
+						return (d & 0xFF00) | uint16_t(source[i]);
+					});
+				}
 			}
-		}
-		else if (tag.isName("Data"))
-		{
-			auto source = tag.get<NBT::NBTByteArray>();
-			for (std::size_t n = 0; n < 8; ++n)
+			break;
+		case NBT::Id::Data:
+			{
+				auto source = tag.get<NBT::NBTByteArray>();
+				for (std::size_t n = 0; n < 8; ++n)
+				{
+					auto & b = blocks[n];
+					if (b.empty())
+						b.resize(SECTION_SIZE);
+					convert_alpha<uint16_t>(source, b, n, [&source](uint16_t d, std::size_t i) -> uint16_t {
+						return (d & 0x0FFF) | uint16_t(nibble4(source, i) << 12);
+					});
+				}
+			}
+			break;
+		case NBT::Id::BlockLight:
 			{
-				auto & b = blocks[n];
-				if (b.empty())
+				auto source = tag.get<NBT::NBTByteArray>();
+				for (std::size_t n = 0; n < 8; ++n)
+				{
+					auto & section = sections[n];
+					std::vector<uint8_t> b;
 					b.resize(SECTION_SIZE);
-				convert_alpha<uint16_t>(source, b, n, [&source](uint16_t d, std::size_t i) -> uint16_t {
-					return (d & 0x0FFF) | uint16_t(nibble4(source, i) << 12);
-				});
+					convert_alpha<uint8_t>(source, b, n, [&source](uint8_t, std::size_t i) -> uint8_t {
+						return nibble4(source, i);
+					});
+					section.setBlockLight(b);
+				}
 			}
-		}
-		else if (tag.isName("BlockLight"))
-		{
-			auto source = tag.get<NBT::NBTByteArray>();
-			for (std::size_t n = 0; n < 8; ++n)
+			break;
+		case NBT::Id::SkyLight:
 			{
-				auto & section = sections[n];
-				std::vector<uint8_t> b;
-				b.resize(SECTION_SIZE);
-				convert_alpha<uint8_t>(source, b, n, [&source](uint8_t, std::size_t i) -> uint8_t {
-					return nibble4(source, i);
-				});
-				section.setBlockLight(b);
+				auto source = tag.get<NBT::NBTByteArray>();
+				for (std::size_t n = 0; n < 8; ++n)
+				{
+					auto & section = sections[n];
+					std::vector<uint8_t> b;
+					b.resize(SECTION_SIZE);
+					convert_alpha<uint8_t>(source, b, n, [&source](uint8_t, std::size_t i) -> uint8_t {
+						return nibble4(source, i);
+					});
+					section.setSkyLight(b);
+				}
 			}
-		}
-		else if (tag.isName("SkyLight"))
-		{
-			auto source = tag.get<NBT::NBTByteArray>();
-			for (std::size_t n = 0; n < 8; ++n)
+			break;
+		case NBT::Id::HeightMap:
 			{
-				auto & section = sections[n];
-				std::vector<uint8_t> b;
-				b.resize(SECTION_SIZE);
-				convert_alpha<uint8_t>(source, b, n, [&source](uint8_t, std::size_t i) -> uint8_t {
-					return nibble4(source, i);
-				});
-				section.setSkyLight(b);
+				auto & src = tag.get<NBT::NBTByteArray>();
+				std::vector<int32_t> heightmap(Minecraft::chunkWidth() * Minecraft::chunkWidth());
+				std::transform(src.begin(), src.end(), heightmap.begin(), [](int8_t a) { return int32_t(a); });
+				chunk.setHeightMap(std::move(heightmap));
 			}
-		}
-		else if (tag.isName("HeightMap"))
-		{
-			auto & src = tag.get<NBT::NBTByteArray>();
-			std::vector<int32_t> heightmap(Minecraft::chunkWidth() * Minecraft::chunkWidth());
-			std::transform(src.begin(), src.end(), heightmap.begin(), [](int8_t a) { return int32_t(a); });
-			chunk.setHeightMap(std::move(heightmap));
+			break;
+		default:
+			break;
 		}
 	}
-	else if (tag.isName(""))
+	else if (tag.id() == NBT::Id::EMPTY)
 		return false;
-	else if (tag.isName("Level"))
+	else if (tag.id() == NBT::Id::Level)
 	{
 		level = true;
 		return false;
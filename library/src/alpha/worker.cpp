@@ -3,6 +3,7 @@
 #include "render/blockpass.hpp"
 #include "alpha/v.hpp"
 #include "format/alpha.hpp"
+#include "format/nbtparser.hpp"
 #include "util/compression.hpp"
 #include "performance.hpp"
 
@@ -253,7 +254,7 @@ std::shared_ptr<ChunkRenderData> alpha::Worker::workChunk(std::shared_ptr<alpha:
 		{
 			alpha::V chunkReader(data);
 			// Get all data to be read
-			if (reader.parse(uncompressed, chunkReader, NBT::Endianess::BIG) > 0)
+			if (reader.parse<NBT::Endianess::BIG>(uncompressed, chunkReader) > 0)
 			{
 				// TODO: Add to statistics
 			}
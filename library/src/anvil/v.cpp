@@ -18,24 +18,50 @@ bool anvil::V::visit(const NBT::Tag & tag)
 	// Set default to block id if none are set
 	if (chunk.getPaletteType() == PaletteType::UNKNOWN)
 		chunk.setPaletteType(PaletteType::BLOCKID);
-	if (tag.isName(""))
-		return false;
-	else if (tag.isName("Level"))
+	switch (tag.id())
+	{
+	case NBT::Id::EMPTY:
+	case NBT::Id::Level:
 		return false;
 	// Before DataVersion
-	else if (chunk.getDataVersion()	== 0 && tag.isName("V"))
-	{
-		chunk.setDataVersion(tag.get<int8_t>());
-		chunk.setPaletteType(PaletteType::BLOCKID);
-	}
+	case NBT::Id::V:
+		if (chunk.getDataVersion() == 0)
+		{
+			chunk.setDataVersion(tag.get<int8_t>());
+			chunk.setPaletteType(PaletteType::BLOCKID);
+		}
+		break;
 	// After DataVersion
-	else if (tag.isName("DataVersion"))
-	{
+	case NBT::Id::DataVersion:
 		chunk.setDataVersion(tag);
 		if (chunk.getDataVersion() < DATA_VERSION_1_13)
 			chunk.setPaletteType(PaletteType::BLOCKID);
 		else
 			chunk.setPaletteType(PaletteType::NAMESPACEID);
+		break;
+	default:
+		break;
 	}
 	return true;
 }
+
+NBT::Scan anvil::V::scan(const NBT::Tag & tag)
+{
+	if (tag.id() == NBT::Id::EMPTY || tag.id() == NBT::Id::Level)
+	{
+		// Set default to block id if none are set
+		if (chunk.getPaletteType() == PaletteType::UNKNOWN)
+			chunk.setPaletteType(PaletteType::BLOCKID);
+		return NBT::Scan::ENTER;
+	}
+	visit(tag);
+	// Nothing else is needed after it
+	if (tag.id() == NBT::Id::DataVersion)
+		return NBT::Scan::STOP;
+	return NBT::Scan::SKIP;
+}
+
+const NBT::Query * anvil::V::query() const
+{
+	return nullptr;
+}
@@ -19,7 +19,7 @@ bool anvil::V13::visit(const NBT::Tag & tag)
 	{
 		if (tag == NBT::TAG_End)
 			heightmaps = false;
-		else if (tag.isName("WORLD_SURFACE"))
+		else if (tag.id() == NBT::Id::WORLD_SURFACE)
 		{
 			auto & d = tag.get<NBT::NBTLongArray>();
 			std::vector<int32_t> heightmap(SECTION_AREA);
@@ -27,20 +27,22 @@ bool anvil::V13::visit(const NBT::Tag & tag)
 			MC13::nibbleCopy(d, heightmap, bits);
 			chunk.setHeightMap(std::move(heightmap));
 		}
+		return false;
 	}
 	// Get palette
-	else if (palettes_left > 0)
+	if (palettes_left > 0)
 	{
 		// Finished with the compound, so copy over
 		if (tag == NBT::TAG_End)
 			--palettes_left;
-		else if (tag.isName("Name"))
+		else if (tag.id() == NBT::Id::Name)
 			palette.emplace_back(tag.get<NBT::NBTString>());
-		else if (tag.isName("Properties"))
+		else if (tag.id() == NBT::Id::Properties)
 			return true;
+		return false;
 	}
 	// Get data
-	else if (sections_left > 0)
+	if (sections_left > 0)
 	{
 		// Finished with the compound, so copy over
 		if (tag == NBT::TAG_End)
@@ -51,52 +53,75 @@ bool anvil::V13::visit(const NBT::Tag & tag)
 			blocks = {};
 			section = {};
 			--sections_left;
+			return false;
 		}
-		else if (tag.isName("Y"))
+		switch (tag.id())
+		{
+		case NBT::Id::Y:
 			section.setY(tag.get<int8_t>());
-		else if (tag.isName("BlockLight"))
+			break;
+		case NBT::Id::BlockLight:
 			section.setBlockLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("SkyLight"))
+			break;
+		case NBT::Id::SkyLight:
 			section.setSkyLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("Palette"))
-		{
+			break;
+		case NBT::Id::Palette:
 			palettes_left = tag.count();
 			palette.reserve(std::size_t(palettes_left));
+			break;
+		case NBT::Id::BlockStates:
+			{
+				auto & d = tag.get<NBT::NBTLongArray>();
+				if (blocks.empty())
+					blocks.resize(SECTION_SIZE);
+				auto bits = d.size() / (SECTION_SIZE / 64);
+				MC13::nibbleCopy(d, blocks, bits);
+			}
+			break;
+		default:
+			break;
 		}
-		else if (tag.isName("BlockStates"))
-		{
-			auto & d = tag.get<NBT::NBTLongArray>();
-			if (blocks.empty())
-				blocks.resize(SECTION_SIZE);
-			auto bits = d.size() / (SECTION_SIZE / 64);
-			MC13::nibbleCopy(d, blocks, bits);
-		}
+		return false;
 	}
-	else if (tag.isName("Sections"))
+
+	switch (tag.id())
 	{
+	case NBT::Id::Sections:
 		sections_left = tag.count();
 		section.clear();
-	}
-	else if (tag.isName("xPos"))
+		break;
+	case NBT::Id::xPos:
 		chunk.setX(tag);
-	else if (tag.isName("zPos"))
+		break;
+	case NBT::Id::zPos:
 		chunk.setZ(tag);
-	else if (tag.isName("Heightmaps"))
+		break;
+	case NBT::Id::Heightmaps:
 		heightmaps = true;
-	else if (tag.isName("Structures"))
-		return true;
-	else if (tag.isName("CarvingMasks"))
-		return true;
+		break;
+	case NBT::Id::Structures:
+	case NBT::Id::CarvingMasks:
 	// This is totally not interesting
-	else if (tag.isName("Entities"))
-		return true;
-	else if (tag.isName("PostProcessing"))
-		return true;
-	else if (tag.isName("TileEntities"))
-		return true;
-	else if (tag.isName("TileTicks"))
+	case NBT::Id::Entities:
+	case NBT::Id::PostProcessing:
+	case NBT::Id::TileEntities:
+	case NBT::Id::TileTicks:
 		return true;
+	default:
+		break;
+	}
 
 	return false;
 }
 
+const NBT::Query * anvil::V13::query() const
+{
+	static const NBT::Query paths{
+		"Level.{xPos,zPos}",
+		"Level.Heightmaps.WORLD_SURFACE",
+		"Level.Sections[].{Y,BlockLight,SkyLight,BlockStates}",
+		"Level.Sections[].Palette[].Name",
+	};
+	return &paths;
+}
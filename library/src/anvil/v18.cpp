@@ -23,7 +23,7 @@ bool anvil::V18::visit(const NBT::Tag & tag)
 	{
 		if (tag == NBT::TAG_End)
 			heightmaps = false;
-		else if (tag.isName("WORLD_SURFACE"))
+		else if (tag.id() == NBT::Id::WORLD_SURFACE)
 		{
 			auto & d = tag.get<NBT::NBTLongArray>();
 			std::vector<int32_t> heightmap(SECTION_AREA);
@@ -31,33 +31,36 @@ bool anvil::V18::visit(const NBT::Tag & tag)
 			MC16::nibbleCopy(d, heightmap, bits);
 			chunk.setHeightMap(std::move(heightmap));
 		}
+		return false;
 	}
 	// Get palette
-	else if (palettes_left > 0)
+	if (palettes_left > 0)
 	{
 		// Finished with the compound, so copy over
 		if (tag == NBT::TAG_End)
 			--palettes_left;
-		else if (tag.isName("Name"))
+		else if (tag.id() == NBT::Id::Name)
 			palette.emplace_back(tag.get<NBT::NBTString>());
-		else if (tag.isName("Properties"))
+		else if (tag.id() == NBT::Id::Properties)
 			return true;
+		return false;
 	}
 	// Get block states
-	else if (block_states)
+	if (block_states)
 	{
 		if (tag == NBT::TAG_End)
 			block_states = false;
-		else if (tag.isName("palette"))
+		else if (tag.id() == NBT::Id::palette)
 		{
 			palettes_left = tag.count();
 			palette.reserve(std::size_t(palettes_left));
 		}
-		else if (tag.isName("data"))
+		else if (tag.id() == NBT::Id::data)
 			blocks = tag.get<NBT::NBTLongArray>();
+		return false;
 	}
 	// Get data
-	else if (sections_left > 0)
+	if (sections_left > 0)
 	{
 		// Finished with the compound, so copy over
 		if (tag == NBT::TAG_End)
@@ -84,56 +87,77 @@ bool anvil::V18::visit(const NBT::Tag & tag)
 			--sections_left;
 			if (sections_left == 0)
 				chunk.shiftHeightMap(chunk.getMinY());
+			return false;
 		}
-		else if (tag.isName("Y"))
+		switch (tag.id())
 		{
+		case NBT::Id::Y:
 			// Apparently in some rare cases this can be an INT
 			section.setY(
 				tag.type() == NBT::TAG_Byte
 				? tag.get<int8_t>()
 				: tag.get<int32_t>());
-		}
-		else if (tag.isName("BlockLight"))
+			break;
+		case NBT::Id::BlockLight:
 			section.setBlockLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("SkyLight"))
+			break;
+		case NBT::Id::SkyLight:
 			section.setSkyLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("block_states"))
+			break;
+		case NBT::Id::block_states:
 			block_states = true;
-		else if (tag.isName("biomes"))
+			break;
+		case NBT::Id::biomes:
 			return true;
+		default:
+			break;
+		}
+		return false;
 	}
-	else if (tag.isName("sections"))
+
+	switch (tag.id())
 	{
+	case NBT::Id::sections:
 		sections_left = tag.count();
 		section.clear();
-	}
-	else if (tag.isName("xPos"))
+		break;
+	case NBT::Id::xPos:
 		chunk.setX(tag);
-	else if (tag.isName("zPos"))
+		break;
+	case NBT::Id::zPos:
 		chunk.setZ(tag);
-	else if (tag.isName("yPos"))
+		break;
+	case NBT::Id::yPos:
 		chunk.setY(tag);
-	else if (tag.isName("Heightmaps"))
+		break;
+	case NBT::Id::Heightmaps:
 		heightmaps = true;
+		break;
 	// This is totally not interesting
-	else if (tag.isName("blending_data"))
-		return true;
-	else if (tag.isName("block_entities"))
-		return true;
-	else if (tag.isName("block_ticks"))
-		return true;
-	else if (tag.isName("fluid_ticks"))
-		return true;
-	else if (tag.isName("structures"))
-		return true;
-	else if (tag.isName("CarvingMasks"))
-		return true;
-	else if (tag.isName("Entities"))
-		return true;
-	else if (tag.isName("Lights"))
-		return true;
-	else if (tag.isName("PostProcessing"))
+	case NBT::Id::blending_data:
+	case NBT::Id::block_entities:
+	case NBT::Id::block_ticks:
+	case NBT::Id::fluid_ticks:
+	case NBT::Id::structures:
+	case NBT::Id::CarvingMasks:
+	case NBT::Id::Entities:
+	case NBT::Id::Lights:
+	case NBT::Id::PostProcessing:
 		return true;
+	default:
+		break;
+	}
 
 	return false;
-}
\ No newline at end of file
+}
+
+const NBT::Query * anvil::V18::query() const
+{
+	static const NBT::Query paths{
+		"xPos", "yPos", "zPos",
+		"Heightmaps.WORLD_SURFACE",
+		"sections[].{Y,BlockLight,SkyLight}",
+		"sections[].block_states.{palette[].Name,data}",
+	};
+	return &paths;
+}
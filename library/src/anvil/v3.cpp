@@ -21,62 +21,79 @@ bool anvil::V3::visit(const NBT::Tag & tag)
 		{
 			palette::translate(chunk, std::move(section), id, blocks);
 			--sections_left;
+			return false;
 		}
-		else if (tag.isName("Y"))
+		switch (tag.id())
+		{
+		case NBT::Id::Y:
 			section.setY(tag.get<int8_t>());
-		else if (tag.isName("BlockLight"))
+			break;
+		case NBT::Id::BlockLight:
 			section.setBlockLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("SkyLight"))
+			break;
+		case NBT::Id::SkyLight:
 			section.setSkyLight(tag.get<NBT::NBTByteArray>());
-		else if (tag.isName("Blocks"))
-		{
-			auto & d = tag.get<NBT::NBTByteArray>();
-			if (blocks.empty())
-				blocks.resize(SECTION_SIZE);
-			for (auto i = 0U; i < d.size(); ++i)
-				blocks[i] = (blocks[i] & 0xFF00) | uint16_t(d[i]);
-		}
+			break;
+		case NBT::Id::Blocks:
+			{
+				auto & d = tag.get<NBT::NBTByteArray>();
+				if (blocks.empty())
+					blocks.resize(SECTION_SIZE);
+				for (auto i = 0U; i < d.size(); ++i)
+					blocks[i] = (blocks[i] & 0xFF00) | uint16_t(d[i]);
+			}
+			break;
 		// Block ID extension
-		else if (tag.isName("Add"))
-		{
-			auto & d = tag.get<NBT::NBTByteArray>();
-			if (blocks.empty())
-				blocks.resize(SECTION_SIZE);
-			for (auto i = 0U; i < d.size(); ++i)
-				blocks[i] = (blocks[i] & 0xF0FF) | uint16_t(nibble4(d, i) << 8);
-		}
+		case NBT::Id::Add:
+			{
+				auto & d = tag.get<NBT::NBTByteArray>();
+				if (blocks.empty())
+					blocks.resize(SECTION_SIZE);
+				for (auto i = 0U; i < d.size(); ++i)
+					blocks[i] = (blocks[i] & 0xF0FF) | uint16_t(nibble4(d, i) << 8);
+			}
+			break;
 		// Specific data values
-		else if (tag.isName("Data"))
-		{
-			auto & d = tag.get<NBT::NBTByteArray>();
-			if (blocks.empty())
-				blocks.resize(SECTION_SIZE);
-			auto s = d.size() << 1;
-			for (auto i = 0U; i < d.size() && i < s; ++i)
-				blocks[i] = (blocks[i] & 0x0FFF) | uint16_t(nibble4(d, i) << 12);
+		case NBT::Id::Data:
+			{
+				auto & d = tag.get<NBT::NBTByteArray>();
+				if (blocks.empty())
+					blocks.resize(SECTION_SIZE);
+				auto s = d.size() << 1;
+				for (auto i = 0U; i < d.size() && i < s; ++i)
+					blocks[i] = (blocks[i] & 0x0FFF) | uint16_t(nibble4(d, i) << 12);
+			}
+			break;
+		default:
+			break;
 		}
+		return false;
 	}
-	else if (tag.isName("Sections"))
+
+	switch (tag.id())
 	{
+	case NBT::Id::Sections:
 		sections_left = tag.count();
 		section.clear();
-	}
-	else if (tag.isName("xPos"))
+		break;
+	case NBT::Id::xPos:
 		chunk.setX(tag);
-	else if (tag.isName("zPos"))
+		break;
+	case NBT::Id::zPos:
 		chunk.setZ(tag);
-	else if (tag.isName("HeightMap"))
+		break;
+	case NBT::Id::HeightMap:
 		chunk.setHeightMap(tag.get<NBT::NBTIntArray>());
+		break;
 	// This is totally not interesting
-	else if (tag.isName("Entities"))
-		return true;
-	else if (tag.isName("PostProcessing"))
-		return true;
-	else if (tag.isName("TileEntities"))
-		return true;
-	else if (tag.isName("TileTicks"))
+	case NBT::Id::Entities:
+	case NBT::Id::PostProcessing:
+	case NBT::Id::TileEntities:
+	case NBT::Id::TileTicks:
 		return true;
+	default:
+		break;
+	}
 
 	return false;
 }
-
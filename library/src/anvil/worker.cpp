@@ -2,6 +2,7 @@
 
 #include "render/blockpass.hpp"
 #include "format/region.hpp"
+#include "platform.hpp"
 #include "anvil/factory.hpp"
 #include "util/compression.hpp"
 #include "performance.hpp"
@@ -44,7 +45,7 @@ void anvil::Worker::work(const std::string & path, const std::string & output, i
 	 */
 	settings->path = output;
 
-	region::Region region(path);
+	region::Region region(path, region::RegionType::ANVIL, indexFile(output));
 
 	auto drawImage = std::make_shared<WorldRender>(settings);
 
@@ -114,6 +115,9 @@ void anvil::Worker::work(const std::string & path, const std::string & output, i
 
 		perf.regionCounterIncrease();
 
+		if (settings->mode != Render::Mode::REGION_TINY)
+			readahead.enqueue(file);
+
 		/*
 		 * Note: Prioritize second level to reduce the amount of memory loaded
 		 * at the same time. This also ensures that each region file is parsed
@@ -129,6 +133,7 @@ void anvil::Worker::work(const std::string & path, const std::string & output, i
 	if (!run)
 	{
 		pool.abort();
+		readahead.abort();
 		return;
 	}
 	
@@ -137,7 +142,11 @@ void anvil::Worker::work(const std::string & path, const std::string & output, i
 	pool.wait();
 
 	if (!run)
+	{
+		// Cancelled while waiting, so stop loading for it
+		readahead.abort();
 		return;
+	}
 
 	for (auto & future : futures)
 	{
@@ -190,6 +199,9 @@ std::future<std::shared_ptr<RegionRenderData>> anvil::Worker::workRegion(std::sh
 		return promise.get_future();
 	}
 
+	// Wait for the region to be read, if read ahead
+	readahead.acquire(region);
+
 	std::vector<std::shared_ptr<ChunkRenderData>> render_data;
 	render_data.reserve(region->getAmountChunks());
 
@@ -245,6 +257,7 @@ std::future<std::shared_ptr<RegionRenderData>> anvil::Worker::workRegion(std::sh
 	
 	region->close();
 	region->clear();
+	readahead.release(region);
 
 	std::future<std::shared_ptr<RegionRenderData>> future;
 	if (run)
@@ -287,23 +300,25 @@ std::shared_ptr<ChunkRenderData> anvil::Worker::workChunk(std::shared_ptr<region
 	}
 	bool error = false;
 	// Uncompress the data
-	std::vector<uint8_t> uncompressed;
+	// Note: Only used within this call, so keep the memory around for the next chunk
+	thread_local std::vector<uint8_t> uncompressed;
+	// Chunks tend to be of similar size, so decompress into the size of
+	// recent chunks, slowly forgetting any unusually large one
+	thread_local std::size_t estimate = 0;
 	{
 		PERFORMANCE(
 		{
 			switch (chunk->compression_type)
 			{
 			case region::ChunkData::CompressionType::COMPRESSION_ZLIB:
-				uncompressed = Compression::loadZLib(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadZLib(chunk->data, uncompressed, estimate))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
 				}
 				break;
 			case region::ChunkData::CompressionType::COMPRESSION_GZIP:
-				uncompressed = Compression::loadGZip(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadGZip(chunk->data, uncompressed, estimate))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
@@ -313,8 +328,7 @@ std::shared_ptr<ChunkRenderData> anvil::Worker::workChunk(std::shared_ptr<region
 				uncompressed.assign(chunk->data.begin(), chunk->data.end());
 				break;
 			case region::ChunkData::CompressionType::COMPRESSION_LZ4:
-				uncompressed = Compression::loadLZ4(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadLZ4(chunk->data, uncompressed))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
@@ -335,6 +349,7 @@ std::shared_ptr<ChunkRenderData> anvil::Worker::workChunk(std::shared_ptr<region
 		perf.addErrorString("Decompression error");
 		return draw;
 	}
+	estimate = (std::max)(estimate - estimate / 8, uncompressed.size());
 
 	NBT::Reader reader;
 	Chunk data;
@@ -342,8 +357,10 @@ std::shared_ptr<ChunkRenderData> anvil::Worker::workChunk(std::shared_ptr<region
 	{
 		PERFORMANCE(
 		{
+			// Only find the version, without reading the rest of the chunk
 			anvil::V chunkVersion(data);
-			if (reader.parse(uncompressed, chunkVersion, NBT::Endianess::BIG) <= 0)
+			auto scan = [&chunkVersion](const NBT::Tag & tag) { return chunkVersion.scan(tag); };
+			if (reader.scan(uncompressed, scan, NBT::Endianess::BIG) <= 0)
 			{
 				perf.addErrorString(reader.getError());
 				perf.errors.report(ErrorStats::Type::ERROR_PARSE);
@@ -358,8 +375,12 @@ std::shared_ptr<ChunkRenderData> anvil::Worker::workChunk(std::shared_ptr<region
 		PERFORMANCE(
 		{
 			auto chunkReader = anvil::Factory::create(data);
-			// Get all data to be read
-			if (reader.parse(uncompressed, *chunkReader, NBT::Endianess::BIG) > 0)
+			// Get all data to be read, skipping the rest when possible
+			auto query = chunkReader->query();
+			auto read = query
+				? reader.parse(uncompressed, *query, *chunkReader, NBT::Endianess::BIG)
+				: reader.parse(uncompressed, *chunkReader, NBT::Endianess::BIG);
+			if (read > 0)
 			{
 				// TODO: Add to statistics
 			}
@@ -0,0 +1,29 @@
+#include "bedrock/fileranges.hpp"
+
+#include <algorithm>
+
+bedrock::FileRanges::FileRanges(std::vector<BlockHandle> && _blocks, std::size_t count, ParseFunction && _parse, FinishFunction && _finish) :
+	blocks(std::move(_blocks)),
+	errors((std::max)(count, std::size_t(1))),
+	parse(std::move(_parse)),
+	finish(std::move(_finish))
+{
+}
+
+void bedrock::FileRanges::work()
+{
+	for (std::size_t i; (i = next++) < size();)
+	{
+		errors[i] = parse(i, range(i));
+		// Note: Every range is written before the last one is counted
+		if (++done == size())
+			finish(*this);
+	}
+}
+
+VectorView<const bedrock::FileRanges::BlockHandle> bedrock::FileRanges::range(std::size_t i) const
+{
+	auto first = blocks.size() * i / size();
+	auto last = blocks.size() * (i + 1) / size();
+	return {blocks.data() + first, last - first};
+}
@@ -2,10 +2,21 @@
 
 #include "util/endianess.hpp"
 
+#include <algorithm>
+
+// Keys in a table end with a sequence number and a type
+constexpr std::size_t KEY_TRAILER_SIZE = 8;
+// The world border is 30 million blocks out
+constexpr int32_t CHUNK_LIMIT = 30000000 / 16;
+// Types of keys that contain chunk data
+constexpr uint8_t TYPE_Data3D = 43;
+constexpr uint8_t TYPE_Data2D = 45;
+constexpr uint8_t TYPE_SubChunkPrefix = 47;
+
 namespace parse
 {
 
-ChunkKey read_chunk_key(const std::vector<uint8_t> & key)
+ChunkKey read_chunk_key(const VectorView<const uint8_t> & key)
 {
 	/*
 	= Key value =
@@ -36,10 +47,46 @@ ChunkKey read_chunk_key(const std::vector<uint8_t> & key)
 	return chunk_key;
 }
 
+bool may_contain_chunk_data(const VectorView<const uint8_t> & lower, const VectorView<const uint8_t> & upper, int32_t dimension)
+{
+	// Unbounded or unknown
+	if (lower.size() <= KEY_TRAILER_SIZE || upper.size() <= KEY_TRAILER_SIZE)
+		return true;
+	auto size = (std::min)(lower.size(), upper.size()) - KEY_TRAILER_SIZE;
+	std::size_t shared = std::mismatch(lower.begin(), lower.begin() + size, upper.begin()).first - lower.begin();
+	auto ptr = lower.data();
+
+	// Other keys are mostly text, which turn into positions far outside the world
+	auto valid = [](int32_t v) {
+		return v >= -CHUNK_LIMIT && v <= CHUNK_LIMIT;
+	};
+	if (shared >= 4 && !valid(endianess::fromLittle<int32_t>(ptr)))
+		return false;
+	if (shared >= 8 && !valid(endianess::fromLittle<int32_t>(ptr + 4)))
+		return false;
+
+	// Keys within the range have a type between the types of the bounds
+	auto has_chunk_data = [&lower, &upper, size](std::size_t i) {
+		if (i >= size)
+			return true;
+		for (auto type : {TYPE_Data3D, TYPE_Data2D, TYPE_SubChunkPrefix})
+			if (lower[int(i)] <= type && type <= upper[int(i)])
+				return true;
+		return false;
+	};
+	// Overworld has no dimension in the key
+	if (dimension == 0)
+		return shared < 8 || has_chunk_data(8);
+	for (std::size_t i = 8; i < (std::min)(shared, std::size_t(12)); ++i)
+		if (ptr[i] != uint8_t(uint32_t(dimension) >> ((i - 8) * 8)))
+			return false;
+	return shared < 12 || has_chunk_data(12);
+}
+
 namespace mc
 {
 
-bool is_key_sub_chunk_prefix(const std::vector<uint8_t> & key)
+bool is_key_sub_chunk_prefix(const VectorView<const uint8_t> & key)
 {
 	return key.size() != 9 && key.size() != 10
 		&& key.size() != 13 && key.size() != 14
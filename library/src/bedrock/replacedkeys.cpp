@@ -0,0 +1,51 @@
+#include "bedrock/replacedkeys.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+bedrock::ReplacedKeys::ReplacedKeys(std::vector<std::size_t> files, ReadFunction && _read, ReadyFunction && _ready) :
+	left(std::move(files)),
+	found(left.size()),
+	keys(std::make_shared<const std::vector<std::string>>()),
+	read(std::move(_read)),
+	ready(std::move(_ready))
+{
+}
+
+void bedrock::ReplacedKeys::start()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	started = true;
+	announce();
+}
+
+void bedrock::ReplacedKeys::work(std::size_t pass, std::size_t file)
+{
+	auto read_keys = read(pass, file);
+	std::lock_guard<std::mutex> lock(mutex);
+	auto & keys_found = found[pass];
+	keys_found.insert(keys_found.end(), std::make_move_iterator(read_keys.begin()), std::make_move_iterator(read_keys.end()));
+	--left[pass];
+	announce();
+}
+
+void bedrock::ReplacedKeys::announce()
+{
+	// Note: Announced while locked, so passes are always announced in order
+	while (started && announced < size() && (announced == 0 || left[announced - 1] == 0))
+	{
+		if (announced > 0)
+		{
+			auto & keys_found = found[announced - 1];
+			std::sort(keys_found.begin(), keys_found.end());
+			keys_found.erase(std::unique(keys_found.begin(), keys_found.end()), keys_found.end());
+			std::vector<std::string> merged;
+			merged.reserve(keys->size() + keys_found.size());
+			std::set_union(keys->begin(), keys->end(), keys_found.begin(), keys_found.end(), std::back_inserter(merged));
+			keys = std::make_shared<const std::vector<std::string>>(std::move(merged));
+			keys_found = {};
+		}
+		ready(announced++, keys);
+	}
+}
@@ -3,7 +3,7 @@
 #include "bedrock/limits.hpp"
 #include "bedrock/parse.hpp"
 #include "format/varint.hpp"
-#include "format/nbt.hpp"
+#include "format/nbtparser.hpp"
 #include "util/endianess.hpp"
 #include "util/nibble.hpp"
 #include "util/palette.hpp"
@@ -147,7 +147,7 @@ bedrock::V::V(World & _world)
 {
 }
 
-void bedrock::V::visit(const std::vector<uint8_t> & key, const LevelDB::VectorData & data)
+void bedrock::V::visit(const LevelDB::VectorData & key, const LevelDB::VectorData & data)
 {
 	if (data.empty())
 		return;
@@ -279,6 +279,17 @@ void read_SubChunkPrefix(bedrock::World & world, std::unordered_map<std::string,
 			NBT::Reader reader;
 			std::vector<std::string> _palette;
 			_palette.reserve(palette_size);
+			struct PaletteReader
+			{
+				std::vector<std::string> & palette;
+				bool visit(const NBT::Tag & tag)
+				{
+					if (tag.id() == NBT::Id::name)
+						palette.emplace_back(tag.get<NBT::NBTString>());
+					return false;
+				}
+				bool visit(const NBT::Value &) { return false; }
+			} paletteReader{_palette};
 			for (decltype(palette_size) j = 0; j < palette_size; ++j)
 			{
 				if (data.size() <= std::size_t(std::distance(data.data(), ptr)))
@@ -287,11 +298,7 @@ void read_SubChunkPrefix(bedrock::World & world, std::unordered_map<std::string,
 					return;
 				}
 				auto _size = data.size() - std::distance(data.data(), ptr);
-				auto _diff = reader.parse({const_cast<uint8_t *>(ptr), _size}, [&_palette](const NBT::Tag & tag) {
-					if (tag.isName("name"))
-						_palette.emplace_back(tag.get<NBT::NBTString>());
-					return false;
-				}, [](const auto &) { return false; }, NBT::Endianess::LITTLE);
+				auto _diff = reader.parse<NBT::Endianess::LITTLE>(VectorView<uint8_t>{const_cast<uint8_t *>(ptr), _size}, paletteReader);
 				if (_diff < 0)
 				{
 					spdlog::error(reader.getError());
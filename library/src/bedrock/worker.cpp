@@ -3,10 +3,18 @@
 #include "format/leveldb.hpp"
 #include "bedrock/world.hpp"
 #include "bedrock/factory.hpp"
+#include "bedrock/parse.hpp"
+#include "bedrock/fileranges.hpp"
+#include "bedrock/replacedkeys.hpp"
 #include "performance.hpp"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
 /**
  * @brief Priority when put in queue
  */
@@ -14,9 +22,13 @@ enum QueuePriority
 {
 	QP_MAP = 0,
 	QP_FILE = 1,
-	QP_CHUNK = 2
+	QP_CHUNK = 2,
+	QP_KEYS = 3
 };
 
+// Minimum amount of data blocks for a file to be parsed in parallel
+constexpr std::size_t BLOCKS_PER_RANGE = 64;
+
 enum PerfE
 {
 	PERF_Lonely,
@@ -89,24 +101,73 @@ void bedrock::Worker::work(const std::string & path, const std::string & output,
 
 	threadpool::Transaction transaction;
 
-	// Go through each file
-	for (auto file : leveldb)
+	// The logs may be large, so start with them
+	auto logFuture = transaction.enqueue(QP_FILE, std::bind(&Worker::workLog, this, leveldb.getLogs(), dimension));
+
+	auto passes = leveldb.passes();
+	std::vector<std::vector<std::shared_ptr<std::promise<std::shared_ptr<World>>>>> results(passes.size());
+	std::vector<std::size_t> counts;
+	for (std::size_t pass = 0; pass < passes.size(); ++pass)
 	{
-		if (!run)
-			break;
+		// Note: Newest first, as older files have to wait for them
+		for (auto & file : passes[pass])
+		{
+			file->close();
 
-		file->close();
+			perf.regionCounterIncrease();
 
-		perf.regionCounterIncrease();
+			readahead.enqueue(file);
 
-		futures.emplace(transaction.enqueue(1, std::bind(&Worker::workFile, this, file, dimension)));
+			results[pass].emplace_back(std::make_shared<std::promise<std::shared_ptr<World>>>());
+			futures.emplace(results[pass].back()->get_future());
+		}
+		counts.emplace_back(passes[pass].size());
+	}
 
-		if (run && transaction.size() >= pool.size())
-			pool.commit(transaction);
+	// Files are parsed once the keys of newer files are known, so only the
+	// newest value is used
+	auto queued = std::make_shared<std::promise<void>>();
+	auto filter = [dimension](const LevelDB::VectorData & lower, const LevelDB::VectorData & upper) {
+		return parse::may_contain_chunk_data(lower, upper, dimension);
+	};
+	auto readKeys = [this, passes, filter](std::size_t pass, std::size_t i) {
+		if (!run)
+			return std::vector<std::string>();
+		return passes[pass][i]->readKeys(filter);
+	};
+	auto parseFiles = [this, passes, results, dimension, queued](std::size_t pass, const ReplacedKeys::Keys & keys) {
+		for (std::size_t i = 0; i < passes[pass].size(); ++i)
+			pool.enqueue(QP_FILE, std::bind(&Worker::workFile, this, passes[pass][i], dimension, keys, results[pass][i]));
+		if (pass + 1 == passes.size())
+			queued->set_value();
+	};
+	auto replaced = std::make_shared<ReplacedKeys>(std::move(counts), std::move(readKeys), std::move(parseFiles));
+
+	// Nothing is older than the last pass, so its keys are never needed
+	for (std::size_t pass = 0; pass + 1 < passes.size(); ++pass)
+	{
+		for (std::size_t i = 0; i < passes[pass].size(); ++i)
+		{
+			transaction.enqueue(QP_KEYS, [replaced, pass, i]() { replaced->work(pass, i); });
+
+			if (run && transaction.size() >= pool.size())
+				pool.commit(transaction);
+		}
 	}
 
 	pool.commit(transaction);
 
+	if (!passes.empty())
+		replaced->start();
+	else
+		queued->set_value();
+
+	// Merges wait on the files, so they would hold on to threads needed by
+	// files not yet queued
+	auto allQueued = queued->get_future();
+	while (run && allQueued.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+		continue;
+
 	for (int prio = 0; futures.size() > 1; --prio)
 	{
 		if (!run)
@@ -126,50 +187,20 @@ void bedrock::Worker::work(const std::string & path, const std::string & output,
 	if (!run)
 	{
 		pool.abort();
+		readahead.abort();
 		return;
 	}
 
-	// Manually handle log file
-	auto file = leveldb.getLog();
-	auto world = std::make_shared<World>(file->file(), dimension);
-	{
-		bool error = 0;
-		LevelDB::LogReader reader;
-		auto block = file->readAll();
-		auto worldReader = bedrock::Factory::create(*world);
-		PERFORMANCE(
-		{
-			if (reader.parse(block, *worldReader) == 0)
-			{
-				// TODO: Statistics
-			}
-			else
-			{
-				perf.addErrorString(reader.getError());
-				perf.errors.report(ErrorStats::ERROR_PARSE);
-				error = true;
-			}
-		}, perf.getPerfValue(PERF_Parse));
-
-		if (!error)
-		{
-			func_finishedChunk(1);
-
-			PERFORMANCE(
-			{
-				ChunkRender renderChunk;
-				world->draw([this, &renderChunk](const Chunk & chunk) {
-					return renderChunk.draw(chunkPass, chunk);
-				});
-			}, perf.getPerfValue(PERF_Render));
-		}
-	}
-	file->close();
-
 	pool.wait();
 
+	// Cancelled while waiting, so stop loading for it
+	if (!run)
+		readahead.abort();
+
 	func_finishedChunks();
 
+	auto world = logFuture.get();
+
 	auto future = futures.front();
 	futures.pop();
 	auto lastWorld = future.get();
@@ -224,33 +255,93 @@ void bedrock::Worker::work(const std::string & path, const std::string & output,
 	perf.print();
 }
 
-std::shared_ptr<bedrock::World> bedrock::Worker::workFile(std::shared_ptr<LevelDB::LevelFile> file, int32_t dimension)
+// Check if a newer file has the key
+static bool is_replaced(const std::vector<std::string> * replaced, const LevelDB::VectorData & key)
+{
+	if (!replaced || replaced->empty())
+		return false;
+	auto user = LevelDB::userKey(key);
+	std::string_view view(reinterpret_cast<const char *>(user.data()), user.size());
+	return std::binary_search(replaced->begin(), replaced->end(), view, std::less<std::string_view>());
+}
+
+void bedrock::Worker::workFile(std::shared_ptr<LevelDB::LevelFile> file, int32_t dimension, std::shared_ptr<const std::vector<std::string>> replaced, std::shared_ptr<std::promise<std::shared_ptr<World>>> result)
 {
-	bool error = 0;
 	auto world = std::make_shared<World>(file->file(), dimension);
 	if (!run)
 	{
 		pool.abort();
-		return world;
+		readahead.release(file);
+		result->set_value(world);
+		return;
 	}
+	// Wait for the file to be read, if read ahead
+	readahead.acquire(file);
 	LevelDB::LevelReader reader;
-	auto block = file->readAll();
-	auto worldReader = bedrock::Factory::create(*world);
-	PERFORMANCE(
+	auto block = file->load();
+	std::vector<LevelDB::LevelReader::BlockHandle> blocks;
+	// Skip blocks that cannot contain anything of interest
+	auto filter = [dimension](const LevelDB::VectorData & lower, const LevelDB::VectorData & upper) {
+		return parse::may_contain_chunk_data(lower, upper, dimension);
+	};
+	if (reader.blocks(block, blocks, filter) != 0)
 	{
-		if (reader.parse(block, *worldReader) == 0)
+		perf.addErrorString(reader.getError());
+		perf.errors.report(ErrorStats::ERROR_PARSE);
+		result->set_value(finishFile(file, world, true));
+		return;
+	}
+
+	// Only split up large files, and never more than there are threads
+	auto count = std::clamp(blocks.size() / BLOCKS_PER_RANGE, std::size_t(1), pool.size());
+	auto worlds = std::make_shared<std::vector<std::shared_ptr<World>>>(count);
+	worlds->front() = world;
+	for (std::size_t i = 1; i < count; ++i)
+		(*worlds)[i] = std::make_shared<World>(file->file(), dimension);
+
+	// Each range is parsed into its own world
+	auto parseRange = [this, block, worlds, replaced](std::size_t i, VectorView<const LevelDB::LevelReader::BlockHandle> range) {
+		std::string error;
+		LevelDB::LevelReader reader;
+		auto worldReader = bedrock::Factory::create(*(*worlds)[i]);
+		auto visit = [&replaced, &worldReader](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+			if (!is_replaced(replaced.get(), key))
+				worldReader->visit(key, value);
+		};
+		PERFORMANCE(
 		{
-			// TODO: Statistics
-		}
-		else
+			if (reader.parse(block, range, visit) != 0)
+				error = reader.getError();
+		}, perf.getPerfValue(PERF_Parse));
+		return error;
+	};
+	auto finishRanges = [this, file, worlds, result](FileRanges & ranges) {
+		bool error = false;
+		for (std::size_t i = 0; i < ranges.size(); ++i)
 		{
-			perf.addErrorString(reader.getError());
+			if (ranges.error(i).empty())
+				continue;
+			perf.addErrorString(ranges.error(i));
 			perf.errors.report(ErrorStats::ERROR_PARSE);
 			error = true;
 		}
-	}, perf.getPerfValue(PERF_Parse));
+		auto & world = worlds->front();
+		// Merge in file order, so the result is always the same
+		for (std::size_t i = 1; !error && i < worlds->size(); ++i)
+			world->merge(*(*worlds)[i]);
+		result->set_value(finishFile(file, world, error));
+	};
+	auto ranges = std::make_shared<FileRanges>(std::move(blocks), count, std::move(parseRange), std::move(finishRanges));
+	for (std::size_t i = 1; i < count; ++i)
+		pool.enqueue(QP_CHUNK, [ranges]() { ranges->work(); });
+	ranges->work();
+}
 
+std::shared_ptr<bedrock::World> bedrock::Worker::finishFile(std::shared_ptr<LevelDB::LevelFile> file, std::shared_ptr<World> world, bool error)
+{
 	file->close();
+	file->unload();
+	readahead.release(file);
 
 	if (error)
 	{
@@ -288,6 +379,48 @@ std::shared_ptr<bedrock::World> bedrock::Worker::workFile(std::shared_ptr<LevelD
 	return world;
 }
 
+std::shared_ptr<bedrock::World> bedrock::Worker::workLog(std::vector<std::shared_ptr<LevelDB::LevelFile>> files, int32_t dimension)
+{
+	bool error = 0;
+	auto world = std::make_shared<World>(files.empty() ? std::string() : files.back()->file(), dimension);
+	if (!run)
+		return world;
+	auto worldReader = bedrock::Factory::create(*world);
+	// Note: Oldest to newest, so later values replace earlier
+	for (auto & file : files)
+	{
+		LevelDB::LogReader reader;
+		auto block = file->load();
+		PERFORMANCE(
+		{
+			if (!error && reader.parse(block, *worldReader) != 0)
+			{
+				perf.addErrorString(reader.getError());
+				perf.errors.report(ErrorStats::ERROR_PARSE);
+				error = true;
+			}
+		}, perf.getPerfValue(PERF_Parse));
+
+		file->close();
+		file->unload();
+	}
+
+	if (error)
+		return world;
+
+	func_finishedChunk(1);
+
+	PERFORMANCE(
+	{
+		ChunkRender renderChunk;
+		world->draw([this, &renderChunk](const Chunk & chunk) {
+			return renderChunk.draw(chunkPass, chunk);
+		});
+	}, perf.getPerfValue(PERF_Render));
+
+	return world;
+}
+
 std::shared_ptr<bedrock::World> bedrock::Worker::mergeWorlds(std::shared_future<std::shared_ptr<bedrock::World>> f1, std::shared_future<std::shared_ptr<bedrock::World>> f2)
 {
 	f1.wait();
@@ -2,6 +2,8 @@
 
 #include "render/blockpass.hpp"
 #include "format/region.hpp"
+#include "platform.hpp"
+#include "format/nbtparser.hpp"
 #include "alpha/v.hpp"
 #include "util/compression.hpp"
 #include "performance.hpp"
@@ -44,7 +46,7 @@ void beta::Worker::work(const std::string & path, const std::string & output, in
 	 */
 	settings->path = output;
 
-	region::Region region(path, region::RegionType::BETA);
+	region::Region region(path, region::RegionType::BETA, indexFile(output));
 
 	auto drawImage = std::make_shared<WorldRender>(settings);
 
@@ -114,6 +116,9 @@ void beta::Worker::work(const std::string & path, const std::string & output, in
 
 		perf.regionCounterIncrease();
 
+		if (settings->mode != Render::Mode::REGION_TINY)
+			readahead.enqueue(file);
+
 		/*
 		 * Note: Prioritize second level to reduce the amount of memory loaded
 		 * at the same time. This also ensures that each region file is parsed
@@ -129,6 +134,7 @@ void beta::Worker::work(const std::string & path, const std::string & output, in
 	if (!run)
 	{
 		pool.abort();
+		readahead.abort();
 		return;
 	}
 	
@@ -137,7 +143,11 @@ void beta::Worker::work(const std::string & path, const std::string & output, in
 	pool.wait();
 
 	if (!run)
+	{
+		// Cancelled while waiting, so stop loading for it
+		readahead.abort();
 		return;
+	}
 
 	for (auto & future : futures)
 	{
@@ -190,6 +200,9 @@ std::future<std::shared_ptr<RegionRenderData>> beta::Worker::workRegion(std::sha
 		return promise.get_future();
 	}
 
+	// Wait for the region to be read, if read ahead
+	readahead.acquire(region);
+
 	std::vector<std::shared_ptr<ChunkRenderData>> render_data;
 	render_data.reserve(region->getAmountChunks());
 
@@ -245,6 +258,7 @@ std::future<std::shared_ptr<RegionRenderData>> beta::Worker::workRegion(std::sha
 
 	region->close();
 	region->clear();
+	readahead.release(region);
 
 	std::future<std::shared_ptr<RegionRenderData>> future;
 	if (run)
@@ -287,23 +301,25 @@ std::shared_ptr<ChunkRenderData> beta::Worker::workChunk(std::shared_ptr<region:
 	}
 	bool error = false;
 	// Uncompress the data
-	std::vector<uint8_t> uncompressed;
+	// Note: Only used within this call, so keep the memory around for the next chunk
+	thread_local std::vector<uint8_t> uncompressed;
+	// Chunks tend to be of similar size, so decompress into the size of
+	// recent chunks, slowly forgetting any unusually large one
+	thread_local std::size_t estimate = 0;
 	{
 		PERFORMANCE(
 		{
 			switch (chunk->compression_type)
 			{
 			case region::ChunkData::CompressionType::COMPRESSION_ZLIB:
-				uncompressed = Compression::loadZLib(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadZLib(chunk->data, uncompressed, estimate))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
 				}
 				break;
 			case region::ChunkData::CompressionType::COMPRESSION_GZIP:
-				uncompressed = Compression::loadGZip(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadGZip(chunk->data, uncompressed, estimate))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
@@ -313,8 +329,7 @@ std::shared_ptr<ChunkRenderData> beta::Worker::workChunk(std::shared_ptr<region:
 				uncompressed.assign(chunk->data.begin(), chunk->data.end());
 				break;
 			case region::ChunkData::CompressionType::COMPRESSION_LZ4:
-				uncompressed = Compression::loadLZ4(chunk->data);
-				if (uncompressed.empty())
+				if (!Compression::loadLZ4(chunk->data, uncompressed))
 				{
 					perf.errors.report(ErrorStats::Type::ERROR_COMPRESSION);
 					error = true;
@@ -335,6 +350,7 @@ std::shared_ptr<ChunkRenderData> beta::Worker::workChunk(std::shared_ptr<region:
 		perf.addErrorString("Decompression error");
 		return draw;
 	}
+	estimate = (std::max)(estimate - estimate / 8, uncompressed.size());
 
 	NBT::Reader reader;
 	Chunk data;
@@ -344,7 +360,7 @@ std::shared_ptr<ChunkRenderData> beta::Worker::workChunk(std::shared_ptr<region:
 		{
 			alpha::V chunkReader(data);
 			// Get all data to be read
-			if (reader.parse(uncompressed, chunkReader, NBT::Endianess::BIG) > 0)
+			if (reader.parse<NBT::Endianess::BIG>(uncompressed, chunkReader) > 0)
 			{
 				// TODO: Add to statistics
 			}
@@ -1,10 +1,11 @@
 #include "chunk.hpp"
 
-#include "util/nibble.hpp" // Move outside
+#include "util/endianess.hpp"
 #include "anvil/limits.hpp"
 
 #include <unordered_map>
 #include <algorithm>
+#include <cstring>
 
 
 static const TileData emptyTile{0, 0, 0};
@@ -12,6 +13,8 @@ static const SectionData emptySection{};
 
 template<typename T>
 void transform_chunk(const std::vector<std::reference_wrapper<SectionData>> & data, std::vector<T> & palette_to, const std::vector<T> & palette_from);
+// Pack a value for each tile into nibbles
+static void pack_nibbles(std::vector<uint8_t> & dst, const uint8_t * src);
 
 void SectionData::setY(int32_t _y)
 {
@@ -20,16 +23,38 @@ void SectionData::setY(int32_t _y)
 
 void SectionData::setBlocks(const std::vector<uint16_t> & d)
 {
-	allocate();
-	if (d.size() == 1)
+	assert(d.size() <= SECTION_SIZE);
+	// A single index is read as if packed with all bits
+	bits = 0;
+	mask = 0xFFFF;
+	auto uniform = [this](uint16_t index)
 	{
-		for (auto i = 0U; i < data.size(); ++i)
-			data[i].index = d[0];
+		blocks.assign(1, 0);
+		endianess::toLittle<uint16_t>(index, reinterpret_cast<uint8_t *>(blocks.data()));
+	};
+	if (d.size() <= 1)
+	{
+		uniform(d.empty() ? 0 : d[0]);
+		return;
 	}
-	else
+	auto [low, high] = std::minmax_element(d.begin(), d.end());
+	// Blocks not given are left as the first in the palette
+	if (*low == *high && (d.size() == SECTION_SIZE || *high == 0))
+	{
+		uniform(*high);
+		return;
+	}
+	while ((*high >> bits) != 0)
+		++bits;
+	mask = uint16_t((1U << bits) - 1);
+	// Padded to read an index from any byte
+	blocks.assign(SECTION_SIZE * bits / 64 + 1, 0);
+	auto bytes = reinterpret_cast<uint8_t *>(blocks.data());
+	for (std::size_t i = 0; i < d.size(); ++i)
 	{
-		for (auto i = 0U; i < d.size(); ++i)
-			data[i].index = d[i];
+		auto bit = i * bits;
+		auto p = bytes + (bit >> 3);
+		endianess::toLittle<uint32_t>(endianess::fromLittle<uint32_t>(p) | uint32_t(d[i]) << (bit & 7), p);
 	}
 }
 void SectionData::setBlockLight(const std::vector<int8_t> &d)
@@ -39,23 +64,17 @@ void SectionData::setBlockLight(const std::vector<int8_t> &d)
 void SectionData::setBlockLight(const VectorView<int8_t> &d)
 {
 	assert(d.size() == SECTION_SIZE >> 1);
-	allocate();
-	auto s = d.size() << 1;
-	for (auto i = 0U; i < s; ++i)
-		data[i].blockLight = static_cast<uint8_t>(nibble4(d, i));
+	auto p = reinterpret_cast<const uint8_t *>(d.data());
+	blockLight.assign(p, p + d.size());
 }
 void SectionData::setBlockLight(const std::vector<uint8_t> &d)
 {
 	assert(d.size() == SECTION_SIZE);
-	allocate();
-	for (auto i = 0U; i < d.size(); ++i)
-		data[i].blockLight = d[i];
+	pack_nibbles(blockLight, d.data());
 }
 void SectionData::updateBlockLight(const std::array<uint8_t, SECTION_SIZE> &d)
 {
-	allocate();
-	for (auto i = 0U; i < d.size(); ++i)
-		data[i].blockLight = d[i];
+	pack_nibbles(blockLight, d.data());
 }
 void SectionData::setSkyLight(const std::vector<int8_t> &d)
 {
@@ -64,65 +83,85 @@ void SectionData::setSkyLight(const std::vector<int8_t> &d)
 void SectionData::setSkyLight(const VectorView<int8_t> &d)
 {
 	assert(d.size() == SECTION_SIZE >> 1);
-	allocate();
-	auto s = d.size() << 1;
-	for (auto i = 0U; i < s; ++i)
-		data[i].skyLight = static_cast<uint8_t>(nibble4(d, i));
+	auto p = reinterpret_cast<const uint8_t *>(d.data());
+	skyLight.assign(p, p + d.size());
 }
 void SectionData::setSkyLight(const std::vector<uint8_t> &d)
 {
 	assert(d.size() == SECTION_SIZE);
-	allocate();
-	for (auto i = 0U; i < d.size(); ++i)
-		data[i].skyLight = d[i];
+	pack_nibbles(skyLight, d.data());
 }
 
 void SectionData::transform(const std::function<uint16_t(uint16_t)> & c)
 {
-	std::for_each(data.begin(), data.end(), [&c](TileData & t) { t.index = c(t.index); });
+	if (blocks.empty())
+		return;
+	if (bits == 0)
+	{
+		setBlocks({c(getIndex(0))});
+		return;
+	}
+	std::vector<uint16_t> d(SECTION_SIZE);
+	for (std::size_t i = 0; i < d.size(); ++i)
+		d[i] = c(getIndex(i));
+	setBlocks(d);
+}
+
+// Get the palette index of a tile
+inline uint16_t SectionData::getIndex(std::size_t i) const
+{
+	if (blocks.empty())
+		return 0;
+	// An index never spans more than the 4 bytes from where it starts
+	auto bit = i * bits;
+	auto p = reinterpret_cast<const uint8_t *>(blocks.data()) + (bit >> 3);
+	uint32_t value;
+	if (endianess::isLittle())
+		std::memcpy(&value, p, sizeof(value));
+	else
+		value = endianess::fromLittle<uint32_t>(p);
+	return uint16_t((value >> (bit & 7)) & mask);
 }
 
 // Get tile from section
-const TileData & SectionData::getTile(const utility::BlockPosition & pos) const
+TileData SectionData::getTile(const utility::BlockPosition & pos) const
 {
+	std::size_t i;
 	if (blockOrder == BlockOrder::YZX)
-		return data.at(std::size_t(
+		i = std::size_t(
 			pos.y * SECTION_X * SECTION_Z +
 			pos.z * SECTION_X +
 			pos.x
-		));
+		);
 	else
-		return data.at(std::size_t(
+		i = std::size_t(
 			pos.x * SECTION_Y * SECTION_Z +
 			pos.z * SECTION_Y +
 			pos.y
-		));
+		);
+	assert(i < SECTION_SIZE);
+	auto shift = (i & 1) << 2;
+	return {
+		getIndex(i),
+		uint8_t(blockLight.empty() ? 0 : (blockLight[i >> 1] >> shift) & 0x0F),
+		uint8_t(skyLight.empty() ? 0 : (skyLight[i >> 1] >> shift) & 0x0F)
+	};
 }
 
 // Check if section have been allocated
 bool SectionData::allocated() const
 {
-	return !data.empty();
+	return !blocks.empty() || !blockLight.empty() || !skyLight.empty();
 }
 
 // Clear the section
 void SectionData::clear()
 {
-	// Only add needs to be cleared, as that value is optional
-	for (auto & d : data)
-	{
-		d.index = 0;
-		d.blockLight = 0;
-		d.skyLight = 0;
-	}
-}
-
-// Dynamically allocate if not allocated
-inline void SectionData::allocate()
-{
-	if (data.size() == SECTION_SIZE)
-		return;
-	data.resize(SECTION_SIZE);
+	// Keep what has been allocated, as it is written again
+	if (!blocks.empty())
+		setBlocks({0});
+	std::fill(blockLight.begin(), blockLight.end(), 0);
+	std::fill(skyLight.begin(), skyLight.end(), 0);
 }
 
 Chunk::Chunk()
@@ -174,12 +213,14 @@ void Chunk::setHeightMap(const VectorView<int32_t> & d)
 {
 	assert(d.size() == heightMap.size());
 	std::copy(d.begin(), d.end(), heightMap.begin());
+	hasHeightMap = true;
 }
 
 void Chunk::setHeightMap(std::vector<int32_t> && d)
 {
 	assert(d.size() == heightMap.size());
 	heightMap = std::move(d);
+	hasHeightMap = true;
 }
 
 void Chunk::shiftHeightMap(int32_t y)
@@ -224,7 +265,7 @@ bool Chunk::hasSection(const utility::BlockPosition & pos) const
 	return it->second.allocated();
 }
 
-const TileData & Chunk::getTile(const utility::BlockPosition & pos) const
+TileData Chunk::getTile(const utility::BlockPosition & pos) const
 {
 	auto i = (pos.y - getMinY()) / SECTION_Y + (getMinY() / SECTION_Y);
 	auto it = data.find(i);
@@ -277,31 +318,45 @@ const std::vector<std::string> & Chunk::getNSPalette() const
 
 void Chunk::merge(const Chunk & chunk)
 {
-	// Only copy what needs to be copied
-	if (getPaletteType() == chunk.getPaletteType())
+	// Partial chunks may come without any sections
+	if (!chunk.data.empty())
 	{
-		std::vector<std::reference_wrapper<SectionData>> transpose;
-		for (auto & section : data)
-			if (chunk.data.find(section.first) == chunk.data.end())
-				transpose.emplace_back(section.second);
-		for (auto & section : chunk.data)
-			data.insert_or_assign(section.first, section.second);
-		if (getPaletteType() == PaletteType::BLOCKID)
-			transform_chunk(transpose, palette.id, chunk.palette.id);
-		else if (getPaletteType() == PaletteType::NAMESPACEID)
-			transform_chunk(transpose, palette.ns, chunk.palette.ns);
+		// Only copy what needs to be copied
+		if (getPaletteType() == chunk.getPaletteType())
+		{
+			std::vector<std::reference_wrapper<SectionData>> transpose;
+			for (auto & section : data)
+				if (chunk.data.find(section.first) == chunk.data.end())
+					transpose.emplace_back(section.second);
+			for (auto & section : chunk.data)
+				data.insert_or_assign(section.first, section.second);
+			if (getPaletteType() == PaletteType::BLOCKID)
+				transform_chunk(transpose, palette.id, chunk.palette.id);
+			else if (getPaletteType() == PaletteType::NAMESPACEID)
+				transform_chunk(transpose, palette.ns, chunk.palette.ns);
+			minY = (std::min)(minY, chunk.minY);
+			maxY = (std::max)(maxY, chunk.maxY);
+		}
+		// Replace everything
+		else
+		{
+			data = chunk.data;
+			paletteType = chunk.paletteType;
+			palette = chunk.palette;
+			minY = chunk.minY;
+			maxY = chunk.maxY;
+		}
+		xPos = chunk.xPos;
+		zPos = chunk.zPos;
 	}
-	// Replace everything
-	else
+	// Partial chunks may also come without a heightmap
+	if (chunk.hasHeightMap)
 	{
-		data = chunk.data;
-		if (getPaletteType() == PaletteType::BLOCKID)
-			palette.id = chunk.palette.id;
-		else if (getPaletteType() == PaletteType::NAMESPACEID)
-			palette.ns = chunk.palette.ns;
+		heightMap = chunk.heightMap;
+		hasHeightMap = true;
 	}
-	heightMap = chunk.heightMap;
-	dataVersion = chunk.dataVersion;
+	if (chunk.dataVersion != 0)
+		dataVersion = chunk.dataVersion;
 }
 
 inline void Chunk::updateYMinMax(int32_t y)
@@ -338,3 +393,10 @@ void transform_chunk(const std::vector<std::reference_wrapper<SectionData>> & da
 	for (auto it : reversed_palette)
 		palette_to[it.second] = it.first;
 }
+
+static void pack_nibbles(std::vector<uint8_t> & dst, const uint8_t * src)
+{
+	dst.resize(SECTION_SIZE >> 1);
+	for (auto i = 0U; i < dst.size(); ++i)
+		dst[i] = uint8_t((src[i << 1] & 0x0F) | (src[(i << 1) + 1] << 4));
+}
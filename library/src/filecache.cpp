@@ -0,0 +1,165 @@
+#include "filecache.hpp"
+
+#include <algorithm>
+
+/*
+ * Handle
+ */
+
+FileCache::Handle::Handle(FileCache * _cache, Entry * _entry) :
+	cache(_cache), entry(_entry)
+{
+}
+
+FileCache::Handle::Handle(Handle && other) noexcept :
+	cache(other.cache), entry(other.entry)
+{
+	other.cache = nullptr;
+	other.entry = nullptr;
+}
+
+FileCache::Handle::~Handle()
+{
+	release();
+}
+
+FileCache::Handle & FileCache::Handle::operator=(Handle && other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		std::swap(cache, other.cache);
+		std::swap(entry, other.entry);
+	}
+	return *this;
+}
+
+uint64_t FileCache::Handle::size() const
+{
+	return entry ? entry->size : 0;
+}
+
+std::ptrdiff_t FileCache::Handle::read(void * out, std::size_t size, uint64_t offset) const
+{
+	if (!entry)
+		return -1;
+	return platform::file::read(entry->handle, out, size, offset);
+}
+
+std::shared_ptr<void> FileCache::Handle::map(std::size_t & size) const
+{
+	if (!entry)
+		return {};
+	return platform::mmap::load(entry->handle, size);
+}
+
+void FileCache::Handle::release()
+{
+	if (entry)
+		cache->release(entry);
+	cache = nullptr;
+	entry = nullptr;
+}
+
+/*
+ * FileCache
+ */
+
+FileCache::FileCache(std::size_t _capacity) :
+	capacity((std::max)(_capacity, std::size_t(1)))
+{
+}
+
+FileCache::~FileCache()
+{
+	for (auto & file : files)
+		platform::file::close(file.second.handle);
+}
+
+FileCache & FileCache::global()
+{
+	// Leave room for files opened elsewhere
+	static FileCache cache(platform::fd::max() / 2);
+	return cache;
+}
+
+FileCache::Handle FileCache::acquire(const std::string & file)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto [it, inserted] = files.try_emplace(file);
+	auto & entry = it->second;
+	if (inserted)
+	{
+		entry.file = &it->first;
+		if (!open(entry))
+		{
+			files.erase(it);
+			return {};
+		}
+		while (files.size() > capacity && evict());
+	}
+	else if (entry.users == 0)
+	{
+		// No longer idle
+		idle.erase(entry.order);
+		// Changed since opened, like a region saved by a server or a
+		// growing log, so open it again
+		uint64_t size;
+		int64_t modified;
+		if (!platform::file::stat(entry.handle, size, modified) || size != entry.size || modified != entry.modified)
+		{
+			platform::file::close(entry.handle);
+			if (!open(entry))
+			{
+				files.erase(it);
+				return {};
+			}
+		}
+	}
+	++entry.users;
+	return {this, &entry};
+}
+
+void FileCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	while (evict());
+}
+
+void FileCache::release(Entry * entry)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (--entry->users > 0)
+		return;
+	entry->order = idle.insert(idle.end(), entry);
+	// Borrowed files may have pushed the cache above its capacity
+	while (files.size() > capacity && evict());
+}
+
+bool FileCache::open(Entry & entry)
+{
+	auto handle = platform::file::open(*entry.file);
+	// Might have run out of file descriptors, so free some and retry
+	if (handle == platform::file::INVALID_HANDLE && platform::file::tooManyOpen() && evict())
+	{
+		while (evict());
+		handle = platform::file::open(*entry.file);
+	}
+	entry.handle = handle;
+	if (handle == platform::file::INVALID_HANDLE)
+		return false;
+	if (!platform::file::stat(handle, entry.size, entry.modified))
+		entry.size = platform::file::size(handle);
+	return true;
+}
+
+bool FileCache::evict()
+{
+	if (idle.empty())
+		return false;
+	auto entry = idle.front();
+	idle.pop_front();
+	platform::file::close(entry->handle);
+	files.erase(files.find(*entry->file));
+	return true;
+}
@@ -1,6 +1,7 @@
 #include "format/leveldb.hpp"
 
 #include "platform.hpp"
+#include "string.hpp"
 #include "util/endianess.hpp"
 #include "vectorview.hpp"
 #include "util/nibble.hpp"
@@ -15,7 +16,11 @@
 #include <algorithm>
 #include <cmath>
 #include <filesystem>
-#include <regex>
+#include <cstring>
+#include <cstdlib>
+#include <string_view>
+#include <set>
+#include <map>
 
 /*
 Endian: little
@@ -79,6 +84,33 @@ block: <=32KiB {
 }
 */
 
+/*
+Manifest format
+log of records {
+	edit: {
+		tag: varint32
+		if tag == 1: comparator: string
+		if tag == 2: log_number: varint64
+		if tag == 3: next_file_number: varint64
+		if tag == 4: last_sequence: varint64
+		if tag == 5: compact_pointer: { level: varint32, key: string }
+		if tag == 6: deleted_file: { level: varint32, number: varint64 }
+		if tag == 7: new_file: {
+			level: varint32
+			number: varint64
+			size: varint64
+			smallest: string
+			largest: string
+		}
+		if tag == 9: prev_log_number: varint64
+	}[]
+}
+string: {
+	length: varint32
+	data: char[length]
+}
+*/
+
 constexpr uint64_t FOOTER_SIZE = 48;
 constexpr uint64_t MAGIC = 0xdb4775248b80fb57ULL;
 enum CompressorType : uint8_t
@@ -91,6 +123,21 @@ enum CompressorType : uint8_t
 };
 constexpr uint64_t BLOCK_SIZE = 32768;
 constexpr uint64_t HEADER_SIZE = 7;
+constexpr std::size_t KEY_TRAILER_SIZE = 8;
+constexpr std::size_t MAX_VARINT_SIZE = 10;
+constexpr std::string_view FILTER_NAME = "filter.leveldb.BuiltinBloomFilter2";
+constexpr uint32_t BLOOM_SEED = 0xbc9f1d34;
+enum EditTag : uint32_t
+{
+	TAG_COMPARATOR = 1,
+	TAG_LOG_NUMBER = 2,
+	TAG_NEXT_FILE_NUMBER = 3,
+	TAG_LAST_SEQUENCE = 4,
+	TAG_COMPACT_POINTER = 5,
+	TAG_DELETED_FILE = 6,
+	TAG_NEW_FILE = 7,
+	TAG_PREV_LOG_NUMBER = 9,
+};
 enum RecordType : uint8_t
 {
 	TYPE_ZERO = 0,
@@ -101,15 +148,35 @@ enum RecordType : uint8_t
 };
 
 static std::tuple<uint64_t, uint64_t> read_block_handle(const uint8_t *&);
-static void skip_block_handle(const uint8_t *&);
+static bool read_varint_bounded(const uint8_t *& ptr, const uint8_t * end, uint64_t & value);
+static bool read_string_bounded(const uint8_t *& ptr, const uint8_t * end, LevelDB::VectorData & value);
+static bool parse_file_number(const std::string & name, uint64_t & number);
+static int compare_keys(const LevelDB::VectorData & a, const LevelDB::VectorData & b);
+static bool filter_may_contain(const LevelDB::VectorData & filter, uint64_t offset, const LevelDB::VectorData & key);
+static uint32_t bloom_hash(const LevelDB::VectorData & key);
+
+/*
+ * A loaded block. Uncompressed blocks are viewed in place, while
+ * decompressed blocks own their content.
+ */
+struct Block
+{
+	Block() = default;
+	Block(const Block &) = delete;
+	Block(Block &&) = default;
+	Block & operator=(Block &&) = default;
 
-static const uint8_t * get_block_end_pos(const std::vector<uint8_t> & block);
+	std::vector<uint8_t> storage;
+	LevelDB::VectorData data;
+	// Unable to read or decompress it
+	bool error = false;
+};
 
-//static std::vector<uint8_t> load_block(const std::vector<uint8_t> & data, uint64_t offset, uint64_t size);
-static std::vector<uint8_t> load_block(LevelDB::VectorData data, uint64_t offset, uint64_t size);
+static const uint8_t * get_block_end_pos(LevelDB::VectorData block);
 
-static std::vector<uint8_t> load_block_type(uint8_t type, const std::vector<uint8_t> & data);
-static std::vector<uint8_t> load_block_type(uint8_t type, LevelDB::VectorData data);
+static Block load_block(LevelDB::VectorData data, uint64_t offset, uint64_t size);
+
+static Block load_block_type(uint8_t type, LevelDB::VectorData data);
 
 enum ValueType : uint8_t
 {
@@ -138,11 +205,13 @@ public:
 	BlockParser() = default;
 	BlockParser(const BlockParser &) = delete;
 	explicit BlockParser(const uint8_t * begin, const uint8_t * end);
-	std::pair<std::vector<uint8_t>, LevelDB::VectorData> next();
+	// Note: The key is only valid until the next call
+	std::pair<LevelDB::VectorData, LevelDB::VectorData> next();
 	bool has() const;
 private:
 	const uint8_t * ptr = nullptr, * end = nullptr;
-	std::vector<uint8_t> prev_key;
+	// Keys share prefix with the previous key, so reuse it
+	std::vector<uint8_t> key;
 };
 
 namespace LevelDB
@@ -160,9 +229,9 @@ void LevelDB::populateFromPath()
 		return;
 
 	levels.clear();
-	log.clear();
+	logs.clear();
 
-	std::regex r_ldb(".+\\.ldb$"), r_log(".+\\.log$");
+	std::vector<std::string> names;
 	std::error_code ec;
 	for (const auto & entry : std::filesystem::directory_iterator{path, ec})
 	{
@@ -171,15 +240,100 @@ void LevelDB::populateFromPath()
 			continue;
 
 		auto name = entry.path().filename().string();
-		if (std::regex_match(name, r_ldb))
+		if (name.size() <= 4)
+			continue;
+		if (string::endsWith(name, ".ldb"))
 			levels.emplace_back(std::make_shared<LevelFile>(name));
-		else if (std::regex_match(name, r_log))
-			log = name;
+		else if (string::endsWith(name, ".log"))
+			names.emplace_back(name);
+	}
+
+	// Files left behind by compactions are not part of the database
+	Version version;
+	if (readManifest(version))
+	{
+		applyVersion(version);
+	}
+	else
+	{
+		// Note: Oldest to newest to process replacement
+		std::sort(levels.begin(), levels.end(), [] (std::shared_ptr<LevelFile> & a, std::shared_ptr<LevelFile> & b) {
+			return a->file() < b->file();
+		});
+	}
+
+	// Older logs have already been written to tables, except the previous
+	// log which may still be compacted
+	std::vector<std::pair<uint64_t, std::string>> live;
+	for (auto & name : names)
+	{
+		uint64_t number;
+		if (!parse_file_number(name, number))
+			number = 0;
+		if (number >= version.logNumber || (version.prevLogNumber != 0 && number == version.prevLogNumber))
+			live.emplace_back(number, std::move(name));
 	}
+	// Note: Oldest to newest to replay them in order
+	std::sort(live.begin(), live.end());
+	for (auto & log : live)
+		logs.emplace_back(std::move(log.second));
+}
 
-	// Note: Oldest to newest to process replacement
-	std::sort(levels.begin(), levels.end(), [] (std::shared_ptr<LevelFile> & a, std::shared_ptr<LevelFile> & b) {
-		return a->file() < b->file();
+bool LevelDB::readManifest(Version & version) const
+{
+	std::ifstream in(platform::path::join(path, "CURRENT"));
+	std::string name;
+	if (!in.is_open() || !std::getline(in, name) || name.empty())
+		return false;
+	LevelFile file(name);
+	if (!file.open(path))
+	{
+		spdlog::warn("Unable to open {:s}", name);
+		return false;
+	}
+	ManifestReader reader;
+	auto ret = reader.parse(file.load(), version);
+	file.unload();
+	file.close();
+	if (ret != 0)
+	{
+		spdlog::warn("Unable to read {:s}: {:s}", name, reader.getError());
+		version = {};
+		return false;
+	}
+	return true;
+}
+
+void LevelDB::applyVersion(const Version & version)
+{
+	std::unordered_map<uint64_t, std::shared_ptr<LevelFile>> files;
+	for (auto & level : levels)
+	{
+		uint64_t number;
+		if (parse_file_number(level->file(), number))
+			files.emplace(number, level);
+	}
+	levels.clear();
+	for (const auto & live : version.files)
+	{
+		auto it = files.find(live.number);
+		if (it == files.end())
+			continue;
+		auto & file = it->second;
+		file->_level = live.level;
+		file->_number = live.number;
+		auto smallest = userKey({live.smallest.data(), live.smallest.size()});
+		auto largest = userKey({live.largest.data(), live.largest.size()});
+		file->_smallest.assign(smallest.begin(), smallest.end());
+		file->_largest.assign(largest.begin(), largest.end());
+		levels.emplace_back(file);
+	}
+
+	// Deeper levels are older, while files in level 0 are ordered by number
+	std::sort(levels.begin(), levels.end(), [] (const std::shared_ptr<LevelFile> & a, const std::shared_ptr<LevelFile> & b) {
+		if (a->_level != b->_level)
+			return a->_level > b->_level;
+		return a->_number < b->_number;
 	});
 }
 
@@ -198,11 +352,148 @@ std::size_t LevelDB::size() const
 	return levels.size();
 }
 
-std::shared_ptr<LevelFile> LevelDB::getLog() const
+std::vector<std::shared_ptr<LevelFile>> LevelDB::getLogs() const
+{
+	std::vector<std::shared_ptr<LevelFile>> files;
+	for (const auto & log : logs)
+	{
+		auto & file = files.emplace_back(std::make_shared<LevelFile>(log));
+		file->open(path);
+	}
+	return files;
+}
+
+std::vector<std::vector<std::shared_ptr<LevelFile>>> LevelDB::passes()
+{
+	std::vector<std::vector<std::shared_ptr<LevelFile>>> passes;
+	// Note: Newest to oldest, as levels are ordered from oldest to newest
+	for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+	{
+		// Files within deeper levels never overlap, so they share one pass,
+		// while files in level 0 are each newer than the one before
+		auto level = (*it)->_level;
+		if (passes.empty() || level == 0 || level != passes.back().back()->_level)
+			passes.emplace_back();
+		(*it)->open(path);
+		passes.back().push_back(*it);
+	}
+	return passes;
+}
+
+bool LevelDB::getChunk(int32_t x, int32_t z, int32_t dimension, std::function<void(const VectorData &, const VectorData &)> visit)
 {
-	auto file = std::make_shared<LevelFile>(log);
-	file->open(path);
-	return file;
+	return getChunks(x, z, x, z, dimension, visit);
+}
+
+bool LevelDB::getChunks(int32_t x1, int32_t z1, int32_t x2, int32_t z2, int32_t dimension, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	// Overworld has no dimension in the key
+	std::size_t size = sizeof(int32_t) * (dimension != 0 ? 3 : 2);
+	// Keys of a chunk are its position followed by a type, and an index
+	// for sub chunks, so all of them are between the first and last type
+	std::vector<std::vector<uint8_t>> bounds;
+	for (auto x = std::min(x1, x2); x <= std::max(x1, x2); ++x)
+	{
+		for (auto z = std::min(z1, z2); z <= std::max(z1, z2); ++z)
+		{
+			std::vector<uint8_t> prefix(size + 1);
+			endianess::toLittle<int32_t>(x, prefix.data());
+			endianess::toLittle<int32_t>(z, prefix.data() + sizeof(int32_t));
+			if (dimension != 0)
+				endianess::toLittle<int32_t>(dimension, prefix.data() + sizeof(int32_t) * 2);
+			prefix.back() = TYPE_Data3D;
+			bounds.emplace_back(prefix);
+			prefix.back() = TYPE_LegacyVersion;
+			bounds.emplace_back(std::move(prefix));
+		}
+	}
+	std::vector<KeyRange> ranges;
+	ranges.reserve(bounds.size() / 2);
+	for (std::size_t i = 0; i < bounds.size(); i += 2)
+		ranges.push_back({{bounds[i].data(), bounds[i].size()}, {bounds[i + 1].data(), bounds[i + 1].size()}});
+	std::sort(ranges.begin(), ranges.end(), [](const KeyRange & a, const KeyRange & b) {
+		return compare_keys(a.lower, b.lower) < 0;
+	});
+	return get(ranges, [&visit, size](const VectorData & key, const VectorData & value) {
+		// Other keys may be sorted between the types of a chunk
+		if (key.size() <= size)
+			return;
+		auto type = key[size];
+		if ((type < TYPE_Data3D || type > TYPE_Checksums) && type != TYPE_LegacyVersion)
+			return;
+		if (key.size() == size + (type == TYPE_SubChunkPrefix ? 2 : 1))
+			visit(key, value);
+	});
+}
+
+bool LevelDB::get(const std::vector<KeyRange> & ranges, const std::function<void(const VectorData &, const VectorData &)> & visit)
+{
+	if (ranges.empty())
+		return true;
+	auto view = [](const VectorData & key) {
+		return std::string_view(reinterpret_cast<const char *>(key.data()), key.size());
+	};
+	auto inRange = [&ranges](const VectorData & key) {
+		auto it = std::lower_bound(ranges.begin(), ranges.end(), key, [](const KeyRange & range, const VectorData & k) {
+			return compare_keys(range.upper, k) < 0;
+		});
+		return it != ranges.end() && compare_keys(it->lower, key) <= 0;
+	};
+	// Keys found in a newer file, as older values are replaced
+	std::set<std::string, std::less<>> found;
+
+	// Logs are newer than all tables, with later values replacing earlier
+	std::map<std::string_view, std::vector<uint8_t>> values;
+	for (auto & file : getLogs())
+	{
+		LogReader reader;
+		auto ret = reader.entries(file->load(), [&](const VectorData & key, const VectorData & value, uint8_t type) {
+			if (!inRange(key))
+				return;
+			auto & user = *found.emplace(view(key)).first;
+			// Deleted keys are marked by their type
+			if (type == 0)
+				values.erase(user);
+			else
+				values[user].assign(value.begin(), value.end());
+		});
+		if (ret != 0)
+			spdlog::warn("Unable to read {:s}: {:s}", file->file(), reader.getError());
+		file->unload();
+		file->close();
+	}
+	for (const auto & [key, value] : values)
+		visit({reinterpret_cast<const uint8_t *>(key.data()), key.size()}, {value.data(), value.size()});
+
+	for (auto it = levels.rbegin(); it != levels.rend(); ++it)
+	{
+		const auto & level = **it;
+		// Key range is known from the manifest
+		if (!level._smallest.empty() && (compare_keys(ranges.back().upper, {level._smallest.data(), level._smallest.size()}) < 0
+			|| compare_keys(ranges.front().lower, {level._largest.data(), level._largest.size()}) > 0))
+			continue;
+		LevelFile file(level.file());
+		if (!file.open(path))
+			continue;
+		LevelReader reader;
+		auto ret = reader.scan(file.load(), {ranges.data(), ranges.size()}, [&](const VectorData & key, const VectorData & value) {
+			auto user = userKey(key);
+			// Replaced by a newer file
+			if (!found.emplace(view(user)).second)
+				return;
+			// Deleted keys are marked by their type
+			if (key.size() >= KEY_TRAILER_SIZE && key[key.size() - KEY_TRAILER_SIZE] != 0)
+				visit(user, value);
+		});
+		file.unload();
+		file.close();
+		if (ret != 0)
+		{
+			spdlog::warn("Unable to read {:s}: {:s}", level.file(), reader.getError());
+			return false;
+		}
+	}
+	return true;
 }
 
 
@@ -224,6 +515,37 @@ uint64_t LevelFile::getModifiedTimestamp() const
 	return std::chrono::duration_cast<std::chrono::seconds>(epoch).count();
 }
 
+std::vector<std::string> LevelFile::readKeys(std::function<bool(const VectorData &, const VectorData &)> filter) const
+{
+	std::vector<std::string> keys;
+	LevelFile table(_file);
+	if (!table.open(_path))
+		return keys;
+	LevelReader reader;
+	std::vector<LevelReader::BlockHandle> handles;
+	auto data = table.load();
+	auto ret = reader.blocks(data, handles, filter);
+	if (ret == 0)
+		ret = reader.parse(data, {handles.data(), handles.size()}, [&keys](const VectorData & key, const VectorData &) {
+			auto user = userKey(key);
+			keys.emplace_back(user.begin(), user.end());
+		});
+	if (ret != 0)
+		spdlog::warn("Unable to read {:s}: {:s}", _file, reader.getError());
+	table.unload();
+	table.close();
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	return keys;
+}
+
+VectorData userKey(const VectorData & key)
+{
+	if (key.size() < KEY_TRAILER_SIZE)
+		return key;
+	return {key.data(), key.size() - KEY_TRAILER_SIZE};
+}
+
 /*
  * Iterators
  */
@@ -275,62 +597,219 @@ std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, Visitor & visitor)
 }
 std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, Visitor & visitor)
 {
-	return parse(data, [&visitor](const std::vector<uint8_t> & key, const VectorData & data)
+	return parse(data, [&visitor](const VectorData & key, const VectorData & data)
 	{
 		return visitor.visit(key, data);
 	});
 }
 
-std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit)
+std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, std::function<void(const VectorData &, const VectorData &)> visit)
 {
 	return parse({data.data(), data.size()}, visit);
 }
 
-std::ptrdiff_t LevelReader::parse(VectorView<uint8_t> data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit)
+std::ptrdiff_t LevelReader::parse(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	std::vector<BlockHandle> handles;
+	if (blocks(data, handles) < 0)
+		return -1;
+	return parse(data, {handles.data(), handles.size()}, visit);
+}
+
+std::ptrdiff_t LevelReader::blocks(VectorView<uint8_t> data, std::vector<BlockHandle> & handles)
+{
+	return blocks(data, handles, nullptr);
+}
+
+std::ptrdiff_t LevelReader::blocks(VectorView<uint8_t> data, std::vector<BlockHandle> & handles, std::function<bool(const VectorData &, const VectorData &)> filter)
+{
+	handles.clear();
+	auto ret = index(data, [&handles, &filter](const VectorData & lower, const VectorData & upper, const BlockHandle & handle) {
+		if (!filter || filter(lower, upper))
+			handles.push_back(handle);
+	});
+	if (ret != 0)
+		return ret;
+	// Note: Usually already in order, but nothing guarantees it
+	std::sort(handles.begin(), handles.end(), [](const BlockHandle & a, const BlockHandle & b) {
+		return a.offset < b.offset;
+	});
+	return 0;
+}
+
+std::ptrdiff_t LevelReader::footer(VectorView<uint8_t> data, BlockHandle & metaindex, BlockHandle & index)
+{
+	if (data.size() < FOOTER_SIZE)
+		return throwError("Unable to read footer");
+	auto magic = endianess::fromLittle<uint64_t, const uint8_t *>(data.data() + data.size() - sizeof(uint64_t));
+	if (magic != MAGIC)
+		return throwError("Invalid magic");
+	const uint8_t * ptr = data.data() + data.size() - FOOTER_SIZE;
+	std::tie(metaindex.offset, metaindex.size) = read_block_handle(ptr);
+	std::tie(index.offset, index.size) = read_block_handle(ptr);
+	return 0;
+}
+
+std::ptrdiff_t LevelReader::index(VectorView<uint8_t> data, const std::function<void(const VectorData &, const VectorData &, const BlockHandle &)> & visit)
 {
-	std::unordered_map<uint64_t, uint64_t> block_indices;
-	uint64_t offset, size, data_size = 0;
+	BlockHandle metaindex, handle;
+	if (footer(data, metaindex, handle) != 0)
+		return -1;
+	auto block = load_block({data.data(), data.size()}, handle.offset, handle.size);
+	if (block.error || block.data.size() < sizeof(uint32_t))
+		return throwError("Unable to read index block");
+	uint64_t data_size = 0;
+	auto it = BlockParser(block.data.data(), get_block_end_pos(block.data));
+	// Each key in the index separates a block from the next one
+	std::vector<uint8_t> lower;
+	while (it.has())
 	{
-		if (data.size() < FOOTER_SIZE)
-			return throwError("Unable to read footer");
-		auto magic = endianess::fromLittle<uint64_t, const uint8_t *>(data.data() + data.size() - sizeof(uint64_t));
-		if (magic != MAGIC)
-			return throwError("Invalid magic");
-		const uint8_t * ptr = data.data() + data.size() - FOOTER_SIZE;
-		skip_block_handle(ptr); // metaindex_handle
-		std::tie(offset, size) = read_block_handle(ptr);
+		auto [upper, value] = it.next();
+		auto v = value.data();
+		auto [boffset, bsize] = read_block_handle(v);
+		data_size = std::max(data_size, boffset + bsize);
+		visit({lower.data(), lower.size()}, upper, {boffset, bsize});
+		lower.assign(upper.begin(), upper.end());
 	}
+	data_size += 5; // type and crc
+	if (data.size() < data_size)
+		return throwError("Invalid data block");
+	return 0;
+}
+
+std::ptrdiff_t LevelReader::get(VectorView<uint8_t> data, VectorView<const VectorData> keys, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	BlockHandle metaindex, handle;
+	if (footer(data, metaindex, handle) != 0)
+		return -1;
+	// Only the filter written by the builtin policy is understood
+	Block filter;
 	{
-		const uint8_t * ptr = data.data() + offset;
-		auto type = ptr[size];
-		auto block = load_block_type(type, {ptr, size});
-		auto it = BlockParser(block.data(), get_block_end_pos(block));
+		auto block = load_block({data.data(), data.size()}, metaindex.offset, metaindex.size);
+		if (block.error)
+			return throwError("Unable to read metaindex block");
+		// Tables without a filter may have an empty metaindex
+		auto end = block.data.size() >= sizeof(uint32_t) ? get_block_end_pos(block.data) : block.data.data();
+		BlockParser it(block.data.data(), end);
 		while (it.has())
 		{
-			auto v = it.next().second.data();
-			auto [boffset, bsize] = read_block_handle(v);
-			data_size = std::max(data_size, boffset + bsize);
-			block_indices.insert(std::make_pair(boffset, bsize));
+			auto [key, value] = it.next();
+			if (std::string_view(reinterpret_cast<const char *>(key.data()), key.size()) != FILTER_NAME)
+				continue;
+			auto v = value.data();
+			auto [foffset, fsize] = read_block_handle(v);
+			filter = load_block({data.data(), data.size()}, foffset, fsize);
+			if (filter.error)
+				return throwError("Unable to read filter block");
 		}
-		data_size += 5; // type and crc
-		if (data.size() < data_size)
-			return throwError("Invalid data block");
-		data = {data.data(), data_size};
 	}
 
-	for (auto it : block_indices)
+	// Find the blocks that may contain any of the keys
+	std::vector<std::pair<BlockHandle, VectorView<const VectorData>>> handles;
+	auto key = keys.begin();
+	auto ret = index(data, [&](const VectorData &, const VectorData & upper, const BlockHandle & block) {
+		// Keys up to the separator are in this block, if anywhere
+		auto last = std::find_if(key, keys.end(), [bound = userKey(upper)](const VectorData & k) {
+			return compare_keys(k, bound) > 0;
+		});
+		bool maybe = std::any_of(key, last, [&](const VectorData & k) {
+			return filter.data.empty() || filter_may_contain(filter.data, block.offset, k);
+		});
+		if (maybe)
+			handles.emplace_back(block, VectorView<const VectorData>{key, std::size_t(last - key)});
+		key = last;
+	});
+	if (ret != 0)
+		return ret;
+
+	for (const auto & [block_handle, block_keys] : handles)
 	{
-		auto block = load_block(
-			{data.data(), data.size()},
-			it.first, it.second);
-		if (block.empty())
+		auto block = load_block({data.data(), data.size()}, block_handle.offset, block_handle.size);
+		if (block.error || block.data.size() < sizeof(uint32_t))
 			return throwError("Unable to read block");
-		BlockParser kit(block.data(), get_block_end_pos(block));
-		while (kit.has())
+		auto k = block_keys.begin();
+		BlockParser it(block.data.data(), get_block_end_pos(block.data));
+		while (it.has() && k != block_keys.end())
 		{
-			auto next = kit.next();
+			auto [entry, value] = it.next();
+			auto user = userKey(entry);
+			while (k != block_keys.end() && compare_keys(*k, user) < 0)
+				++k;
+			// Newest entry comes first
+			if (k != block_keys.end() && compare_keys(*k, user) == 0)
+			{
+				visit(entry, value);
+				++k;
+			}
+		}
+	}
+	return 0;
+}
+
+std::ptrdiff_t LevelReader::scan(VectorView<uint8_t> data, VectorView<const KeyRange> ranges, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	// Find the blocks overlapping any of the ranges
+	std::vector<BlockHandle> handles;
+	auto range = ranges.begin();
+	auto ret = index(data, [&](const VectorData & lower, const VectorData & upper, const BlockHandle & block) {
+		// Entries of the same key may continue from the previous block
+		auto first = userKey(lower);
+		while (range != ranges.end() && !lower.empty() && compare_keys(range->upper, first) < 0)
+			++range;
+		if (range != ranges.end() && compare_keys(range->lower, userKey(upper)) <= 0)
+			handles.push_back(block);
+	});
+	if (ret != 0)
+		return ret;
 
-			visit(next.first, next.second);
+	// Newest entry comes first, so skip the rest of the same key
+	std::vector<uint8_t> previous;
+	bool has_previous = false;
+	range = ranges.begin();
+	for (const auto & handle : handles)
+	{
+		auto block = load_block({data.data(), data.size()}, handle.offset, handle.size);
+		if (block.error || block.data.size() < sizeof(uint32_t))
+			return throwError("Unable to read block");
+		BlockParser it(block.data.data(), get_block_end_pos(block.data));
+		while (it.has() && range != ranges.end())
+		{
+			auto [entry, value] = it.next();
+			auto user = userKey(entry);
+			while (range != ranges.end() && compare_keys(range->upper, user) < 0)
+				++range;
+			if (range == ranges.end() || compare_keys(range->lower, user) > 0)
+				continue;
+			if (has_previous && compare_keys({previous.data(), previous.size()}, user) == 0)
+				continue;
+			previous.assign(user.begin(), user.end());
+			has_previous = true;
+			visit(entry, value);
+		}
+	}
+	return 0;
+}
+
+std::ptrdiff_t LevelReader::parse(VectorView<uint8_t> data, VectorView<const BlockHandle> handles, Visitor & visitor)
+{
+	return parse(data, handles, [&visitor](const VectorData & key, const VectorData & data)
+	{
+		return visitor.visit(key, data);
+	});
+}
+
+std::ptrdiff_t LevelReader::parse(VectorView<uint8_t> data, VectorView<const BlockHandle> handles, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	for (const auto & handle : handles)
+	{
+		auto block = load_block({data.data(), data.size()}, handle.offset, handle.size);
+		if (block.error || block.data.size() < sizeof(uint32_t))
+			return throwError("Unable to read block");
+		BlockParser kit(block.data.data(), get_block_end_pos(block.data));
+		while (kit.has())
+		{
+			auto [key, value] = kit.next();
+			visit(key, value);
 		}
 	}
 	return 0;
@@ -343,108 +822,207 @@ std::ptrdiff_t Reader::throwError(const std::string & err)
 }
 
 
-std::ptrdiff_t LogReader::parse(VectorView<uint8_t> data, std::function<void(const std::vector<uint8_t> &, const VectorData &)> visit)
+std::ptrdiff_t LogReader::parse(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &)> visit)
+{
+	return entries(data, [&visit](const VectorData & key, const VectorData & value, uint8_t) {
+		visit(key, value);
+	});
+}
+
+std::ptrdiff_t LogReader::entries(VectorView<uint8_t> data, std::function<void(const VectorData &, const VectorData &, uint8_t)> visit)
+{
+	return parseRecords(data, [this, &visit](const VectorData & record) {
+		return parseBatch(record, visit);
+	});
+}
+
+std::ptrdiff_t LogReader::parseRecords(VectorView<uint8_t> data, const std::function<std::ptrdiff_t(const VectorData &)> & visit)
+{
+	// Only records split over several blocks are put together
+	std::vector<uint8_t> fragment;
+	bool in_fragment = false;
+	uint64_t it = 0;
+	while (it + HEADER_SIZE <= data.size())
+	{
+		// Block trailer too small for a header
+		auto left = BLOCK_SIZE - it % BLOCK_SIZE;
+		if (left < HEADER_SIZE)
+		{
+			it += left;
+			continue;
+		}
+		auto checksum = endianess::fromLittle<uint32_t>(data.data() + it);
+		it += sizeof(checksum);
+		auto length = endianess::fromLittle<uint16_t>(data.data() + it);
+		it += sizeof(length);
+		auto type = *(data.data() + it);
+		it += sizeof(type);
+		if (it + length > data.size()) // EOF
+			break;
+		VectorData record{data.data() + it, length};
+		switch (type)
+		{
+		case TYPE_FULL:
+			if (in_fragment)
+				return throwError("Full, in fragment");
+			if (visit(record) < 0)
+				return -1;
+			break;
+		case TYPE_FIRST:
+			if (in_fragment)
+				return throwError("First, in fragment");
+			fragment.assign(record.begin(), record.end());
+			in_fragment = true;
+			break;
+		case TYPE_MIDDLE:
+			if (!in_fragment)
+				return throwError("Middle, no fragment");
+			fragment.insert(fragment.end(), record.begin(), record.end());
+			break;
+		case TYPE_LAST:
+			if (!in_fragment)
+				return throwError("Last, no fragment");
+			fragment.insert(fragment.end(), record.begin(), record.end());
+			if (visit({fragment.data(), fragment.size()}) < 0)
+				return -1;
+			in_fragment = false;
+			break;
+		default:
+			return throwError(fmt::format("Unknown type {:d}", type));
+		}
+		it += length;
+	}
+	return 0;
+}
+
+std::ptrdiff_t LogReader::parseBatch(const VectorData & batch, const std::function<void(const VectorData &, const VectorData &, uint8_t)> & visit)
 {
-	std::vector<std::vector<uint8_t>> blocks;
+	if (batch.size() < 12)
+		return 0;
+	auto ptr = batch.data();
+	auto end = batch.data() + batch.size();
+	auto sequence = endianess::fromLittle<uint64_t>(ptr);
+	ptr += sizeof(sequence);
+	auto count = endianess::fromLittle<uint32_t>(ptr);
+	ptr += sizeof(count);
+	while (ptr < end)
 	{
-		uint64_t it = 0;
-		std::vector<uint8_t> block;
-		uint8_t prev_type = TYPE_ZERO;
-		while (it + HEADER_SIZE < data.size())
+		auto tag = *ptr;
+		ptr += sizeof(tag);
+		VectorData key, value;
+		switch (tag)
 		{
-			if (it % BLOCK_SIZE > BLOCK_SIZE - HEADER_SIZE)
+		case 0: // Delete
 			{
-				it = (it + HEADER_SIZE) % BLOCK_SIZE;
-				continue; // Check size again
+				auto key_len = leveldb::read_varint<uint32_t>(ptr);
+				if (ptr + key_len > end)
+					return 0;
+				key = VectorData(ptr, key_len);
+				ptr += key_len;
 			}
-			auto checksum = endianess::fromLittle<uint32_t>(data.data() + it);
-			it += sizeof(checksum);
-			auto length = endianess::fromLittle<uint16_t>(data.data() + it);
-			it += sizeof(length);
-			auto type = *(data.data() + it);
-			it += sizeof(type);
-			if (it + length > data.size()) // EOF
-				break;
-			switch (type)
+			break;
+		case 1: // Value
 			{
-			case TYPE_FULL:
-				if (!block.empty())
-					return throwError("Full, in fragment");
-				block.insert(block.end(), data.data() + it, data.data() + it + length);
-				blocks.emplace_back(std::move(block));
-				block.clear();
-				break;
-			case TYPE_FIRST:
-				if (!block.empty())
-					return throwError("First, in fragment");
-				block.insert(block.end(), data.data() + it, data.data() + it + length);
-				break;
-			case TYPE_MIDDLE:
-				if (block.empty() && prev_type != TYPE_FIRST)
-					return throwError("Middle, no fragment");
-				block.insert(block.end(), data.data() + it, data.data() + it + length);
-				break;
-			case TYPE_LAST:
-				if (block.empty())
-					return throwError("Last, no fragment");
-				block.insert(block.end(), data.data() + it, data.data() + it + length);
-				blocks.emplace_back(std::move(block));
-				block.clear();
-				break;
-			default:
-				return throwError(fmt::format("Unknown type {:d}", type));
+				auto key_len = leveldb::read_varint<uint32_t>(ptr);
+				if (ptr + key_len > end)
+					return 0;
+				key = VectorData(ptr, key_len);
+				ptr += key_len;
+				auto val_len = leveldb::read_varint<uint32_t>(ptr);
+				if (ptr + val_len > end)
+					return 0;
+				value = VectorData(ptr, val_len);
+				ptr += val_len;
 			}
-			it += length;
-			prev_type = type;
+			break;
+		default:
+			return throwError(fmt::format("Unknown tag {:d}", tag));
 		}
+		visit(key, value, tag);
 	}
+	return 0;
+}
 
-	for (const auto & block : blocks)
+
+std::ptrdiff_t ManifestReader::parse(std::vector<uint8_t> & data, Version & version)
+{
+	return parse({data.data(), data.size()}, version);
+}
+std::ptrdiff_t ManifestReader::parse(VectorView<uint8_t> data, Version & version)
+{
+	version = {};
+	std::map<uint64_t, Version::File> files;
+	auto ret = parseRecords(data, [this, &files, &version](const VectorData & edit) {
+		return parseEdit(edit, files, version);
+	});
+	if (ret != 0)
+		return ret;
+	if (version.logNumber == 0 && files.empty())
+		return throwError("Empty manifest");
+	version.files.reserve(files.size());
+	for (auto & file : files)
+		version.files.emplace_back(std::move(file.second));
+	return 0;
+}
+
+std::ptrdiff_t ManifestReader::parseEdit(const VectorData & edit, std::map<uint64_t, Version::File> & files, Version & version)
+{
+	auto ptr = edit.data();
+	auto end = edit.data() + edit.size();
+	while (ptr < end)
 	{
-		if (block.size() < 12)
-			continue;
-		const uint8_t * ptr = block.data();
-		auto sequence = endianess::fromLittle<uint64_t>(ptr);
-		ptr += sizeof(sequence);
-		auto count = endianess::fromLittle<uint32_t>(ptr);
-		ptr += sizeof(count);
-		while (ptr < block.data() + block.size())
+		uint64_t tag, level, number, size;
+		VectorData smallest, largest;
+		if (!read_varint_bounded(ptr, end, tag))
+			return throwError("Invalid tag");
+		bool valid = true;
+		switch (tag)
 		{
-			auto tag = *ptr;
-			ptr += sizeof(tag);
-			std::vector<uint8_t> key;
-			VectorData value;
-			switch (tag)
+		case TAG_COMPARATOR:
+			valid = read_string_bounded(ptr, end, smallest);
+			break;
+		case TAG_LOG_NUMBER:
+			valid = read_varint_bounded(ptr, end, version.logNumber);
+			break;
+		case TAG_NEXT_FILE_NUMBER:
+			valid = read_varint_bounded(ptr, end, version.nextFileNumber);
+			break;
+		case TAG_LAST_SEQUENCE:
+			valid = read_varint_bounded(ptr, end, version.lastSequence);
+			break;
+		case TAG_COMPACT_POINTER:
+			valid = read_varint_bounded(ptr, end, level)
+				&& read_string_bounded(ptr, end, smallest);
+			break;
+		case TAG_DELETED_FILE:
+			valid = read_varint_bounded(ptr, end, level)
+				&& read_varint_bounded(ptr, end, number);
+			if (valid)
 			{
-			case 0: // Delete
-				{
-					auto key_len = leveldb::read_varint<int32_t>(ptr);
-					if (ptr + key_len > block.data() + block.size())
-						continue;
-					key.assign(ptr, ptr + key_len);
-					ptr += key_len;
-					value = {};
-				}
-				break;
-			case 1: // Value
-				{
-					auto key_len = leveldb::read_varint<int32_t>(ptr);
-					if (ptr + key_len > block.data() + block.size())
-						continue;
-					key.assign(ptr, ptr + key_len);
-					ptr += key_len;
-					auto val_len = leveldb::read_varint<int32_t>(ptr);
-					if (ptr + val_len > block.data() + block.size())
-						continue;
-					value = VectorData(ptr, val_len);
-					ptr += val_len;
-				}
-				break;
-			default:
-				return throwError(fmt::format("Unknown tag {:d}", tag));
+				auto it = files.find(number);
+				if (it != files.end() && it->second.level == int(level))
+					files.erase(it);
 			}
-			visit(key, value);
+			break;
+		case TAG_NEW_FILE:
+			valid = read_varint_bounded(ptr, end, level)
+				&& read_varint_bounded(ptr, end, number)
+				&& read_varint_bounded(ptr, end, size)
+				&& read_string_bounded(ptr, end, smallest)
+				&& read_string_bounded(ptr, end, largest);
+			if (valid)
+				files[number] = {int(level), number, size,
+					{smallest.begin(), smallest.end()},
+					{largest.begin(), largest.end()}};
+			break;
+		case TAG_PREV_LOG_NUMBER:
+			valid = read_varint_bounded(ptr, end, version.prevLogNumber);
+			break;
+		default:
+			return throwError(fmt::format("Unknown tag {:d}", tag));
 		}
+		if (!valid)
+			return throwError(fmt::format("Invalid edit for tag {:d}", tag));
 	}
 	return 0;
 }
@@ -455,7 +1033,7 @@ BlockParser::BlockParser(const uint8_t * begin, const uint8_t * end)
 	: ptr(begin), end(end)
 {
 }
-std::pair<std::vector<uint8_t>, LevelDB::VectorData> BlockParser::next()
+std::pair<LevelDB::VectorData, LevelDB::VectorData> BlockParser::next()
 {
 	if (!has())
 		return {};
@@ -464,22 +1042,57 @@ std::pair<std::vector<uint8_t>, LevelDB::VectorData> BlockParser::next()
 	auto unshared_bytes = leveldb::read_varint<uint32_t>(ptr);
 	auto value_length = leveldb::read_varint<uint32_t>(ptr);
 	// Get key
-	decltype(prev_key) key;
-	key.reserve(shared_bytes + unshared_bytes);
-	key.insert(key.end(), prev_key.begin(), prev_key.begin() + shared_bytes);
+	key.resize(std::min<std::size_t>(shared_bytes, key.size()));
 	key.insert(key.end(), ptr, ptr + unshared_bytes);
 	ptr += unshared_bytes;
 	// Get value
 	LevelDB::VectorData data = {ptr, value_length};
 	ptr += value_length;
-	prev_key = key;
-	return std::make_pair(key, data);
+	return std::make_pair(LevelDB::VectorData{key.data(), key.size()}, data);
 }
 bool BlockParser::has() const
 {
 	return ptr != end;
 }
 
+bool read_varint_bounded(const uint8_t *& ptr, const uint8_t * end, uint64_t & value)
+{
+	// Make sure the varint ends before the data does
+	auto last = std::find_if(ptr, std::min(end, ptr + MAX_VARINT_SIZE), [](uint8_t b) {
+		return (b & 128) == 0;
+	});
+	if (last == end || last == ptr + MAX_VARINT_SIZE)
+		return false;
+	value = leveldb::read_varint<uint64_t>(ptr);
+	return true;
+}
+
+bool read_string_bounded(const uint8_t *& ptr, const uint8_t * end, LevelDB::VectorData & value)
+{
+	uint64_t length;
+	if (!read_varint_bounded(ptr, end, length) || length > uint64_t(end - ptr))
+		return false;
+	value = {ptr, std::size_t(length)};
+	ptr += length;
+	return true;
+}
+
+bool parse_file_number(const std::string & name, uint64_t & number)
+{
+	char * end = nullptr;
+	number = std::strtoull(name.c_str(), &end, 10);
+	return end != name.c_str() && *end == '.';
+}
+
+int compare_keys(const LevelDB::VectorData & a, const LevelDB::VectorData & b)
+{
+	auto size = (std::min)(a.size(), b.size());
+	auto cmp = size == 0 ? 0 : std::memcmp(a.data(), b.data(), size);
+	if (cmp != 0)
+		return cmp;
+	return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
 inline std::tuple<uint64_t, uint64_t> read_block_handle(const uint8_t *& ptr)
 {
 	auto offset = leveldb::read_varint<uint64_t>(ptr);
@@ -487,62 +1100,137 @@ inline std::tuple<uint64_t, uint64_t> read_block_handle(const uint8_t *& ptr)
 	return std::make_tuple(offset, size);
 }
 
-inline void skip_block_handle(const uint8_t *& ptr)
+bool filter_may_contain(const LevelDB::VectorData & filter, uint64_t offset, const LevelDB::VectorData & key)
+{
+	/*
+	filters: uint8[n][num_filters]
+	filter_offsets: uint32[num_filters]
+	offsets_start: uint32
+	base_lg: uint8
+	*/
+	if (filter.size() < 5)
+		return true;
+	auto end = filter.data() + filter.size();
+	auto base_lg = *(end - 1);
+	auto offsets_start = endianess::fromLittle<uint32_t>(end - 5);
+	if (offsets_start > filter.size() - 5)
+		return true;
+	auto num = (filter.size() - 5 - offsets_start) / sizeof(uint32_t);
+	auto index = offset >> base_lg;
+	if (index >= num)
+		return true;
+	auto offsets = filter.data() + offsets_start;
+	auto start = endianess::fromLittle<uint32_t>(offsets + index * sizeof(uint32_t));
+	auto limit = index + 1 < num ? endianess::fromLittle<uint32_t>(offsets + (index + 1) * sizeof(uint32_t)) : offsets_start;
+	if (start > limit || limit > offsets_start)
+		return true;
+	// Empty filters contain no keys
+	if (limit - start < 2)
+		return false;
+
+	// Bloom filter with the amount of probes last
+	auto bits = filter.data() + start;
+	std::size_t bit_count = (limit - start - 1) * 8;
+	auto probes = bits[limit - start - 1];
+	if (probes > 30) // Reserved for new encodings
+		return true;
+	auto h = bloom_hash(key);
+	auto delta = (h >> 17) | (h << 15);
+	for (uint8_t i = 0; i < probes; ++i)
+	{
+		auto pos = h % bit_count;
+		if ((bits[pos / 8] & (1 << (pos % 8))) == 0)
+			return false;
+		h += delta;
+	}
+	return true;
+}
+
+uint32_t bloom_hash(const LevelDB::VectorData & key)
 {
-	leveldb::skip_varint(ptr);
-	leveldb::skip_varint(ptr);
+	constexpr uint32_t m = 0xc6a4a793;
+	auto ptr = key.data();
+	auto end = key.data() + key.size();
+	uint32_t h = BLOOM_SEED ^ uint32_t(key.size() * m);
+	for (; ptr + 4 <= end; ptr += 4)
+	{
+		h += endianess::fromLittle<uint32_t>(ptr);
+		h *= m;
+		h ^= h >> 16;
+	}
+	switch (end - ptr)
+	{
+	case 3:
+		h += uint32_t(ptr[2]) << 16;
+		[[fallthrough]];
+	case 2:
+		h += uint32_t(ptr[1]) << 8;
+		[[fallthrough]];
+	case 1:
+		h += ptr[0];
+		h *= m;
+		h ^= h >> 24;
+		break;
+	}
+	return h;
 }
 
-inline const uint8_t * get_block_end_pos(const std::vector<uint8_t> & block)
+inline const uint8_t * get_block_end_pos(LevelDB::VectorData block)
 {
+	// Note: Blocks too small for their restarts have no entries
+	if (block.size() < sizeof(uint32_t))
+		return block.data();
 	auto num_restarts = endianess::fromLittle<uint32_t>(block.data() + block.size() - sizeof(uint32_t));
+	if (num_restarts > block.size() / sizeof(uint32_t) - 1)
+		return block.data();
 	auto size = block.size() - ((sizeof(uint32_t) * num_restarts) + sizeof(uint32_t));
 	return block.data() + size;
 }
 
-/*std::vector<uint8_t> load_block(const std::vector<uint8_t> & data, uint64_t offset, uint64_t size)
-{
-	return load_block({data.data(), data.size()}, offset, size);
-}*/
-
-std::vector<uint8_t> load_block(LevelDB::VectorData data, uint64_t offset, uint64_t size)
+Block load_block(LevelDB::VectorData data, uint64_t offset, uint64_t size)
 {
 	if (offset + size + 1 > data.size())
-		return {};
+	{
+		Block block;
+		block.error = true;
+		return block;
+	}
 	auto ptr = data.data() + offset;
 	auto type = *(ptr + size);
 	auto block = load_block_type(type, {ptr, size});
 	return block;
 }
 
-[[maybe_unused]]
-inline std::vector<uint8_t> load_block_type(uint8_t type, const std::vector<uint8_t> & data)
-{
-	return load_block_type(type, {data.data(), data.size()});
-}
-
-std::vector<uint8_t> load_block_type(uint8_t type, LevelDB::VectorData data)
+Block load_block_type(uint8_t type, LevelDB::VectorData data)
 {
+	// Blocks are written up to the same size, so decompress into the size
+	// of recent blocks, slowly forgetting any unusually large one
+	thread_local std::size_t estimate = 0;
+	Block block;
 	switch (type)
 	{
 	case COMPRESSOR_RAW:
-		return std::vector<uint8_t>{data.begin(), data.end()};
-		break;
+		// Nothing to decompress, so use it as is
+		block.data = data;
+		return block;
 	case COMPRESSOR_ZLIB:
-		return Compression::loadZLib(data);
+		block.error = !Compression::loadZLib(data, block.storage, estimate);
 		break;
 	case COMPRESSOR_ZLIBRAW:
-		return Compression::loadZLibRaw(data);
+		block.error = !Compression::loadZLibRaw(data, block.storage, estimate);
 		break;
 	case COMPRESSOR_SNAPPY:
-		spdlog::error("Snappy not supported");
+		block.error = !Compression::loadSnappy(data, block.storage);
 		break;
 	case COMPRESSOR_ZSTD:
-		spdlog::error("ZSTD not supported");
+		block.error = !Compression::loadZstd(data, block.storage, estimate);
 		break;
 	default:
 		spdlog::error("Unknown type: {:d}", type);
+		block.error = true;
 		break;
 	}
-	return {};
+	estimate = (std::max)(estimate - estimate / 8, block.storage.size());
+	block.data = {block.storage.data(), block.storage.size()};
+	return block;
 }
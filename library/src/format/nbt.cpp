@@ -1,8 +1,8 @@
 #include "format/nbt.hpp"
+#include "format/nbtparser.hpp"
 
 #include "util/endianess.hpp"
 
-#include <stack>
 #include <limits>
 #include <algorithm>
 #include <fmt/core.h>
@@ -25,34 +25,23 @@ template<typename T, uint32_t bytes = sizeof(T)>
 T read_number(ItType *& ptr, NBT::Endianess endian);
 // Read a string
 NBT::NBTString read_string(ItType *& ptr, NBT::Endianess endian);
-// Read a specific data
-template<typename T, uint32_t bytes = sizeof(T)>
-T read_data(ItType *& ptr);
-// Read a list
-template<typename T>
-NBT::NBTArray<T> read_list(ItType *& ptr, NBT::Endianess endian);
 // Transform a list
-template<typename T, class InputIt>
-void transform_list(InputIt first, InputIt last, NBT::Endianess endian);
-
-// Skip a number
-template<typename T, uint32_t bytes = sizeof(T)>
-void skip_number(ItType *& ptr);
-// Skip a string
-void skip_string(ItType *& ptr, NBT::Endianess endian);
-// Skip a list
 template<typename T>
-void skip_list(ItType *& ptr, NBT::Endianess endian);
+void transform_list(T * data, std::size_t count, NBT::Endianess endian);
 
-// Read a tag
-template<class T>
-bool read_tag(ItType *& ptr, UndefinedType type, NBT::Tag & tag, std::stack<T> & stack, NBT::Endianess endian);
 // Read a value
 template<class T>
-bool read_value(ItType *& ptr, UndefinedType type, NBT::Value & value, std::stack<T> & stack, NBT::Endianess endian);
-// Skip a value
-template<class T>
-bool skip_value(ItType *& ptr, UndefinedType type, NBT::Value & value, std::stack<T> & stack, NBT::Endianess endian);
+bool read_value(ItType *& ptr, UndefinedType type, NBT::Value & value, T & stack, NBT::Endianess endian);
+// Skip a value, checking that it is within the data
+bool skip_payload(ItType *& ptr, const ItType * end, UndefinedType type, NBT::Endianess endian, std::size_t depth);
+// Parse the root compound, only reading what matches the query
+bool parse_query(ItType *& ptr, const ItType * end, const NBT::Query & query, NBT::Visitor & visitor, NBT::Endianess endian, std::string & error);
+// Parse a single tag with everything within it
+bool parse_tag(ItType *& ptr, const ItType * end, NBT::Visitor & visitor, NBT::Endianess endian, std::string & error);
+// Add the tags of a compound to an index, skipping past their values
+bool index_compound(ItType *& ptr, const ItType * begin, const ItType * end, NBT::Endianess endian, std::vector<NBT::IndexEntry> & entries, uint32_t parent, std::size_t depth);
+
+using NBT::detail::MAX_DEPTH;
 
 
 
@@ -67,14 +56,12 @@ std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, Visitor & visitor, End
 
 std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, Visitor & visitor, Endianess endian)
 {
-	return parse(data, [&visitor](const Tag & tag)
+	switch (endian)
 	{
-		return visitor.visit(tag);
+	case Endianess::BIG: return parse<Endianess::BIG>(data, visitor);
+	case Endianess::LITTLE: return parse<Endianess::LITTLE>(data, visitor);
 	}
-	,[&visitor](const Value & value)
-	{
-		return visitor.visit(value);
-	}, endian);
+	return throwError("Invalid endianess");
 }
 
 // Parse data and send it to a pair of functions
@@ -84,164 +71,175 @@ std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, std::function<bool(con
 }
 
 std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, std::function<bool(const Tag &)> tag_visit, std::function<bool(const Value &)> value_visit, Endianess endian)
+{
+	struct Functions
+	{
+		std::function<bool(const Tag &)> & tag;
+		std::function<bool(const Value &)> & value;
+		bool visit(const Tag & t) { return tag && tag(t); }
+		bool visit(const Value & v) { return value && value(v); }
+	} functions{tag_visit, value_visit};
+
+	switch (endian)
+	{
+	case Endianess::BIG: return parse<Endianess::BIG>(data, functions);
+	case Endianess::LITTLE: return parse<Endianess::LITTLE>(data, functions);
+	}
+	return throwError("Invalid endianess");
+}
+
+// Parse data matching a query and send it to a visitor
+std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, const Query & query, Visitor & visitor, Endianess endian)
+{
+	return parse({data.data(), data.size()}, query, visitor, endian);
+}
+
+std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, const Query & query, Visitor & visitor, Endianess endian)
+{
+	ItType * ptr = data.data();
+
+	if (data.empty() || *ptr != TAG_Compound)
+		return throwError("Invalid start of stream");
+
+	std::string err;
+	if (!parse_query(ptr, data.data() + data.size(), query, visitor, endian, err))
+		return throwError(err);
+
+	return std::distance(data.data(), ptr);
+}
+
+// Index the tags of the compounds
+std::ptrdiff_t Reader::index(std::vector<uint8_t> & data, Index & index, Endianess endian)
+{
+	return this->index({data.data(), data.size()}, index, endian);
+}
+
+std::ptrdiff_t Reader::index(VectorView<uint8_t> data, Index & index, Endianess endian)
 {
 	ItType * ptr = data.data();
+	const ItType * end = data.data() + data.size();
+	index.clear();
+
+	if (data.empty() || *ptr != TAG_Compound)
+		return throwError("Invalid start of stream");
+	if (data.size() > std::numeric_limits<uint32_t>::max())
+		return throwError("Too large to index");
+
+	++ptr;
+	if (!skip_payload(ptr, end, TAG_String, endian, 0))
+		return throwError("Reached end of stream");
+	if (!index_compound(ptr, data.data(), end, endian, index.items, Index::ROOT, 1))
+		return throwError("Invalid type found");
+
+	return std::distance(data.data(), ptr);
+}
+
+// Parse a single indexed tag
+std::ptrdiff_t Reader::parse(std::vector<uint8_t> & data, const IndexEntry & entry, Visitor & visitor, Endianess endian)
+{
+	return parse({data.data(), data.size()}, entry, visitor, endian);
+}
+
+std::ptrdiff_t Reader::parse(VectorView<uint8_t> data, const IndexEntry & entry, Visitor & visitor, Endianess endian)
+{
+	if (std::size_t(entry.offset) + entry.length > data.size() || data[entry.offset] != entry.type)
+		return throwError("Index does not match the data");
+
+	ItType * ptr = data.data() + entry.offset;
+	std::string err;
+	if (!parse_tag(ptr, data.data() + entry.offset + entry.length, visitor, endian, err))
+		return throwError(err);
+
+	return std::distance(data.data(), ptr);
+}
+
+// Scan data, only reading tags directly within entered compounds
+std::ptrdiff_t Reader::scan(std::vector<uint8_t> & data, std::function<Scan(const Tag &)> tag_visit, Endianess endian)
+{
+	return scan({data.data(), data.size()}, tag_visit, endian);
+}
+
+std::ptrdiff_t Reader::scan(VectorView<uint8_t> data, std::function<Scan(const Tag &)> tag_visit, Endianess endian)
+{
+	ItType * ptr = data.data();
+	const ItType * end = data.data() + data.size();
 	Tag tag(endian);
-	Value value(endian);
-	bool skip_tag = false;
-	size_t skip_depth = 0;
+	std::size_t depth = 0;
 
+	// Only used for structures, which are never read here
 	struct StackData
 	{
 		UndefinedType tag;
-		int32_t list_size; // Negative value is a compound
+		int32_t list_size;
 	};
-	std::stack<StackData> stack;
+	NBT::detail::Stack<StackData, 1> stack;
 
-	UndefinedType type;
-
-	// Read first element
-	type = read_type(ptr);
-	if (type != TAG_Compound)
+	if (data.empty() || *ptr != TAG_Compound)
 		return throwError("Invalid start of stream");
-	tag.setName(std::move(read_string(ptr, endian)));
-	if (!read_value(ptr, type, tag, stack, endian))
-		return throwError("Invalid type found");
-	skip_tag = tag_visit && tag_visit(tag);
 
-	while (ptr < data.data() + data.size() && !stack.empty())
+	do
 	{
-		// List
-		if (!stack.empty() && stack.top().list_size > 0)
+		if (ptr >= end)
+			return throwError("Reached end of stream");
+		auto type = read_type(ptr);
+		if (type == TAG_End)
 		{
-			type = stack.top().tag;
+			--depth;
+			continue;
+		}
 
-			// Primitives in lists
-			if (type != TAG_Compound)
-				--stack.top().list_size;
+		auto name = ptr;
+		if (!skip_payload(ptr, end, TAG_String, endian, 0))
+			return throwError("Reached end of stream");
+		tag.setName(read_string(name, endian));
 
-			if (skip_tag && skip_depth <= stack.size())
-			{
-				if (!skip_value(ptr, type, value, stack, endian))
-					return throwError("Invalid type found");
-			}
-			else
+		auto start = ptr;
+		switch (type)
+		{
+		case TAG_Compound:
+			tag.Value::set(TAG_Compound, 0);
+			break;
+		case TAG_List:
+			if (end - ptr < 5)
+				return throwError("Reached end of stream");
 			{
-				skip_tag = false;
-				skip_depth = 0;
-
-				if (!read_value(ptr, type, value, stack, endian))
-					return throwError("Invalid type found");
-
-				try
-				{
-					skip_tag = value_visit && value_visit(value);
-				}
-				catch (std::bad_variant_access & e)
-				{
-					return throwError(fmt::format("Invalid value of list with type {:d}", int32_t(value.type())));
-				}
-
-				if (skip_tag)
-				{
-					switch (type)
-					{
-					case TAG_List:
-						if (tag.count() == 0)
-						{
-							stack.pop();
-							skip_tag = false;
-							skip_depth = 0;
-							break;
-						}
-						[[fallthrough]];
-					case TAG_Compound:
-						skip_depth = stack.size();
-						break;
-					// May only be able to skip complex types
-					default:
-						skip_tag = false;
-						skip_depth = 0;
-						break;
-					}
-				}
+				auto count = ptr + 1;
+				tag.Value::set(TAG_List, read_number<int32_t>(count, endian));
 			}
+			break;
+		default:
+			// Check that it fits before reading it
+			if (!skip_payload(ptr, end, type, endian, 0))
+				return throwError("Invalid type found");
+			if (!read_value(start, type, tag, stack, endian))
+				return throwError("Invalid type found");
+			break;
+		}
 
-			// Primitives in lists
-			if (type != TAG_Compound)
-			{
-				// End of list
-				if (stack.top().list_size == 0)
-					stack.pop();
-			}
+		Scan action = Scan::SKIP;
+		try
+		{
+			action = tag_visit(tag);
 		}
-		// Compound
-		else
+		catch (std::bad_variant_access & e)
 		{
-			type = read_type(ptr);
-
-			if (skip_tag && skip_depth <= stack.size())
-			{
-				if (type != TAG_End)
-					skip_string(ptr, endian);
-				if (!skip_value(ptr, type, value, stack, endian))
-					return throwError("Invalid type found");
-			}
-			else
-			{
-				if (!read_tag(ptr, type, tag, stack, endian))
-					return throwError("Invalid type found");
-
-				skip_tag = false;
-				skip_depth = 0;
-
-				try
-				{
-					skip_tag = tag_visit && tag_visit(tag);
-				}
-				catch (std::bad_variant_access & e)
-				{
-					return throwError(fmt::format("Invalid type for {:s}", tag.getName()));
-				}
-
-				if (skip_tag)
-				{
-					switch (type)
-					{
-					case TAG_List:
-						if (tag.count() == 0)
-						{
-							skip_tag = false;
-							skip_depth = 0;
-							break;
-						}
-						[[fallthrough]];
-					case TAG_Compound:
-						skip_depth = stack.size();
-						break;
-						// May only be able to skip complex types
-					default:
-						skip_depth = 0;
-						skip_tag = false;
-						break;
-					}
-				}
-			}
-
-			// Handle lists
-			if (type == TAG_End && !stack.empty() && stack.top().list_size > 0)
-			{
-				--stack.top().list_size;
+			return throwError(fmt::format("Invalid type for {:s}", tag.getName()));
+		}
 
-				// End of list
-				if (stack.top().list_size == 0)
-					stack.pop();
-			}
+		if (action == Scan::STOP)
+			break;
+		if (type == TAG_Compound && action == Scan::ENTER)
+		{
+			if (++depth > MAX_DEPTH)
+				return throwError("Too deep nesting");
+		}
+		else if (type == TAG_Compound || type == TAG_List)
+		{
+			if (!skip_payload(ptr, end, type, endian, depth))
+				return throwError("Invalid type found");
 		}
 	}
-
-	if (!stack.empty())
-		return throwError("Reached end of stream");
+	while (depth > 0);
 
 	return std::distance(data.data(), ptr);
 }
@@ -257,265 +255,513 @@ std::ptrdiff_t Reader::throwError(const std::string & err)
 // Read a type
 inline UndefinedType read_type(ItType *&ptr)
 {
-	return static_cast<UndefinedType>(read_data<int8_t>(ptr));
+	return NBT::detail::read_type(ptr);
 }
 
 // Read a number
 template<typename T, uint32_t bytes>
 T read_number(ItType *&ptr, NBT::Endianess endian)
 {
-	T value{};
 	switch (endian)
 	{
-	case NBT::Endianess::BIG: value = endianess::fromBig<T, ItType *, bytes>(ptr); break;
-	case NBT::Endianess::LITTLE: value = endianess::fromLittle<T, ItType *, bytes>(ptr); break;
+	case NBT::Endianess::BIG: return NBT::detail::read_number<NBT::Endianess::BIG, T, bytes>(ptr);
+	case NBT::Endianess::LITTLE: return NBT::detail::read_number<NBT::Endianess::LITTLE, T, bytes>(ptr);
 	}
-	ptr += bytes;
-	return value;
+	return T{};
 }
 
 // Read a string
 inline NBT::NBTString read_string(ItType *&ptr, NBT::Endianess endian)
 {
-	auto len = static_cast<std::size_t>(read_number<uint16_t>(ptr, endian));
-	NBT::NBTString name(reinterpret_cast<const char *>(ptr), len);
-	ptr += len;
-	return name;
-}
-
-// Read data
-template<typename T, uint32_t bytes>
-T read_data(ItType *&ptr)
-{
-	auto value = *reinterpret_cast<const T *>(ptr);
-	ptr += bytes;
-	return value;
-}
-
-// Read a list
-template<typename T>
-NBT::NBTArray<T> read_list(ItType *&ptr, NBT::Endianess endian)
-{
-	auto len = static_cast<std::size_t>(read_number<int32_t>(ptr, endian));
-	ItType * _ptr = ptr;
-	auto p = reinterpret_cast<T *>(_ptr);
-	NBT::NBTArray<T> values(p, p + len);
-	ptr += sizeof(T) * len;
-	return values;
+	switch (endian)
+	{
+	case NBT::Endianess::BIG: return NBT::detail::read_string<NBT::Endianess::BIG>(ptr);
+	case NBT::Endianess::LITTLE: return NBT::detail::read_string<NBT::Endianess::LITTLE>(ptr);
+	}
+	return {};
 }
 
 // Transform a list
-template<typename T, class InputIt>
-void transform_list(InputIt first, InputIt last, NBT::Endianess endian)
+template<typename T>
+void transform_list(T * data, std::size_t count, NBT::Endianess endian)
 {
 	switch (endian)
 	{
 	case NBT::Endianess::BIG:
-		std::transform(first, last, first,
-			[](auto & v) { return endianess::fromBig<T>(reinterpret_cast<uint8_t *>(&v)); });
+		endianess::fromBigArray(data, count);
 		break;
 	case NBT::Endianess::LITTLE:
-		std::transform(first, last, first,
-			[](auto & v) { return endianess::fromLittle<T>(reinterpret_cast<uint8_t *>(&v)); });
+		endianess::fromLittleArray(data, count);
 		break;
 	}
 }
 
-// Skip a number
-template<typename T, uint32_t bytes>
-void skip_number(ItType *&ptr)
-{
-	ptr += bytes;
-}
-
-// Skip a string
-inline void skip_string(ItType *&ptr, NBT::Endianess endian)
+// Read a value
+template<class T>
+bool read_value(ItType *&ptr, UndefinedType type, NBT::Value & value, T & stack, NBT::Endianess endian)
 {
-	ptr += read_number<int16_t>(ptr, endian);
+	switch (endian)
+	{
+	case NBT::Endianess::BIG: return NBT::detail::read_value<NBT::Endianess::BIG>(ptr, type, value, stack);
+	case NBT::Endianess::LITTLE: return NBT::detail::read_value<NBT::Endianess::LITTLE>(ptr, type, value, stack);
+	}
+	return false;
 }
 
-// Skip a list
-template<typename T>
-void skip_list(ItType *&ptr, NBT::Endianess endian)
+// Size of types with a fixed size, otherwise 0
+static std::size_t fixed_size(UndefinedType type)
 {
-	ptr += sizeof(T) * static_cast<std::size_t>(read_number<int32_t>(ptr, endian));
+	using namespace NBT;
+	switch (type)
+	{
+	case TAG_Byte: return sizeof(int8_t);
+	case TAG_Short: return sizeof(int16_t);
+	case TAG_Int: return sizeof(int32_t);
+	case TAG_Long: return sizeof(int64_t);
+	case TAG_Float: return sizeof(float);
+	case TAG_Double: return sizeof(double);
+	default: return 0;
+	}
 }
 
-// Read a tag
-template<class T>
-bool read_tag(ItType *&ptr, UndefinedType type, NBT::Tag & tag, std::stack<T> & stack, NBT::Endianess endian)
+// Skip a value, checking that it is within the data
+bool skip_payload(ItType *&ptr, const ItType * end, UndefinedType type, NBT::Endianess endian, std::size_t depth)
 {
-	static const NBT::NBTString empty_name("");
-	// Special handling for end tag
-	if (type != NBT::TAG_End)
-		tag.setName(read_string(ptr, endian));
-	else
-		tag.setName(empty_name);
+	using namespace NBT;
+	auto skip = [&ptr, end](std::size_t bytes)
+	{
+		if (bytes > std::size_t(end - ptr))
+			return false;
+		ptr += bytes;
+		return true;
+	};
+	auto skip_array = [&ptr, end, endian, &skip](std::size_t size)
+	{
+		if (end - ptr < 4)
+			return false;
+		auto len = read_number<int32_t>(ptr, endian);
+		return len >= 0 && skip(size * std::size_t(len));
+	};
 
-	return read_value(ptr, type, tag, stack, endian);
-}
+	if (auto size = fixed_size(type))
+		return skip(size);
 
-// Read a value
-template<class T>
-bool read_value(ItType *&ptr, UndefinedType type, NBT::Value & value, std::stack<T> & stack, NBT::Endianess endian)
-{
-	using namespace NBT;
 	switch (type)
 	{
-	case TAG_End:
-		value.set();
-		stack.pop();
-		break;
-	case TAG_Byte:
-		value.set(read_number<int8_t>(ptr, endian));
-		break;
-	case TAG_Short:
-		value.set(read_number<int16_t>(ptr, endian));
-		break;
-	case TAG_Int:
-		value.set(read_number<int32_t>(ptr, endian));
-		break;
-	case TAG_Long:
-		value.set(read_number<int64_t>(ptr, endian));
-		break;
-	case TAG_Float:
-		value.set(read_number<float>(ptr, endian));
-		break;
-	case TAG_Double:
-		value.set(read_number<double>(ptr, endian));
-		break;
 	case TAG_Byte_Array:
-		value.set(read_list<int8_t>(ptr, endian));
-		break;
+		return skip_array(sizeof(int8_t));
+	case TAG_Int_Array:
+		return skip_array(sizeof(int32_t));
+	case TAG_Long_Array:
+		return skip_array(sizeof(int64_t));
 	case TAG_String:
-		value.set(read_string(ptr, endian));
-		break;
+		if (end - ptr < 2)
+			return false;
+		return skip(read_number<uint16_t>(ptr, endian));
 	case TAG_List:
 		{
+			if (end - ptr < 5 || depth >= MAX_DEPTH)
+				return false;
 			auto tag_type = read_type(ptr);
 			auto count = read_number<int32_t>(ptr, endian);
-			value.set(TAG_List, count);
-			// Only add for list with actual values
-			if (count > 0)
-				stack.push({ tag_type, count });
+			if (count <= 0)
+				return true;
+			// Optimization for primitives
+			if (auto size = fixed_size(tag_type))
+				return skip(size * std::size_t(count));
+			for (int32_t i = 0; i < count; ++i)
+				if (!skip_payload(ptr, end, tag_type, endian, depth + 1))
+					return false;
+			return true;
 		}
-		break;
 	case TAG_Compound:
-		value.set(TAG_Compound, 0);
-		stack.push({ TAG_Compound, -1 });
-		break;
-	case TAG_Int_Array:
-		value.set(read_list<int32_t>(ptr, endian));
-		break;
-	case TAG_Long_Array:
-		value.set(read_list<int64_t>(ptr, endian));
-		break;
+		if (depth >= MAX_DEPTH)
+			return false;
+		for (;;)
+		{
+			if (ptr >= end)
+				return false;
+			auto tag_type = read_type(ptr);
+			if (tag_type == TAG_End)
+				return true;
+			if (!skip_payload(ptr, end, TAG_String, endian, depth) ||
+				!skip_payload(ptr, end, tag_type, endian, depth + 1))
+				return false;
+		}
 	default:
 		return false;
 	}
-	return true;
 }
 
-// Skip a value
-template<class T>
-bool skip_value(ItType *&ptr, UndefinedType type, NBT::Value &, std::stack<T> & stack, NBT::Endianess endian)
+/*
+ * Parses the structures matching a query, where everything else is skipped
+ * by its size without being read
+ */
+class QueryParser
 {
-	using namespace NBT;
-	switch (type)
+public:
+	QueryParser(const NBT::Query & _query, NBT::Visitor & _visitor, const ItType * _end, NBT::Endianess _endian)
+		: query(_query), visitor(_visitor), end(_end), endian(_endian), tag(_endian), value(_endian)
 	{
-	case TAG_End:
-		stack.pop();
-		break;
-	case TAG_Byte:
-		skip_number<int8_t>(ptr);
-		break;
-	case TAG_Short:
-		skip_number<int16_t>(ptr);
-		break;
-	case TAG_Int:
-		skip_number<int32_t>(ptr);
-		break;
-	case TAG_Long:
-		skip_number<int64_t>(ptr);
-		break;
-	case TAG_Float:
-		skip_number<float>(ptr);
-		break;
-	case TAG_Double:
-		skip_number<double>(ptr);
-		break;
-	case TAG_Byte_Array:
-		skip_list<int8_t>(ptr, endian);
-		break;
-	case TAG_String:
-		skip_string(ptr, endian);
-		break;
-	case TAG_List:
+	}
+
+	// Parse the root compound, or a tag with everything within it
+	bool parse(ItType *& ptr, std::size_t node = NBT::Query::ROOT)
+	{
+		auto type = read_type(ptr);
+		if (!readName(ptr))
+			return false;
+		return read(ptr, type, tag, node, 0);
+	}
+
+	std::string error;
+
+private:
+	const NBT::Query & query;
+	NBT::Visitor & visitor;
+	const ItType * end;
+	NBT::Endianess endian;
+	NBT::Tag tag;
+	NBT::Value value;
+	// Names read within the root
+	std::size_t found = 0;
+	bool stopped = false;
+
+	// Only used for structures, which are never read with it
+	struct StackData
+	{
+		UndefinedType tag;
+		int32_t list_size;
+	};
+	NBT::detail::Stack<StackData, 1> stack;
+
+	bool fail(const std::string & err)
+	{
+		error = err;
+		return false;
+	}
+
+	bool readName(ItType *& ptr)
+	{
+		auto name = ptr;
+		if (!skip_payload(ptr, end, NBT::TAG_String, endian, 0))
+			return fail("Reached end of stream");
+		tag.setName(read_string(name, endian));
+		return true;
+	}
+
+	// Read a value and visit it, continuing into structures with node
+	template<class T>
+	bool read(ItType *& ptr, UndefinedType type, T & current, std::size_t node, std::size_t depth)
+	{
+		using namespace NBT;
+		UndefinedType list_type = TAG_End;
+		int32_t count = 0;
+		switch (type)
 		{
-			auto tag_type = read_type(ptr);
-			// Optimization for primitives
-			switch (tag_type)
+		case TAG_Compound:
+			current.Value::set(TAG_Compound, 0);
+			break;
+		case TAG_List:
+			if (end - ptr < 5)
+				return fail("Reached end of stream");
+			list_type = read_type(ptr);
+			count = (std::max)(read_number<int32_t>(ptr, endian), 0);
+			current.Value::set(TAG_List, count);
+			break;
+		default:
 			{
-			case TAG_Byte:
-				skip_list<int8_t>(ptr, endian);
-				break;
-			case TAG_Short:
-				skip_list<int16_t>(ptr, endian);
-				break;
-			case TAG_Int:
-				skip_list<int32_t>(ptr, endian);
-				break;
-			case TAG_Long:
-				skip_list<int64_t>(ptr, endian);
-				break;
-			case TAG_Float:
-				skip_list<float>(ptr, endian);
-				break;
-			case TAG_Double:
-				skip_list<double>(ptr, endian);
-				break;
-			case TAG_Byte_Array:
-			case TAG_String:
-			case TAG_List:
-			case TAG_Compound:
-			case TAG_Int_Array:
-			case TAG_Long_Array:
-			case TAG_End:
-				{
-					auto count = read_number<int32_t>(ptr, endian);
-					// Only add for list with actual values
-					if (count > 0)
-						stack.push({ tag_type, count });
-				}
-				break;
-			default:
+				// Check that it fits before reading it
+				auto start = ptr;
+				if (!skip_payload(ptr, end, type, endian, 0) ||
+					!read_value(start, type, current, stack, endian))
+					return fail("Invalid type found");
+			}
+			break;
+		}
+
+		bool skip = false;
+		try
+		{
+			skip = visitor.visit(current);
+		}
+		catch (std::bad_variant_access & e)
+		{
+			return fail(fmt::format("Invalid type {:d}", int32_t(current.type())));
+		}
+
+		switch (type)
+		{
+		case TAG_Compound:
+			if (skip)
+				return skip_payload(ptr, end, type, endian, depth) || fail("Invalid type found");
+			return compound(ptr, node, depth + 1);
+		case TAG_List:
+			if (skip)
+				return skipElements(ptr, list_type, count, depth) || fail("Invalid type found");
+			return list(ptr, list_type, count, node, depth + 1);
+		default:
+			return true;
+		}
+	}
+
+	// Read the tags of a compound
+	bool compound(ItType *& ptr, std::size_t node, std::size_t depth)
+	{
+		using namespace NBT;
+		if (depth > MAX_DEPTH)
+			return fail("Too deep nesting");
+		for (;;)
+		{
+			if (ptr >= end)
+				return fail("Reached end of stream");
+			auto type = read_type(ptr);
+			if (type == TAG_End)
+			{
+				tag.set();
+				visitor.visit(tag);
+				return true;
+			}
+
+			if (!readName(ptr))
 				return false;
+			auto child = query.match(node, tag.getName());
+			if (child == Query::NONE)
+			{
+				if (!skip_payload(ptr, end, type, endian, depth))
+					return fail("Invalid type found");
+				continue;
 			}
+
+			if (!read(ptr, type, tag, child, depth))
+				return false;
+			// Everything requested has been read
+			if (!stopped && node == Query::ROOT && ++found == query.size(node))
+				stopped = true;
+			if (stopped)
+				return true;
 		}
-		break;
-	case TAG_Compound:
-		stack.push({ TAG_Compound, -1 });
-		break;
-	case TAG_Int_Array:
-		skip_list<int32_t>(ptr, endian);
-		break;
-	case TAG_Long_Array:
-		skip_list<int64_t>(ptr, endian);
-		break;
-	default:
-		return false;
 	}
-	return true;
+
+	// Read the elements of a list
+	bool list(ItType *& ptr, UndefinedType type, int32_t count, std::size_t node, std::size_t depth)
+	{
+		if (depth > MAX_DEPTH)
+			return fail("Too deep nesting");
+		for (int32_t i = 0; i < count && !stopped; ++i)
+			if (!read(ptr, type, value, node, depth))
+				return false;
+		return true;
+	}
+
+	// Skip the elements of a list
+	bool skipElements(ItType *& ptr, UndefinedType type, int32_t count, std::size_t depth)
+	{
+		// Optimization for primitives
+		if (auto size = fixed_size(type))
+		{
+			if (size * std::size_t(count) > std::size_t(end - ptr))
+				return false;
+			ptr += size * std::size_t(count);
+			return true;
+		}
+		for (int32_t i = 0; i < count; ++i)
+			if (!skip_payload(ptr, end, type, endian, depth + 1))
+				return false;
+		return true;
+	}
+};
+
+// Parse the root compound, only reading what matches the query
+bool parse_query(ItType *& ptr, const ItType * end, const NBT::Query & query, NBT::Visitor & visitor, NBT::Endianess endian, std::string & error)
+{
+	QueryParser parser(query, visitor, end, endian);
+	if (parser.parse(ptr))
+		return true;
+	error = parser.error;
+	return false;
+}
+
+// Parse a single tag with everything within it
+bool parse_tag(ItType *& ptr, const ItType * end, NBT::Visitor & visitor, NBT::Endianess endian, std::string & error)
+{
+	// Never used, as everything matches
+	static const NBT::Query all{};
+	QueryParser parser(all, visitor, end, endian);
+	if (parser.parse(ptr, NBT::Query::ALL))
+		return true;
+	error = parser.error;
+	return false;
 }
 
+// Add the tags of a compound to an index, skipping past their values
+bool index_compound(ItType *& ptr, const ItType * begin, const ItType * end, NBT::Endianess endian, std::vector<NBT::IndexEntry> & entries, uint32_t parent, std::size_t depth)
+{
+	using namespace NBT;
+	if (depth > MAX_DEPTH)
+		return false;
+	for (;;)
+	{
+		if (ptr >= end)
+			return false;
+		auto start = ptr;
+		auto type = read_type(ptr);
+		if (type == TAG_End)
+			return true;
+
+		auto name = ptr;
+		if (!skip_payload(ptr, end, TAG_String, endian, 0))
+			return false;
+		auto entry = uint32_t(entries.size());
+		entries.push_back({
+			uint32_t(start - begin), 0, parent,
+			uint16_t(ptr - name - sizeof(uint16_t)), Type(type)});
+
+		if (type == TAG_Compound)
+		{
+			if (!index_compound(ptr, begin, end, endian, entries, entry, depth + 1))
+				return false;
+		}
+		else if (!skip_payload(ptr, end, type, endian, depth))
+			return false;
+		entries[entry].length = uint32_t(ptr - start);
+	}
+}
 
 namespace NBT
 {
 
+/*
+ * Index
+ */
+
+const IndexEntry * Index::find(VectorView<uint8_t> data, std::string_view path) const
+{
+	auto parent = ROOT;
+	// Tags within a compound follow it until it ends
+	std::size_t first = 0, last = items.size();
+	for (;;)
+	{
+		auto dot = path.find('.');
+		auto name = path.substr(0, dot);
+		const IndexEntry * found = nullptr;
+		for (auto i = first; i < last && !found; ++i)
+		{
+			auto & entry = items[i];
+			if (entry.parent != parent || entry.name_length != name.size())
+				continue;
+			// Name follows the type and its length
+			auto offset = std::size_t(entry.offset) + sizeof(uint8_t) + sizeof(uint16_t);
+			if (offset + entry.name_length > data.size())
+				return nullptr;
+			if (name == NBTString(reinterpret_cast<const char *>(data.data() + offset), entry.name_length))
+				found = &entry;
+		}
+		if (!found || dot == std::string_view::npos)
+			return found;
+
+		path.remove_prefix(dot + 1);
+		parent = uint32_t(found - items.data());
+		first = last = parent + 1;
+		while (last < items.size() && items[last].offset < found->offset + found->length)
+			++last;
+	}
+}
+
+/*
+ * Query
+ */
+
+Query::Query(std::initializer_list<std::string_view> paths)
+	: nodes(1)
+{
+	for (auto path : paths)
+		add(path);
+}
+
+std::size_t Query::match(std::size_t node, const NBTString & name) const
+{
+	if (node == ALL)
+		return ALL;
+	for (auto child : nodes[node].children)
+		if (nodes[child].name == name)
+			return nodes[child].leaf ? ALL : child;
+	return NONE;
+}
+
+std::size_t Query::size(std::size_t node) const
+{
+	return node == ALL ? 0 : nodes[node].children.size();
+}
+
+void Query::add(std::string_view path)
+{
+	// Expand alternatives into separate paths
+	auto open = path.find('{');
+	auto close = path.find('}', open);
+	if (open != std::string_view::npos && close != std::string_view::npos)
+	{
+		std::string prefix(path.substr(0, open));
+		auto names = path.substr(open + 1, close - open - 1);
+		auto suffix = path.substr(close + 1);
+		for (std::size_t start = 0;;)
+		{
+			auto comma = names.find(',', start);
+			add(prefix + std::string(names.substr(start, comma - start)) + std::string(suffix));
+			if (comma == std::string_view::npos)
+				break;
+			start = comma + 1;
+		}
+		return;
+	}
+
+	std::size_t node = ROOT;
+	for (std::size_t start = 0;;)
+	{
+		auto dot = path.find('.', start);
+		auto name = path.substr(start, dot - start);
+		// Elements of lists are matched against the rest of the path
+		if (name.size() >= 2 && name.substr(name.size() - 2) == "[]")
+			name.remove_suffix(2);
+		node = insert(node, name);
+		if (dot == std::string_view::npos)
+			break;
+		start = dot + 1;
+	}
+	nodes[node].leaf = true;
+}
+
+std::size_t Query::insert(std::size_t node, std::string_view name)
+{
+	for (auto child : nodes[node].children)
+		if (nodes[child].name == name)
+			return child;
+	nodes.push_back({std::string(name), {}});
+	nodes[node].children.push_back(nodes.size() - 1);
+	return nodes.size() - 1;
+}
+
 /*
  * Value
  */
 
+Value::Value(const Value & other)
+	: endian(other.endian)
+{
+	*this = other;
+}
+
+Value & Value::operator=(const Value & other)
+{
+	// Otherwise both would transform the same data
+	other.transform();
+	value = other.value;
+	_type = other._type;
+	endian = other.endian;
+	_transformed = true;
+	return *this;
+}
+
 void Value::set(Type t, int32_t size)
 {
 	_type = t;
@@ -524,7 +770,6 @@ void Value::set(Type t, int32_t size)
 void Value::set()
 {
 	_type = TAG_End;
-	value.reset();
 }
 void Value::set(int8_t v)
 {
@@ -586,7 +831,7 @@ bool Value::transformed() const
 	{
 	case TAG_Int_Array:
 	case TAG_Long_Array:
-		return *_transformed;
+		return _transformed;
 	default:
 		// All other types are transformed per default
 		return true;
@@ -597,28 +842,19 @@ void Value::transform() const
 {
 	if (transformed())
 		return;
-	*_transformed = true;
-	auto ptr = value.get();
+	_transformed = true;
 	switch (_type)
 	{
 	case TAG_Int_Array:
 		{
-			#ifdef USE_VARIANT
-			auto array = std::get_if<NBTIntArray>(ptr);
-			#else
-			auto array = reinterpret_cast<NBTIntArray *>(ptr);
-			#endif
-			transform_list<int32_t>(array->begin(), array->end(), endian);
+			auto array = std::get<NBTIntArray>(value);
+			transform_list(array.data(), array.size(), endian);
 		}
 		break;
 	case TAG_Long_Array:
 		{
-			#ifdef USE_VARIANT
-			auto array = std::get_if<NBTLongArray>(ptr);
-			#else
-			auto array = reinterpret_cast<NBTLongArray *>(ptr);
-			#endif
-			transform_list<int64_t>(array->begin(), array->end(), endian);
+			auto array = std::get<NBTLongArray>(value);
+			transform_list(array.data(), array.size(), endian);
 		}
 		break;
 	default:
@@ -633,16 +869,19 @@ void Value::transform() const
 void Tag::set()
 {
 	name = {};
+	_identified = false;
 	Value::set();
 }
 
 void Tag::setName(const NBTString &str)
 {
 	name = str;
+	_identified = false;
 }
 void Tag::setName(const NBTString &&str)
 {
 	name = str;
+	_identified = false;
 }
 const NBTString &Tag::getName() const
 {
@@ -8,22 +8,52 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
-#include <regex>
+#include <algorithm>
+#include <charconv>
+#include <thread>
 
 // The size of a chunk
 constexpr uint32_t CHUNK_SIZE = 4096;
 constexpr uint32_t HEADER_CHUNKS = 2;
 constexpr uint32_t HEADER_SIZE = CHUNK_SIZE * HEADER_CHUNKS;
 
+// Index of region headers
+constexpr uint32_t INDEX_MAGIC = 0x58494D50; // PMIX
+constexpr uint32_t INDEX_VERSION = 3;
+
 /*
  * Internal functionality
  */
 uint32_t getHeader(int x, int z);
 uint32_t getIndex(int x, int z);
+bool getFileStamp(const std::filesystem::directory_entry & entry, uint64_t & size, int64_t & modified);
 
 namespace region
 {
 
+bool parseFileName(std::string_view name, RegionType type, int & x, int & z)
+{
+	std::string_view extension = type == RegionType::ANVIL ? ".mca" : ".mcr";
+	if (name.size() < 2 + extension.size() || name.substr(0, 2) != "r.")
+		return false;
+	if (!string::endsWith(name, extension))
+		return false;
+	auto first = name.data() + 2;
+	auto last = name.data() + name.size() - extension.size();
+	auto result = std::from_chars(first, last, x);
+	if (result.ec != std::errc() || result.ptr == last || *result.ptr != '.')
+		return false;
+	result = std::from_chars(result.ptr + 1, last, z);
+	return result.ec == std::errc() && result.ptr == last;
+}
+
+std::string getIndexFile(const std::string & output, bool folder)
+{
+	if (folder)
+		return platform::path::join(output, INDEX_FILE);
+	return (std::filesystem::path(output).parent_path() / INDEX_FILE).string();
+}
+
 const std::string_view ChunkData::getCustomFormat() const
 {
 	if (compression_type != COMPRESSION_CUSTOM)
@@ -33,20 +63,14 @@ const std::string_view ChunkData::getCustomFormat() const
 	return {p+2, len};
 }
 
-Region::Region(const std::string& path, RegionType type) noexcept :
-	path(path), type(type)
+Region::Region(const std::string& path, RegionType type, const std::string & index, bool writable) noexcept :
+	path(path), type(type), index(index, path, writable)
 {
 }
 
 int Region::getChunkTimestamp(int x, int z)
 {
-	auto pos = std::make_pair(x >> 5, z >> 5);
-	auto it = regions.find(pos);
-	if (it == regions.end())
-	{
-		regions.insert(std::make_pair(pos, std::make_shared<RegionFile>(pos.first, pos.second, type)));
-		it = regions.find(pos);
-	}
+	auto it = findRegion(x >> 5, z >> 5);
 	it->second->open(path);
 	auto timestamp = it->second->getChunkTimestamp(x & 31, z & 31);
 	it->second->close();
@@ -55,19 +79,37 @@ int Region::getChunkTimestamp(int x, int z)
 
 std::shared_ptr<ChunkData> Region::getChunk(int x, int z)
 {
-	auto pos = std::make_pair(x >> 5, z >> 5);
-	auto it = regions.find(pos);
-	if (it == regions.end())
-	{
-		regions.insert(std::make_pair(pos, std::make_shared<RegionFile>(pos.first, pos.second, type)));
-		it = regions.find(pos);
-	}
+	auto it = findRegion(x >> 5, z >> 5);
 	it->second->open(path);
 	auto chunk = it->second->getChunk(x & 31, z & 31);
 	it->second->close();
 	return chunk;
 }
 
+std::vector<std::shared_ptr<ChunkData>> Region::getChunks(const std::vector<std::pair<int, int>> & positions)
+{
+	std::vector<std::shared_ptr<ChunkData>> chunks(positions.size());
+	// Get all chunks of a region at once
+	std::map<std::pair<int, int>, std::vector<std::size_t>> regionChunks;
+	for (std::size_t i = 0; i < positions.size(); ++i)
+		regionChunks[{positions[i].first >> 5, positions[i].second >> 5}].push_back(i);
+	for (const auto & [pos, indices] : regionChunks)
+	{
+		auto it = findRegion(pos.first, pos.second);
+		if (!it->second->open(path))
+			continue;
+		std::vector<std::pair<int, int>> local;
+		local.reserve(indices.size());
+		for (auto i : indices)
+			local.emplace_back(positions[i].first & 31, positions[i].second & 31);
+		auto found = it->second->getChunks(local);
+		for (std::size_t i = 0; i < indices.size(); ++i)
+			chunks[indices[i]] = std::move(found[i]);
+		it->second->close();
+	}
+	return chunks;
+}
+
 Region::iterator Region::begin()
 {
 	// Get all files
@@ -97,12 +139,8 @@ void Region::populateFromPath()
 		return;
 
 	regions.clear();
+	index.load();
 
-	std::regex r;
-	if (type == RegionType::ANVIL)
-		r = "^r\\.(-?[0-9]+)\\.(-?[0-9]+)\\.mca$";
-	else if (type == RegionType::BETA)
-		r = "^r\\.(-?[0-9]+)\\.(-?[0-9]+)\\.mcr$";
 	std::error_code ec;
 	for (const auto & entry : std::filesystem::directory_iterator{path, ec})
 	{
@@ -110,27 +148,235 @@ void Region::populateFromPath()
 		if (entry.is_directory())
 			continue;
 
-		auto name = entry.path().filename().string();
-		std::smatch m;
-		if (!std::regex_match(name, m, r))
+		int x, z;
+		if (!parseFileName(entry.path().filename().string(), type, x, z))
 			continue;
-		if (m.size() != 3)
+
+		auto file = std::make_shared<RegionFile>(x, z, type);
+		regions.emplace(std::make_pair(x, z), file);
+
+		// Use the indexed header, or read it if the file has changed
+		uint64_t size;
+		int64_t modified;
+		if (!getFileStamp(entry, size, modified))
 			continue;
+		auto indexed = index.find(type, x, z, size, modified);
+		if (indexed)
+		{
+			file->loadHeader(*indexed);
+		}
+		else if (size < HEADER_SIZE)
+		{
+			// Too small to contain any chunks
+			RegionIndex::Entry header;
+			header.size = size;
+			header.modified = modified;
+			file->loadHeader(header);
+			index.update(type, x, z, std::move(header));
+		}
+		else if (file->open(path))
+		{
+			auto header = file->storeHeader();
+			header.size = size;
+			header.modified = modified;
+			index.update(type, x, z, std::move(header));
+			file->close();
+		}
+	}
 
-		int x, z;
+	std::vector<std::pair<int, int>> existing;
+	existing.reserve(regions.size());
+	for (const auto & region : regions)
+		existing.emplace_back(region.first);
+	index.retain(type, existing);
+	index.save();
+}
 
-		try
+Region::RegionsMap::iterator Region::findRegion(int x, int z)
+{
+	auto pos = std::make_pair(x, z);
+	auto it = regions.lower_bound(pos);
+	if (it == regions.end() || it->first != pos)
+		it = regions.emplace_hint(it, pos, std::make_shared<RegionFile>(x, z, type));
+	return it;
+}
+
+
+
+/*
+ * Note: The index is stored as little endian with the following layout:
+ * magic, version, amount of region folders, and then for each folder the
+ * length and path of it, amount of entries, and then for each entry the
+ * type, position, file size, modified time and amount of chunks, followed
+ * by each chunk with its index, location and timestamp.
+ */
+RegionIndex::RegionIndex(const std::string & _file, const std::string & _source, bool _writable) noexcept :
+	file(_file), source(_source), writable(_writable)
+{
+}
+
+bool RegionIndex::load()
+{
+	if (loaded)
+		return true;
+	loaded = true;
+	if (file.empty())
+		return false;
+
+	std::ifstream in(file, std::ios::in | std::ios::binary);
+	if (!in.is_open())
+		return false;
+	std::vector<uint8_t> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+	const uint8_t * ptr = data.data();
+	const uint8_t * end = ptr + data.size();
+	auto read = [&ptr, end](auto & value)
+	{
+		using T = std::make_unsigned_t<std::remove_reference_t<decltype(value)>>;
+		if (ptr + sizeof(T) > end)
+			return false;
+		value = static_cast<std::remove_reference_t<decltype(value)>>(endianess::fromLittle<T>(ptr));
+		ptr += sizeof(T);
+		return true;
+	};
+
+	uint32_t magic = 0, version = 0, folders_count = 0;
+	if (!read(magic) || magic != INDEX_MAGIC)
+		return false;
+	if (!read(version) || version != INDEX_VERSION)
+		return false;
+	if (!read(folders_count))
+		return false;
+
+	std::map<std::string, std::map<Key, Entry>> _folders;
+	for (uint32_t f = 0; f < folders_count; ++f)
+	{
+		uint16_t length = 0;
+		uint32_t count = 0;
+		if (!read(length) || ptr + length > end)
+			return false;
+		auto & entries = _folders[std::string(reinterpret_cast<const char *>(ptr), length)];
+		ptr += length;
+		if (!read(count))
+			return false;
+		for (uint32_t n = 0; n < count; ++n)
 		{
-			x = std::stoi(m[1].str());
-			z = std::stoi(m[2].str());
+			uint8_t type;
+			int32_t x, z;
+			uint16_t amount;
+			Entry entry;
+			if (!read(type) || !read(x) || !read(z) || !read(entry.size) || !read(entry.modified) || !read(amount))
+				return false;
+			entry.chunks.resize(amount);
+			for (auto & chunk : entry.chunks)
+				if (!read(chunk.i) || !read(chunk.location) || !read(chunk.timestamp) || chunk.i >= (CHUNK_SIZE >> 2))
+					return false;
+			entries.emplace(Key{RegionType(type), x, z}, std::move(entry));
 		}
-		catch(...)
+	}
+
+	folders.swap(_folders);
+	return true;
+}
+
+bool RegionIndex::save()
+{
+	if (!dirty)
+		return true;
+	if (file.empty() || !writable)
+		return false;
+
+	std::vector<uint8_t> data;
+	auto write = [&data](auto value)
+	{
+		using T = std::make_unsigned_t<decltype(value)>;
+		uint8_t bytes[sizeof(T)];
+		endianess::toLittle<T>(T(value), bytes);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	};
+
+	write(INDEX_MAGIC);
+	write(INDEX_VERSION);
+	write(uint32_t(folders.size()));
+	for (const auto & folder : folders)
+	{
+		write(uint16_t(folder.first.size()));
+		data.insert(data.end(), folder.first.begin(), folder.first.end());
+		write(uint32_t(folder.second.size()));
+		for (const auto & it : folder.second)
 		{
-			continue;
+			write(uint8_t(std::get<0>(it.first)));
+			write(int32_t(std::get<1>(it.first)));
+			write(int32_t(std::get<2>(it.first)));
+			write(it.second.size);
+			write(it.second.modified);
+			write(uint16_t(it.second.chunks.size()));
+			for (const auto & chunk : it.second.chunks)
+			{
+				write(chunk.i);
+				write(chunk.location);
+				write(chunk.timestamp);
+			}
 		}
+	}
+
+	// Write to a temporary file, to never leave a broken index
+	// Note: Unique per thread, as several renders may save the same index
+	auto tmp = file + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(file).parent_path(), ec);
+	{
+		std::ofstream out(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+		out.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+		if (!out.good())
+			return false;
+	}
+	std::filesystem::rename(tmp, file, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tmp, ec);
+		return false;
+	}
+
+	dirty = false;
+	return true;
+}
+
+const RegionIndex::Entry * RegionIndex::find(RegionType type, int x, int z, uint64_t size, int64_t modified) const
+{
+	auto folder = folders.find(source);
+	if (folder == folders.end())
+		return nullptr;
+	auto it = folder->second.find(Key{type, x, z});
+	if (it == folder->second.end())
+		return nullptr;
+	if (it->second.size != size || it->second.modified != modified)
+		return nullptr;
+	return &it->second;
+}
+
+void RegionIndex::update(RegionType type, int x, int z, Entry && entry)
+{
+	folders[source][Key{type, x, z}] = std::move(entry);
+	dirty = true;
+}
 
-		auto pos = std::make_pair(x, z);
-		regions.insert(std::make_pair(pos, std::make_shared<RegionFile>(pos.first, pos.second, type)));
+void RegionIndex::retain(RegionType type, const std::vector<std::pair<int, int>> & existing)
+{
+	auto & entries = folders[source];
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		if (std::get<0>(it->first) == type && !std::binary_search(existing.begin(), existing.end(), std::make_pair(std::get<1>(it->first), std::get<2>(it->first))))
+		{
+			it = entries.erase(it);
+			dirty = true;
+		}
+		else
+		{
+			++it;
+		}
 	}
 }
 
@@ -145,7 +391,24 @@ RegionFile::RegionFile(int x, int z,  RegionType type) noexcept :
 bool RegionFile::open(const std::string & _path)
 {
 	path = _path;
-	return openFile(platform::path::join(path, file()));
+	auto file_path = platform::path::join(path, file());
+	// Header is already known, so open the file first when needed
+	if (header_loaded)
+	{
+		uint64_t size;
+		int64_t modified;
+		std::error_code ec;
+		if (getFileStamp(std::filesystem::directory_entry{file_path, ec}, size, modified) &&
+			size == header_size && modified == header_modified)
+		{
+			setFile(file_path);
+			return true;
+		}
+		// Changed since the header was loaded
+		header_loaded = false;
+		clear();
+	}
+	return openFile(file_path);
 }
 
 bool RegionFile::openFile(const std::string & file)
@@ -163,8 +426,8 @@ std::string RegionFile::file() const
 
 void RegionFile::clear()
 {
-	cache.clear();
-	decltype(cache)().swap(cache);
+	cache = VectorData{};
+	unload();
 }
 
 uint64_t RegionFile::getModifiedTimestamp() const
@@ -176,7 +439,65 @@ uint64_t RegionFile::getModifiedTimestamp() const
 
 std::shared_ptr<ChunkData> RegionFile::getChunk(int x, int z)
 {
-	return getChunk(headers[getIndex(x, z)]);
+	return getChunks({{x, z}}).front();
+}
+
+std::vector<std::shared_ptr<ChunkData>> RegionFile::getChunks(const std::vector<std::pair<int, int>> & positions)
+{
+	std::vector<std::shared_ptr<ChunkData>> chunks(positions.size());
+	// Already in memory, with the chunks keeping the content alive
+	if (!cache.empty())
+	{
+		for (std::size_t i = 0; i < positions.size(); ++i)
+			chunks[i] = getChunk(headers[getIndex(positions[i].first, positions[i].second)]);
+		return chunks;
+	}
+	if (!ensureOpen())
+		return chunks;
+
+	// Read in file order, so that neighbouring chunks are read together
+	std::vector<std::pair<const Header *, std::size_t>> order;
+	order.reserve(positions.size());
+	for (std::size_t i = 0; i < positions.size(); ++i)
+	{
+		const auto & header = headers[getIndex(positions[i].first, positions[i].second)];
+		if (header.offset >= HEADER_CHUNKS && header.sector_count > 0)
+			order.emplace_back(&header, i);
+	}
+	std::sort(order.begin(), order.end(), [](const auto & a, const auto & b) {
+		return a.first->offset < b.first->offset;
+	});
+	for (std::size_t first = 0, last; first < order.size(); first = last)
+	{
+		uint64_t begin = order[first].first->offset;
+		uint64_t end = begin + order[first].first->sector_count;
+		for (last = first + 1; last < order.size() && order[last].first->offset <= end; ++last)
+			end = (std::max)(end, uint64_t(order[last].first->offset + order[last].first->sector_count));
+		// Note: The last sector is not always padded
+		auto offset = begin * CHUNK_SIZE;
+		if (offset >= size())
+		{
+			setError("Offset outside of file");
+			continue;
+		}
+		auto length = (std::min)((end - begin) * CHUNK_SIZE, size() - offset);
+		auto storage = std::make_shared<std::vector<uint8_t>>(length);
+		seek(offset);
+		if (!read(storage->data(), storage->size()))
+			continue;
+		for (auto i = first; i < last; ++i)
+		{
+			const auto & header = *order[i].first;
+			auto start = (header.offset - begin) * CHUNK_SIZE;
+			auto chunk = readChunk(header, {storage->data() + start, storage->size() - start});
+			if (!chunk)
+				continue;
+			if (!chunk->storage)
+				chunk->storage = storage;
+			chunks[order[i].second] = std::move(chunk);
+		}
+	}
+	return chunks;
 }
 
 bool RegionFile::containsChunk(int x, int z) const
@@ -184,6 +505,44 @@ bool RegionFile::containsChunk(int x, int z) const
 	return headers[getIndex(x, z)].offset >= 2;
 }
 
+void RegionFile::loadHeader(const RegionIndex::Entry & entry)
+{
+	Header header;
+	header.offset = 0;
+	header.sector_count = 0;
+	for (uint32_t i = 0; i < headers.size(); ++i)
+	{
+		header.i = i;
+		headers[i] = header;
+	}
+
+	amount_chunks = 0;
+	for (const auto & chunk : entry.chunks)
+	{
+		auto & h = headers[chunk.i];
+		h.offset = chunk.location >> 8;
+		h.sector_count = chunk.location & 0xFF;
+		h.timestamp = chunk.timestamp;
+		if (h.offset >= 2)
+			++amount_chunks;
+	}
+	header_size = entry.size;
+	header_modified = entry.modified;
+	header_loaded = true;
+}
+
+RegionIndex::Entry RegionFile::storeHeader() const
+{
+	RegionIndex::Entry entry;
+	for (const auto & header : headers)
+	{
+		if (header.offset == 0 && header.sector_count == 0 && header.timestamp == 0)
+			continue;
+		entry.chunks.push_back({uint16_t(header.i), (uint32_t(header.offset) << 8) | header.sector_count, header.timestamp});
+	}
+	return entry;
+}
+
 RegionFile::iterator RegionFile::begin()
 {
 	return iterator(headers.begin(), this);
@@ -228,35 +587,54 @@ bool RegionFile::loadHeader()
 		headers[i].timestamp = endianess::fromBig<int32_t>(&buffer[j]);
 	}
 
-	return false;
+	std::error_code ec;
+	if (!getFileStamp(std::filesystem::directory_entry{platform::path::join(path, file()), ec}, header_size, header_modified))
+		return true;
+	header_loaded = true;
+	return true;
 }
 
 std::shared_ptr<ChunkData> RegionFile::getChunk(const Header & header)
 {
-	std::shared_ptr<ChunkData> chunk;
-	if (!isOpen())
-		return chunk;
+	if (!ensureOpen())
+		return {};
 	if (header.offset < HEADER_CHUNKS)
-		return chunk;
+		return {};
 	preloadCache();
 	/*
 	 * Note: This supports up to 16 TB file, while 4GB would be sufficient.
 	 * All chunks together could reach a theoretical maximum of 4TB, though.
 	 */
 	auto offset = uint64_t(header.offset - HEADER_CHUNKS) * CHUNK_SIZE;
-	if (offset + 4 > cache.size())
+	if (offset > cache.size())
+	{
+		setError("Offset outside of file");
+		return {};
+	}
+	auto chunk = readChunk(header, {cache.data() + offset, cache.size() - offset});
+	// Note: The cache may be cleared while the chunk is still used
+	if (chunk && !chunk->storage)
+		chunk->storage = content();
+	return chunk;
+}
+
+std::shared_ptr<ChunkData> RegionFile::readChunk(const Header & header, VectorData sectors)
+{
+	std::shared_ptr<ChunkData> chunk;
+	if (sectors.size() < 4)
 	{
 		setError("Offset outside of file");
 		return chunk;
 	}
-	auto ptr = const_cast<const uint8_t *>(cache.data()) + offset;
+	auto ptr = sectors.data();
 	auto length = endianess::fromBig<uint32_t>(ptr);
-	if (offset + length > cache.size())
+	// Note: Length includes the compression type
+	if (length == 0 || uint64_t(length) + 4 > sectors.size())
 	{
 		setError("Chunk outside of file");
 		return chunk;
 	}
-	if (length + 4 > CHUNK_SIZE * header.sector_count)
+	if (uint64_t(length) + 4 > uint64_t(CHUNK_SIZE) * header.sector_count)
 	{
 		setError("Chunk outside of sector");
 		return chunk;
@@ -277,6 +655,8 @@ std::shared_ptr<ChunkData> RegionFile::getChunk(const Header & header)
 		if (!external_chunk->open(path))
 			return chunk;
 		chunk = external_chunk->getChunk();
+		if (chunk)
+			chunk->storage = external_chunk;
 		external_chunks.emplace_back(external_chunk);
 	}
 	else
@@ -293,11 +673,10 @@ inline void RegionFile::preloadCache()
 {
 	if (!cache.empty())
 		return;
-	auto _size = size();
-	_size -= HEADER_SIZE;
-	seek(HEADER_SIZE);
-	cache.resize(_size);
-	read(cache.data(), _size);
+	auto content = load();
+	if (content.size() <= HEADER_SIZE)
+		return;
+	cache = VectorData{content.data() + HEADER_SIZE, content.size() - HEADER_SIZE};
 }
 
 
@@ -494,3 +873,17 @@ inline uint32_t getIndex(int x, int z)
 {
 	return uint32_t((x & 31) + ((z & 31) << 5));
 }
+
+// Get the size and modified time of a file, used to know if it has changed
+bool getFileStamp(const std::filesystem::directory_entry & entry, uint64_t & size, int64_t & modified)
+{
+	std::error_code ec;
+	size = entry.file_size(ec);
+	if (ec)
+		return false;
+	auto time = entry.last_write_time(ec);
+	if (ec)
+		return false;
+	modified = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	return true;
+}
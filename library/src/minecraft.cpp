@@ -3,6 +3,7 @@
 #include "format/alpha.hpp"
 #include "format/region.hpp"
 #include "format/leveldb.hpp"
+#include "format/nbtparser.hpp"
 #include "anvil/level.hpp"
 #include "bedrock/level.hpp"
 #include "bedrock/parse.hpp"
@@ -124,7 +125,7 @@ std::vector<int32_t> getPathDimensions(const std::string & path)
 	return dimensions;
 }
 
-std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
+std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path, const std::string & index)
 {
 	auto info = std::make_shared<WorldInfo>();
 	region::RegionType type = region::RegionType::ANVIL;
@@ -140,7 +141,7 @@ std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
 			if (!data.empty())
 			{
 				anvil::LevelReader levelReader(level);
-				if (reader.parse(data, levelReader, NBT::Endianess::BIG) > 0)
+				if (reader.parse<NBT::Endianess::BIG>(data, levelReader) > 0)
 				{
 					info->game = Game::JAVA_EDITION;
 					info->name = level.getName();
@@ -160,7 +161,7 @@ std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
 	for (auto dimension : dimensions)
 	{
 		auto dimension_path = getDimensionPath(path, dimension);
-		region::Region region(dimension_path, type);
+		region::Region region(dimension_path, type, index, false);
 		WorldInfo::DimensionInfo dim{"", dimension};
 		for (auto file : region)
 		{
@@ -262,14 +263,15 @@ static void getWorldDimensions(const std::shared_ptr<WorldInfo> & info, const st
 
 	for (auto file : ldb)
 	{
-		auto block = file->readAll();
-		auto diff = reader.parse(block, [&dims](const std::vector<uint8_t> & key, const LevelDB::VectorData &){
+		auto block = file->load();
+		auto diff = reader.parse(block, [&dims](const LevelDB::VectorData & key, const LevelDB::VectorData &){
 			if (parse::mc::is_key_sub_chunk_prefix(key))
 				return;
 			parse::ChunkKey _key = parse::read_chunk_key(key);
 			int32_t dim = _key.dimension;
 			dims.try_emplace(dim, 1).first->second++;
 		});
+		file->unload();
 		if (diff < 0)
 			return;
 	}
@@ -298,7 +300,7 @@ std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
 		{
 			NBT::Reader reader;
 			bedrock::LevelReader levelReader(level);
-			if (reader.parse(data, levelReader, NBT::Endianess::LITTLE) > 0)
+			if (reader.parse<NBT::Endianess::LITTLE>(data, levelReader) > 0)
 			{
 				info->game = Game::BEDROCK_EDITION;
 				info->name = level.getName();
@@ -335,10 +337,10 @@ std::vector<std::string> getDefaultPaths()
 	return paths;
 }
 
-std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
+std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path, const std::string & index)
 {
 	if (std::filesystem::is_directory(platform::path::join(path, "region")))
-		return JE::getWorldInfo(path);
+		return JE::getWorldInfo(path, index);
 	else if (std::filesystem::is_directory(platform::path::join(path, "db")))
 		return BE::getWorldInfo(path);
 	// Not world folder, guess game version
@@ -350,7 +352,7 @@ std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
 
 		// Anvil
 		{
-			region::Region region(path);
+			region::Region region(path, region::RegionType::ANVIL, index);
 			for (auto file : region)
 				dim.amount_chunks += static_cast<decltype(dim.amount_chunks)>(file->getAmountChunks());
 
@@ -364,7 +366,7 @@ std::shared_ptr<WorldInfo> getWorldInfo(const std::string & path)
 
 		// Beta
 		{
-			region::Region region(path, region::RegionType::BETA);
+			region::Region region(path, region::RegionType::BETA, index);
 			for (auto file : region)
 				dim.amount_chunks += static_cast<decltype(dim.amount_chunks)>(file->getAmountChunks());
 
@@ -15,8 +15,10 @@
 #else
 #include <sys/resource.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
 #endif
 
 namespace platform
@@ -110,46 +112,201 @@ std::size_t max()
 
 } // fd
 
+namespace file
+{
+
+Handle open(const std::string & file)
+{
+#if defined(PLATFORM_WINDOWS)
+	auto handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return INVALID_HANDLE;
+	return reinterpret_cast<Handle>(handle);
+#elif defined(PLATFORM_UNIX)
+	auto fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return INVALID_HANDLE;
+	return Handle(fd);
+#else
+	return INVALID_HANDLE;
+#endif
+}
+
+bool tooManyOpen()
+{
+#if defined(PLATFORM_WINDOWS)
+	return GetLastError() == ERROR_TOO_MANY_OPEN_FILES;
+#elif defined(PLATFORM_UNIX)
+	return errno == EMFILE || errno == ENFILE;
+#else
+	return false;
+#endif
+}
+
+void close(Handle handle)
+{
+	if (handle == INVALID_HANDLE)
+		return;
+#if defined(PLATFORM_WINDOWS)
+	CloseHandle(reinterpret_cast<HANDLE>(handle));
+#elif defined(PLATFORM_UNIX)
+	::close(int(handle));
+#endif
+}
+
+uint64_t size(Handle handle)
+{
+#if defined(PLATFORM_WINDOWS)
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(reinterpret_cast<HANDLE>(handle), &file_size))
+		return 0;
+	return uint64_t(file_size.QuadPart);
+#elif defined(PLATFORM_UNIX)
+	struct stat st;
+	if (fstat(int(handle), &st) != 0)
+		return 0;
+	return uint64_t(st.st_size);
+#else
+	return 0;
+#endif
+}
+
+bool stat(Handle handle, uint64_t & size, int64_t & modified)
+{
+#if defined(PLATFORM_WINDOWS)
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!GetFileInformationByHandle(reinterpret_cast<HANDLE>(handle), &info))
+		return false;
+	size = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+	modified = int64_t((uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime);
+	return true;
+#elif defined(PLATFORM_UNIX)
+	struct stat st;
+	// Note: Removed or replaced files no longer belong to their path
+	if (fstat(int(handle), &st) != 0 || st.st_nlink == 0)
+		return false;
+	size = uint64_t(st.st_size);
+#if defined(PLATFORM_APPLE)
+	modified = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	modified = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::ptrdiff_t read(Handle handle, void * out, std::size_t size, uint64_t offset)
+{
+	auto ptr = static_cast<char *>(out);
+	std::size_t total = 0;
+	// Large reads may be split up by the system
+	while (total < size)
+	{
+#if defined(PLATFORM_WINDOWS)
+		OVERLAPPED overlapped{};
+		auto pos = offset + total;
+		overlapped.Offset = DWORD(pos & 0xFFFFFFFF);
+		overlapped.OffsetHigh = DWORD(pos >> 32);
+		DWORD amount = DWORD((std::min)(size - total, std::size_t(1) << 30));
+		DWORD bytes_read = 0;
+		if (!ReadFile(reinterpret_cast<HANDLE>(handle), ptr + total, amount, &bytes_read, &overlapped))
+			return GetLastError() == ERROR_HANDLE_EOF ? std::ptrdiff_t(total) : -1;
+		auto ret = std::ptrdiff_t(bytes_read);
+#elif defined(PLATFORM_UNIX)
+		auto ret = ::pread(int(handle), ptr + total, size - total, off_t(offset + total));
+		if (ret < 0 && errno == EINTR)
+			continue;
+#else
+		std::ptrdiff_t ret = -1;
+#endif
+		if (ret < 0)
+			return -1;
+		// End of file
+		if (ret == 0)
+			break;
+		total += std::size_t(ret);
+	}
+	return std::ptrdiff_t(total);
+}
+
+} // file
+
 namespace mmap
 {
 
-std::shared_ptr<void> load(const std::string & file)
+std::shared_ptr<void> load(file::Handle file_handle, std::size_t & size)
 {
+	if (file_handle == file::INVALID_HANDLE)
+		return std::shared_ptr<void>();
 #if defined(PLATFORM_WINDOWS)
-	auto handle = OpenFileMappingA(FILE_MAP_READ, FALSE, file.c_str());
-	if (!handle)
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(reinterpret_cast<HANDLE>(file_handle), &file_size) || file_size.QuadPart <= 0)
 		return std::shared_ptr<void>();
-	auto ptr = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+	auto handle = CreateFileMappingA(reinterpret_cast<HANDLE>(file_handle), NULL, PAGE_WRITECOPY, 0, 0, NULL);
 	if (!handle)
-	{
-		CloseHandle(handle);
 		return std::shared_ptr<void>();
-	}
-	return std::shared_ptr<void>(ptr, [handle](void * ptr)
+	auto ptr = MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, 0);
+	// The view keeps its own reference to the mapping
+	CloseHandle(handle);
+	if (!ptr)
+		return std::shared_ptr<void>();
+	size = std::size_t(file_size.QuadPart);
+	return std::shared_ptr<void>(ptr, [](void * ptr)
 	{
 		UnmapViewOfFile(ptr);
-		CloseHandle(handle);
 	});
 #elif defined(PLATFORM_UNIX)
-	auto fd = open(file.c_str(), O_RDONLY);
-	if (!fd)
+	auto fd = int(file_handle);
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
 		return std::shared_ptr<void>();
-	auto ptr = ::mmap(NULL, 0, PROT_READ, MAP_PRIVATE, fd, 0);
-	if (!ptr)
-	{
-		close(fd);
+	std::size_t _size = std::size_t(st.st_size);
+	/*
+	 * Note: Copy on write, as some parsers transform data in place. Those
+	 * pages are then the only ones not shared with the page cache.
+	 */
+	auto ptr = ::mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (ptr == MAP_FAILED)
 		return std::shared_ptr<void>();
-	}
-	return std::shared_ptr<void>(ptr, [fd](void * ptr)
+	size = _size;
+	return std::shared_ptr<void>(ptr, [_size](void * ptr)
 	{
-		munmap(ptr, 0);
-		close(fd);
+		munmap(ptr, _size);
 	});
 #else
+	(void)size;
 	return std::shared_ptr<void>();
 #endif
 }
 
+void advise(void * ptr, std::size_t size, Advice advice)
+{
+#if defined(PLATFORM_UNIX)
+	int flag = MADV_NORMAL;
+	switch (advice)
+	{
+	case Advice::NORMAL: flag = MADV_NORMAL; break;
+	case Advice::SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+	case Advice::RANDOM: flag = MADV_RANDOM; break;
+	case Advice::WILLNEED: flag = MADV_WILLNEED; break;
+	case Advice::DONTNEED: flag = MADV_DONTNEED; break;
+	}
+	// Needs to be aligned to page boundary
+	static const auto page_size = std::uintptr_t(sysconf(_SC_PAGESIZE));
+	auto start = reinterpret_cast<std::uintptr_t>(ptr);
+	auto aligned = start & ~(page_size - 1);
+	madvise(reinterpret_cast<void *>(aligned), size + (start - aligned), flag);
+#else
+	// Windows only has prefetching, which the system does well on its own
+	(void)ptr;
+	(void)size;
+	(void)advice;
+#endif
+}
+
 } // mmap
 
 } // platform
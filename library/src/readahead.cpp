@@ -0,0 +1,120 @@
+#include "readahead.hpp"
+
+// The smallest page size to expect
+constexpr std::size_t PAGE_STRIDE = 4096;
+
+ReadAhead::ReadAhead(std::size_t _depth) :
+	depth(_depth)
+{
+}
+
+ReadAhead::~ReadAhead()
+{
+	abort();
+}
+
+void ReadAhead::enqueue(std::shared_ptr<SharedFile> file)
+{
+	if (depth == 0)
+		return;
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		if (finish)
+			return;
+		// Started on demand, as it is stopped on abort
+		if (!thread.joinable())
+			thread = std::thread(&ReadAhead::run, this);
+		states[file] = State::QUEUED;
+		queue.emplace(std::move(file));
+	}
+	cond.notify_all();
+}
+
+void ReadAhead::acquire(const std::shared_ptr<SharedFile> & file)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	// Note: Looked up each time, as an abort may forget the file meanwhile
+	auto it = states.find(file);
+	cond.wait(lock, [this, &file, &it]() {
+		it = states.find(file);
+		return it == states.end() || it->second != State::LOADING;
+	});
+	// Not started, so avoid loading it twice
+	if (it != states.end() && it->second == State::QUEUED)
+		it->second = State::TAKEN;
+}
+
+void ReadAhead::release(const std::shared_ptr<SharedFile> & file)
+{
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		auto it = states.find(file);
+		if (it == states.end())
+			return;
+		if (it->second == State::LOADED)
+			--loaded;
+		states.erase(it);
+	}
+	cond.notify_all();
+}
+
+void ReadAhead::abort()
+{
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		finish = true;
+		decltype(queue)().swap(queue);
+	}
+	cond.notify_all();
+	if (thread.joinable())
+		thread.join();
+
+	// Allow the next job to load ahead again
+	// Note: Cancelled users never release their files, so forget all of
+	// them, while late users find them unknown
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		finish = false;
+		states.clear();
+		loaded = 0;
+	}
+	cond.notify_all();
+}
+
+void ReadAhead::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		cond.wait(lock, [this]() { return finish || (!queue.empty() && loaded < depth); });
+		if (finish)
+			break;
+		auto file = std::move(queue.front());
+		queue.pop();
+		auto it = states.find(file);
+		// Already taken care of
+		if (it == states.end() || it->second != State::QUEUED)
+			continue;
+		it->second = State::LOADING;
+		++loaded;
+		lock.unlock();
+
+		/*
+		 * Note: A mapped file is only read when accessed, so touch each page
+		 * to have it read here instead of in the worker.
+		 */
+		auto content = file->load();
+		volatile uint8_t sink = 0;
+		for (std::size_t i = 0; i < content.size(); i += PAGE_STRIDE)
+			sink = sink + *(content.data() + i);
+
+		lock.lock();
+		// Released while loading, so its slot is already free
+		it = states.find(file);
+		if (it != states.end())
+			it->second = State::LOADED;
+		else
+			--loaded;
+		cond.notify_all();
+	}
+}
@@ -1,12 +1,12 @@
 #include "sharedfile.hpp"
 
 #include "platform.hpp"
+#include "filecache.hpp"
 
 #include <spdlog/spdlog.h>
 
 SharedFile::SharedFile()
 {
-	_in = std::make_shared<std::ifstream>();
 }
 
 SharedFile::~SharedFile()
@@ -16,65 +16,137 @@ SharedFile::~SharedFile()
 
 bool SharedFile::openFile(const std::string & file)
 {
-	if (_in->is_open())
+	if (_open)
 	{
 		setError("File is already open");
 		return false;
 	}
 	_file = file;
 
-	_in->open(file.c_str(), std::ios::in | std::ios::binary);
-	if (!_in->is_open())
+	auto handle = FileCache::global().acquire(file);
+	if (!handle)
 	{
 		setError("Failed to open file");
 		return false;
 	}
 
 	// Store for later use
-	_in->seekg(0, std::ios::end);
-	_size = _in->tellg();
-	_in->seekg(0, std::ios::beg);
+	_size = handle.size();
+	_offset = 0;
+	_open = true;
 
 	return true;
 }
 
 void SharedFile::close()
 {
-	if (_in.use_count() == 1 && _in->is_open())
-	{
-		_in->close();
-	}
+	// The file itself is left in the cache for the next user
+	_open = false;
 }
 
 std::vector<uint8_t> SharedFile::readAll()
 {
 	if (!ensureOpen())
 		return {};
-	std::vector<uint8_t> data;
-	_in->seekg(0, std::ios::end);
-	auto size = _in->tellg();
-	_in->seekg(0, std::ios::beg);
-	data.resize(size);
-	read(data.data(), size);
+	std::vector<uint8_t> data(_size);
+	seek(0);
+	if (!read(data.data(), data.size()))
+		return {};
 	return data;
 }
 
+VectorView<uint8_t> SharedFile::map()
+{
+	if (_file.empty())
+	{
+		setError("File is not open");
+		return {};
+	}
+	auto mapped = tryMap();
+	if (mapped.empty())
+		setError("Failed to map file");
+	return mapped;
+}
+
+VectorView<uint8_t> SharedFile::tryMap()
+{
+	if (!_map && !_file.empty())
+	{
+		// Note: Borrowed from the cache, so mapping counts as any other use
+		auto handle = FileCache::global().acquire(_file);
+		if (handle)
+			_map = handle.map(_map_size);
+	}
+	if (!_map)
+		return {};
+	return {static_cast<uint8_t *>(_map.get()), _map_size};
+}
+
+void SharedFile::unmap()
+{
+	_map.reset();
+	_map_size = 0;
+}
+
+VectorView<uint8_t> SharedFile::load()
+{
+	if (_buffer && !_buffer->empty())
+		return {_buffer->data(), _buffer->size()};
+#ifdef USE_MMAP
+	// Note: Not an error if it cannot be mapped, as it is read instead
+	auto mapped = tryMap();
+	if (!mapped.empty())
+	{
+		// Let the system read ahead while the content is being parsed
+		platform::mmap::advise(mapped.data(), mapped.size(), platform::mmap::Advice::SEQUENTIAL);
+		platform::mmap::advise(mapped.data(), mapped.size(), platform::mmap::Advice::WILLNEED);
+		return mapped;
+	}
+#endif
+	_buffer = std::make_shared<std::vector<uint8_t>>(readAll());
+	return {_buffer->data(), _buffer->size()};
+}
+
+void SharedFile::unload()
+{
+	unmap();
+	_buffer.reset();
+}
+
+std::shared_ptr<void> SharedFile::content() const
+{
+	if (_buffer)
+		return _buffer;
+	return _map;
+}
+
 bool SharedFile::read(uint8_t * ptr, std::size_t size)
 {
 	if (!ensureOpen())
 		return false;
-	_in->read(reinterpret_cast<char *>(ptr), std::streamsize(size));
-	if (std::size_t(_in->gcount()) != size)
+	auto handle = FileCache::global().acquire(_file);
+	if (!handle)
+	{
+		setError("Failed to open file");
+		return false;
+	}
+	if (handle.read(ptr, size, _offset) != std::ptrdiff_t(size))
 	{
 		setError("Invalid read from file");
 		return false;
 	}
+	_offset += size;
 	return true;
 }
 
+void SharedFile::setFile(const std::string & file)
+{
+	_file = file;
+}
+
 bool SharedFile::isOpen() const
 {
-	return _in->is_open() || !_file.empty();
+	return _open;
 }
 
 uint64_t SharedFile::size() const
@@ -84,8 +156,7 @@ uint64_t SharedFile::size() const
 
 void SharedFile::seek(uint64_t offset)
 {
-	ensureOpen();
-	_in->seekg(offset, std::ios::beg);
+	_offset = offset;
 }
 
 void SharedFile::setError(const std::string & error)
@@ -93,9 +164,9 @@ void SharedFile::setError(const std::string & error)
 	_last_error = error;
 }
 
-inline bool SharedFile::ensureOpen()
+bool SharedFile::ensureOpen()
 {
-	if (_in->is_open())
+	if (_open)
 		return true;
 	if (!_file.empty())
 		return openFile(_file);
@@ -1,216 +1,394 @@
 #include "util/compression.hpp"
-
-#ifdef USE_LIBDEFLATE
-#include "libdeflate.h"
-#include <functional>
-#else
-#include "zlib.h"
-#endif
+#include "util/inflate.hpp"
 
 #include "lz4.h"
 
-// Note: Several power-of-two values have been tested, and this was the most fitting
-#ifdef USE_LIBDEFLATE
-constexpr uint32_t DEFLATE_BUFFER_SIZE = 65536;
-#else
-constexpr uint32_t DEFLATE_BUFFER_SIZE = 4096;
+#ifdef USE_SNAPPY
+#include "snappy.h"
+#endif
+#ifdef USE_ZSTD
+#include "zstd.h"
 #endif
 
-// TODO: Test more values
-constexpr uint32_t LZ4_BUFFER_SIZE = 65536;
+#include "util/endianess.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <string_view>
+
+// Header and trailer of a gzip member
+constexpr uint32_t GZIP_MIN_SIZE = 18;
+// Largest possible expansion of snappy data, from copies of 64 bytes in 3 bytes
+constexpr std::size_t SNAPPY_MAX_RATIO = 22;
+// Largest possible expansion of zstd data, from a full RLE block in 4 bytes
+constexpr std::size_t ZSTD_MAX_RATIO = 32768;
+// Overrides the backend picked by default
+constexpr const char * BACKEND_VARIABLE = "PIXELMAP_DEFLATE";
 
 namespace Compression
 {
 
+struct BackendEntry
+{
+	Backend backend;
+	Inflate::Function load;
+};
+
+// Backends built with, most preferred first
+static const BackendEntry backends[] = {
 #ifdef USE_LIBDEFLATE
+	{Backend::LIBDEFLATE, Inflate::loadLibDeflate},
+#endif
+#ifdef USE_ZLIBNG
+	{Backend::ZLIBNG, Inflate::loadZLibNg},
+#endif
+	{Backend::ZLIB, Inflate::loadZLib},
+};
 
-using decompress = decltype(libdeflate_deflate_decompress);
+static const BackendEntry * find_backend(Backend backend)
+{
+	for (const auto & entry : backends)
+		if (entry.backend == backend)
+			return &entry;
+	return nullptr;
+}
 
-inline std::vector<uint8_t> loadCompressed(const std::vector<uint8_t> & compressed, std::function<decompress> func);
-static std::vector<uint8_t> loadCompressed(const VectorView<const uint8_t> & compressed, std::function<decompress> func);
+// Picked on first use, from the environment or by preference
+static std::atomic<const BackendEntry *> & current_backend()
+{
+	static std::atomic<const BackendEntry *> current{[]() {
+		if (auto name = std::getenv(BACKEND_VARIABLE))
+		{
+			for (const auto & entry : backends)
+				if (getBackendName(entry.backend) == std::string_view(name))
+					return &entry;
+			spdlog::warn("Unknown deflate backend: {:s}", name);
+		}
+		return &backends[0];
+	}()};
+	return current;
+}
 
-#define LOAD_ZLIB libdeflate_zlib_decompress
-#define LOAD_DEFLATE libdeflate_deflate_decompress
-#define LOAD_GZIP libdeflate_gzip_decompress
+static bool loadCompressed(const VectorView<const uint8_t> & compressed, Inflate::Format format, std::vector<uint8_t> & data, std::size_t hint)
+{
+	return current_backend().load(std::memory_order_relaxed)->load(compressed, format, data, hint);
+}
 
-#else
+bool setBackend(Backend backend)
+{
+	auto entry = find_backend(backend);
+	if (!entry)
+		return false;
+	current_backend().store(entry, std::memory_order_relaxed);
+	return true;
+}
 
-inline std::vector<uint8_t> loadCompressed(const std::vector<uint8_t> & compressed, int compression);
-static std::vector<uint8_t> loadCompressed(const VectorView<const uint8_t> & compressed, int compression);
+Backend getBackend()
+{
+	return current_backend().load(std::memory_order_relaxed)->backend;
+}
 
-#define LOAD_ZLIB MAX_WBITS
-#define LOAD_DEFLATE -MAX_WBITS
-#define LOAD_GZIP 16 + MAX_WBITS
+bool hasBackend(Backend backend)
+{
+	return find_backend(backend) != nullptr;
+}
 
-#endif // USE_LIBDEFLATE
+const char * getBackendName(Backend backend)
+{
+	switch (backend)
+	{
+	case Backend::ZLIB: return "zlib";
+	case Backend::LIBDEFLATE: return "libdeflate";
+	case Backend::ZLIBNG: return "zlib-ng";
+	}
+	return "";
+}
+
+static std::size_t gzip_size(const VectorView<const uint8_t> & compressed);
+static bool lz4_size(const VectorView<const uint8_t> & compressed, std::size_t & size);
 
 // Load compressed data as zlib
 std::vector<uint8_t> loadZLib(const std::vector<uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_ZLIB);
+	return loadZLib(VectorView<const uint8_t>{compressed.data(), compressed.size()});
 }
 
 // Load compressed data as zlib raw
 std::vector<uint8_t> loadZLibRaw(const std::vector<uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_DEFLATE);
+	return loadZLibRaw(VectorView<const uint8_t>{compressed.data(), compressed.size()});
 }
 
 // Load compressed data as gzip
 std::vector<uint8_t> loadGZip(const std::vector<uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_GZIP);
+	return loadGZip(VectorView<const uint8_t>{compressed.data(), compressed.size()});
 }
 
 // Load compressed data as zlib
 std::vector<uint8_t> loadZLib(const VectorView<const uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_ZLIB);
+	std::vector<uint8_t> data;
+	loadZLib(compressed, data);
+	return data;
 }
 
 // Load compressed data as zlib raw
 std::vector<uint8_t> loadZLibRaw(const VectorView<const uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_DEFLATE);
+	std::vector<uint8_t> data;
+	loadZLibRaw(compressed, data);
+	return data;
 }
 
 // Load compressed data as gzip
 std::vector<uint8_t> loadGZip(const VectorView<const uint8_t> & compressed)
 {
-	return loadCompressed(compressed, LOAD_GZIP);
+	std::vector<uint8_t> data;
+	loadGZip(compressed, data);
+	return data;
 }
 
-#ifdef USE_LIBDEFLATE
-
-inline std::vector<uint8_t> loadCompressed(const std::vector<uint8_t> & compressed, std::function<decompress> func)
+// Load compressed data as zlib into a reused buffer
+bool loadZLib(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint)
 {
-	return loadCompressed(VectorView<const uint8_t>{compressed.data(), compressed.size()}, func);
+	return loadCompressed(compressed, Inflate::FORMAT_ZLIB, data, hint);
 }
 
-static std::vector<uint8_t> loadCompressed(const VectorView<const uint8_t> & compressed, std::function<decompress> func)
+// Load compressed data as zlib raw into a reused buffer
+bool loadZLibRaw(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint)
 {
-	if (compressed.empty())
-		return {compressed.begin(), compressed.end()};
-	// Prepare compression stream
-	libdeflate_decompressor * stream;
-
-	std::vector<uint8_t> data;
-	data.resize(DEFLATE_BUFFER_SIZE);
-
-	const void * in = compressed.data();
-	size_t in_nbytes = compressed.size();
-	size_t actual_out_nbytes_ret = 0;
+	return loadCompressed(compressed, Inflate::FORMAT_RAW, data, hint);
+}
 
-	stream = libdeflate_alloc_decompressor();
+// Load compressed data as gzip into a reused buffer
+bool loadGZip(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint)
+{
+	// The size is stored, so no need to guess
+	if (auto size = gzip_size(compressed))
+		hint = size;
+	return loadCompressed(compressed, Inflate::FORMAT_GZIP, data, hint);
+}
 
-	auto ret = LIBDEFLATE_SUCCESS;
+// Get the size stored in the trailer, or 0 if unusable
+std::size_t gzip_size(const VectorView<const uint8_t> & compressed)
+{
+	if (compressed.size() < GZIP_MIN_SIZE)
+		return 0;
+	std::size_t size = endianess::fromLittle<uint32_t>(compressed.data() + compressed.size() - sizeof(uint32_t));
+	// Only the lower bits are stored, so sizes above 4 GiB are wrong
+	if (size > compressed.size() * Inflate::MAX_RATIO)
+		return 0;
+	return size;
+}
 
-	// Try larger and larger size of output buffer
-	do
+std::vector<uint8_t> loadLZ4(const std::vector<uint8_t> & compressed)
+{
+	return loadLZ4(VectorView<const uint8_t>{compressed.data(), compressed.size()});
+}
+std::vector<uint8_t> loadLZ4(const VectorView<const uint8_t> & compressed)
+{
+	std::vector<uint8_t> data;
+	loadLZ4(compressed, data);
+	return data;
+}
+bool loadLZ4(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data)
+{
+	data.clear();
+	// The size can be counted from the sequences without decompressing
+	std::size_t size = 0;
+	if (compressed.empty() || !lz4_size(compressed, size))
+		return false;
+
+	data.resize(size);
+
+	auto ret = LZ4_decompress_safe(
+		reinterpret_cast<const char *>(compressed.data()),
+		reinterpret_cast<char *>(data.data()),
+		static_cast<int>(compressed.size()), static_cast<int>(data.size()));
+	if (ret < 0)
 	{
-		void * out = data.data();
-		size_t out_nbytes_avail = data.size();
-		ret = func(stream, in, in_nbytes, out, out_nbytes_avail, &actual_out_nbytes_ret);
-		if (ret == LIBDEFLATE_INSUFFICIENT_SPACE)
-			data.resize(data.size() << 1);
+		data.clear();
+		return false;
 	}
-	while (ret != LIBDEFLATE_SUCCESS);
-
-	libdeflate_free_decompressor(stream);
 
-	data.resize(actual_out_nbytes_ret);
-	data.shrink_to_fit();
+	data.resize(ret);
 
-	return data;
+	return true;
 }
 
-#else
-
-// Load compressed data with compression flag
-inline std::vector<uint8_t> loadCompressed(const std::vector<uint8_t> & compressed, int compression)
+/*
+ * A block is a list of sequences:
+ * token: Upper 4 bits literal length, lower 4 bits match length - 4
+ * [length]: If literal length is 15, add bytes until one is below 255
+ * literals: Copied as is
+ * offset: 2 bytes, except for the last sequence
+ * [length]: If match length is 15, add bytes until one is below 255
+ */
+bool lz4_size(const VectorView<const uint8_t> & compressed, std::size_t & size)
 {
-	return loadCompressed(VectorView<const uint8_t>{compressed.data(), compressed.size()}, compression);
+	auto ptr = compressed.data();
+	auto end = compressed.data() + compressed.size();
+	auto read_length = [&ptr, end](std::size_t length) -> std::size_t {
+		if (length < 15)
+			return length;
+		uint8_t b;
+		do
+		{
+			if (ptr >= end)
+				return 0;
+			b = *ptr++;
+			length += b;
+		}
+		while (b == 255);
+		return length;
+	};
+	size = 0;
+	while (ptr < end)
+	{
+		auto token = *ptr++;
+		auto literals = read_length(token >> 4);
+		if (literals > std::size_t(end - ptr))
+			return false;
+		ptr += literals;
+		size += literals;
+		// Last sequence has no match
+		if (ptr == end)
+			return true;
+		if (end - ptr < 2)
+			return false;
+		ptr += 2;
+		size += read_length(token & 15) + 4;
+	}
+	return false;
 }
 
-// Load compressed data with compression flag
-static std::vector<uint8_t> loadCompressed(const VectorView<const uint8_t> & compressed, int compression)
+std::vector<uint8_t> loadSnappy(const std::vector<uint8_t> & compressed)
+{
+	return loadSnappy(VectorView<const uint8_t>{compressed.data(), compressed.size()});
+}
+std::vector<uint8_t> loadSnappy(const VectorView<const uint8_t> & compressed)
 {
-	if (compressed.empty())
-		return {compressed.begin(), compressed.end()};
-	// Prepare compression stream
-	z_stream stream;
-
 	std::vector<uint8_t> data;
-	//data.reserve(compressed.size());
-
-	Byte buffer[DEFLATE_BUFFER_SIZE] = { 0 };
-
-	stream.zalloc = nullptr;
-	stream.zfree = nullptr;
-	stream.opaque = nullptr;
-
-	stream.next_in = const_cast<Byte *>(compressed.data());
-	stream.avail_in = static_cast<uInt>(compressed.size());
-	stream.next_out = buffer;
-	stream.avail_out = DEFLATE_BUFFER_SIZE;
-
-	int ret = Z_OK;
-
-	inflateInit2(&stream, compression);
-
-	// Iterate through the stream
-	do
+	loadSnappy(compressed, data);
+	return data;
+}
+bool loadSnappy(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data)
+{
+	data.clear();
+	if (compressed.empty())
+		return true;
+#ifdef USE_SNAPPY
+	auto src = reinterpret_cast<const char *>(compressed.data());
+
+	// Size is stored at the start
+	std::size_t size = 0;
+	if (!snappy::GetUncompressedLength(src, compressed.size(), &size))
+		return false;
+	// A broken size would otherwise allocate anything
+	if (size > compressed.size() * SNAPPY_MAX_RATIO)
+		return false;
+
+	data.resize(size);
+	if (!snappy::RawUncompress(src, compressed.size(), reinterpret_cast<char *>(data.data())))
 	{
-		stream.avail_out = DEFLATE_BUFFER_SIZE;
-		stream.next_out = buffer;
-		ret = inflate(&stream, Z_NO_FLUSH);
-		auto len = (stream.avail_out == 0) ? DEFLATE_BUFFER_SIZE : DEFLATE_BUFFER_SIZE - stream.avail_out;
-		data.insert(data.end(), buffer, buffer + len);
+		data.clear();
+		return false;
 	}
-	while (stream.avail_out == 0 && ret != Z_STREAM_END);
 
-	inflateEnd(&stream);
-
-	return data;
+	return true;
+#else
+	spdlog::error("Snappy not supported");
+	return false;
+#endif
 }
 
-#endif // USE_LIBDEFLATE
-
-std::vector<uint8_t> loadLZ4(const std::vector<uint8_t> & compressed)
+std::vector<uint8_t> loadZstd(const std::vector<uint8_t> & compressed)
 {
-	return loadLZ4(VectorView<const uint8_t>{compressed.data(), compressed.size()});
+	return loadZstd(VectorView<const uint8_t>{compressed.data(), compressed.size()});
 }
-std::vector<uint8_t> loadLZ4(const VectorView<const uint8_t> & compressed)
+std::vector<uint8_t> loadZstd(const VectorView<const uint8_t> & compressed)
+{
+	std::vector<uint8_t> data;
+	loadZstd(compressed, data);
+	return data;
+}
+bool loadZstd(const VectorView<const uint8_t> & compressed, std::vector<uint8_t> & data, std::size_t hint)
 {
+	data.clear();
 	if (compressed.empty())
-		return {compressed.begin(), compressed.end()};
+		return true;
+#ifdef USE_ZSTD
+	const void * src = compressed.data();
+	std::size_t srcSize = compressed.size();
 
-	std::vector<uint8_t> data;
-	data.resize(LZ4_BUFFER_SIZE);
+	// Creating a context is costly, so keep one for each thread
+	struct Context
+	{
+		ZSTD_DCtx * stream = ZSTD_createDCtx();
+		~Context() { ZSTD_freeDCtx(stream); }
+	};
+	thread_local Context context;
+	auto stream = context.stream;
+	if (!stream)
+		return false;
+
+	// Size is usually stored in the frame
+	auto size = ZSTD_getFrameContentSize(src, srcSize);
+	if (size == ZSTD_CONTENTSIZE_ERROR)
+		return false;
+	// A broken size would otherwise allocate anything
+	if (size != ZSTD_CONTENTSIZE_UNKNOWN && size > srcSize * ZSTD_MAX_RATIO)
+		return false;
+	if (size != ZSTD_CONTENTSIZE_UNKNOWN)
+	{
+		data.resize(size);
+		auto ret = ZSTD_decompressDCtx(stream, data.data(), data.size(), src, srcSize);
+		if (ZSTD_isError(ret))
+		{
+			data.clear();
+			return false;
+		}
+		data.resize(ret);
+		return true;
+	}
 
-	const void * src = compressed.data();
-	size_t compressedSize = compressed.size();
+	// Otherwise stream it
+	ZSTD_DCtx_reset(stream, ZSTD_reset_session_only);
 
-	auto ret = 0;
+	data.resize(Inflate::initialSize(hint, ZSTD_DStreamOutSize()));
+	ZSTD_inBuffer in{src, srcSize, 0};
+	std::size_t produced = 0;
+	bool more = true;
 
-	// Try larger and larger size of output buffer
 	do
 	{
-		void * dst = data.data();
-		size_t dstCapacity = data.size();
-		ret = LZ4_decompress_safe(
-			reinterpret_cast<const char *>(src),
-			reinterpret_cast<char *>(dst),
-			compressedSize, dstCapacity);
-		if (ret < 0)
+		ZSTD_outBuffer out{data.data() + produced, data.size() - produced, 0};
+		auto ret = ZSTD_decompressStream(stream, &out, &in);
+		if (ZSTD_isError(ret))
+		{
+			data.clear();
+			return false;
+		}
+		produced += out.pos;
+		// Continue until the frame is done, or nothing more can be produced
+		more = ret != 0 && (in.pos < in.size || out.pos == out.size);
+		if (more && produced == data.size())
 			data.resize(data.size() << 1);
 	}
-	while (ret < 0);
+	while (more);
 
-	data.resize(ret);
-	data.shrink_to_fit();
+	data.resize(produced);
 
-	return data;
+	return true;
+#else
+	(void)hint;
+	spdlog::error("ZSTD not supported");
+	return false;
+#endif
 }
 
 } // namespace Compression
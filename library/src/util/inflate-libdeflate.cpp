@@ -0,0 +1,71 @@
+#include "util/inflate.hpp"
+
+#include "libdeflate.h"
+
+// Note: Several power-of-two values have been tested, and this was the most fitting
+constexpr std::size_t BUFFER_SIZE = 65536;
+
+namespace Compression
+{
+namespace Inflate
+{
+
+/*
+ * Allocating a decompressor is costly, so keep one for each thread
+ */
+static libdeflate_decompressor * getDecompressor()
+{
+	struct Decompressor
+	{
+		libdeflate_decompressor * stream = libdeflate_alloc_decompressor();
+		~Decompressor() { libdeflate_free_decompressor(stream); }
+	};
+	thread_local Decompressor decompressor;
+	return decompressor.stream;
+}
+
+// Note: The data can only be decompressed as a whole, so a too small hint
+// will decompress it again with zlib, which grows the buffer as needed
+bool loadLibDeflate(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint)
+{
+	// Note: Not cleared, as the old content will be overwritten anyway
+	auto stream = getDecompressor();
+	if (compressed.empty() || !stream)
+	{
+		data.clear();
+		return false;
+	}
+
+	decltype(libdeflate_deflate_decompress) * func = nullptr;
+	switch (format)
+	{
+	case FORMAT_ZLIB: func = libdeflate_zlib_decompress; break;
+	case FORMAT_RAW: func = libdeflate_deflate_decompress; break;
+	case FORMAT_GZIP: func = libdeflate_gzip_decompress; break;
+	}
+
+	data.resize(initialSize(hint, BUFFER_SIZE));
+
+	const void * in = compressed.data();
+	size_t in_nbytes = compressed.size();
+	size_t actual_out_nbytes_ret = 0;
+
+	auto ret = func(stream, in, in_nbytes, data.data(), data.size(), &actual_out_nbytes_ret);
+
+	// Larger than expected, so stream it instead of guessing larger sizes
+	if (ret == LIBDEFLATE_INSUFFICIENT_SPACE)
+		return loadZLib(compressed, format, data, data.size() << 1);
+
+	if (ret != LIBDEFLATE_SUCCESS)
+	{
+		data.clear();
+		return false;
+	}
+
+	data.resize(actual_out_nbytes_ret);
+
+	return true;
+}
+
+} // namespace Inflate
+} // namespace Compression
@@ -0,0 +1,31 @@
+#include "util/inflate.hpp"
+
+#include "zlib.h"
+
+// Note: Several power-of-two values have been tested, and this was the most fitting
+constexpr std::size_t BUFFER_SIZE = 4096;
+
+namespace Compression
+{
+namespace Inflate
+{
+
+struct ZLibApi
+{
+	using Stream = z_stream;
+	static constexpr int OK = Z_OK;
+	static constexpr int STREAM_END = Z_STREAM_END;
+	static constexpr int BUF_ERROR = Z_BUF_ERROR;
+	static int init(Stream * stream, int bits) { return inflateInit2(stream, bits); }
+	static int reset(Stream * stream, int bits) { return inflateReset2(stream, bits); }
+	static int inflate(Stream * stream) { return ::inflate(stream, Z_NO_FLUSH); }
+	static int end(Stream * stream) { return inflateEnd(stream); }
+};
+
+bool loadZLib(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint)
+{
+	return loadStream<ZLibApi>(compressed, format, data, hint, BUFFER_SIZE);
+}
+
+} // namespace Inflate
+} // namespace Compression
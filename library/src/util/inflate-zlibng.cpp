@@ -0,0 +1,31 @@
+#include "util/inflate.hpp"
+
+#include "zlib-ng.h"
+
+// Note: Same as for zlib, as both grow the buffer the same way in loadStream
+constexpr std::size_t BUFFER_SIZE = 4096;
+
+namespace Compression
+{
+namespace Inflate
+{
+
+struct ZLibNgApi
+{
+	using Stream = zng_stream;
+	static constexpr int32_t OK = Z_OK;
+	static constexpr int32_t STREAM_END = Z_STREAM_END;
+	static constexpr int32_t BUF_ERROR = Z_BUF_ERROR;
+	static int32_t init(Stream * stream, int bits) { return zng_inflateInit2(stream, bits); }
+	static int32_t reset(Stream * stream, int bits) { return zng_inflateReset2(stream, bits); }
+	static int32_t inflate(Stream * stream) { return zng_inflate(stream, Z_NO_FLUSH); }
+	static int32_t end(Stream * stream) { return zng_inflateEnd(stream); }
+};
+
+bool loadZLibNg(const VectorView<const uint8_t> & compressed, Format format, std::vector<uint8_t> & data, std::size_t hint)
+{
+	return loadStream<ZLibNgApi>(compressed, format, data, hint, BUFFER_SIZE);
+}
+
+} // namespace Inflate
+} // namespace Compression
@@ -6,7 +6,8 @@
 #include "shared_value.hpp"
 #include "module/module.hpp"
 #include "libraryoptions.hpp"
-#include "platform.hpp"
+#include "filecache.hpp"
+#include "format/region.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -16,10 +17,17 @@ static std::size_t handle_threads_options(const Options & options)
 {
 	auto threads = options.get("threads", int(std::thread::hardware_concurrency()));
 	/*
-	Avoid both having less than one thread,
-	but also to have no more than file descriptors available.
+	Avoid having less than one thread. Files are borrowed from the file
+	cache only while being read, so the amount of file descriptors
+	available does not limit the amount of threads.
 	*/
-	return (std::min)(std::size_t((std::max)(threads, 1)), platform::fd::max()-1);
+	return std::size_t((std::max)(threads, 1));
+}
+
+static std::size_t handle_readahead_options(const Options & options)
+{
+	auto depth = options.get("readahead", 2);
+	return std::size_t((std::max)(depth, 0));
 }
 
 void ErrorStats::print() const
@@ -82,12 +90,16 @@ WorkerBase::WorkerBase(std::atomic_bool & _run, const Options & options) :
 	_valid(false),
 	run(_run),
 	use_lonely(!options.get<bool>("nolonely", false)),
+	readahead(handle_readahead_options(options)),
 	pool(handle_threads_options(options), 0),
 	total_chunks(0),
 	total_regions(0)
 {
 	settings = std::make_shared<RenderSettings>();
 
+	// Files may have changed since last time
+	FileCache::global().clear();
+
 	// Load block color
 	if (options.has("colors"))
 		settings->colors.read(options.get<std::string>("colors"));
@@ -254,6 +266,21 @@ WorkerBase::WorkerBase(std::atomic_bool & _run, const Options & options) :
 	_valid = true;
 }
 
+std::string WorkerBase::indexFile(const std::string & output) const
+{
+	// Images are single files, while the rest are folders of files
+	switch (settings->mode)
+	{
+	case Render::Mode::IMAGE:
+	case Render::Mode::IMAGE_DIRECT:
+	case Render::Mode::CHUNK_TINY:
+	case Render::Mode::REGION_TINY:
+		return region::getIndexFile(output, false);
+	default:
+		return region::getIndexFile(output, true);
+	}
+}
+
 void WorkerBase::eventTotalChunks(std::function<void(int)> && func)
 {
 	func_totalChunks.add(std::move(func));
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Replaces the global allocation functions, counting allocations and the
+ * bytes allocated
+ * Note: Include from only one file of each executable
+ */
+static std::atomic<std::size_t> allocations{0};
+static std::atomic<std::size_t> allocated{0};
+
+void * operator new(std::size_t size)
+{
+	++allocations;
+	allocated += size;
+	if (auto ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	++allocations;
+	allocated += size;
+	return std::malloc(size ? size : 1);
+}
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+#endif // ALLOC_COUNTER_HPP
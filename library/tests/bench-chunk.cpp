@@ -0,0 +1,93 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "chunk.hpp"
+#include "anvil/limits.hpp"
+
+// Count allocated bytes, to measure the footprint of chunks
+#include "alloc-counter.hpp"
+
+#include <iostream>
+#include <vector>
+
+// Something resembling a 1.18 chunk, with ground, a surface and then only air
+struct SectionInput
+{
+	int32_t y;
+	std::vector<uint16_t> blocks;
+	std::vector<int8_t> blockLight, skyLight;
+};
+
+static std::vector<SectionInput> createSections()
+{
+	std::vector<SectionInput> sections;
+	for (int32_t y = -4; y < 20; ++y)
+	{
+		SectionInput section{y, {}, {}, std::vector<int8_t>(SECTION_SIZE >> 1, 0x0F)};
+		std::size_t palette = y < 4 ? 12 : y < 6 ? 24 : 1;
+		if (palette == 1)
+			section.blocks = {0};
+		else
+		{
+			section.blocks.resize(SECTION_SIZE);
+			for (std::size_t i = 0; i < section.blocks.size(); ++i)
+				section.blocks[i] = uint16_t((i * 7 + i / 64) % palette);
+		}
+		// Caves and torches are lit below the surface
+		if (y < 6)
+			section.blockLight.resize(SECTION_SIZE >> 1, 0x21);
+		sections.emplace_back(std::move(section));
+	}
+	return sections;
+}
+
+static void fill(Chunk & chunk, const std::vector<SectionInput> & sections)
+{
+	for (const auto & input : sections)
+	{
+		SectionData section;
+		section.setY(input.y);
+		section.setBlocks(input.blocks);
+		if (!input.blockLight.empty())
+			section.setBlockLight(input.blockLight);
+		section.setSkyLight(input.skyLight);
+		chunk.setSection(std::move(section));
+	}
+}
+
+TEST_CASE("chunk memory", "[!benchmark]")
+{
+	auto sections = createSections();
+
+	auto start = allocated.load();
+	{
+		Chunk chunk;
+		fill(chunk, sections);
+		std::cout << "chunk footprint: " << (allocated.load() - start) / 1024.0 << " KiB" << std::endl;
+		CHECK(chunk.getTile({0, 16 * 10, 0}).skyLight == 0x0F);
+	}
+	// Compared to storing a tile for each block in every section
+	std::cout << "chunk footprint as tiles: "
+		<< sections.size() * SECTION_SIZE * sizeof(TileData) / 1024.0 << " KiB" << std::endl;
+
+	Chunk chunk;
+	fill(chunk, sections);
+	BENCHMARK("chunk fill")
+	{
+		Chunk c;
+		fill(c, sections);
+		return c.getMaxY();
+	};
+	BENCHMARK("chunk getTile")
+	{
+		uint32_t sum = 0;
+		for (int y = chunk.getMinY(); y <= chunk.getMaxY(); ++y)
+			for (int z = 0; z < SECTION_Z; ++z)
+				for (int x = 0; x < SECTION_X; ++x)
+				{
+					auto tile = chunk.getTile({x, y, z});
+					sum += tile.index + tile.blockLight + tile.skyLight;
+				}
+		return sum;
+	};
+}
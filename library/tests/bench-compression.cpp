@@ -0,0 +1,94 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "format/region.hpp"
+#include "util/compression.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Folder of region files to replay the chunks of, like the region folder of a world
+constexpr const char * REGION_VARIABLE = "PIXELMAP_BENCH_REGIONS";
+
+struct Payload
+{
+	region::ChunkData::CompressionType type;
+	std::vector<uint8_t> data;
+};
+
+// Read the compressed chunks as they are stored
+static std::vector<Payload> loadPayloads(const std::string & path)
+{
+	std::vector<Payload> payloads;
+	region::Region region(path);
+	for (auto file : region)
+	{
+		for (auto chunk : *file)
+		{
+			if (!chunk)
+				continue;
+			if (chunk->compression_type != region::ChunkData::COMPRESSION_ZLIB &&
+				chunk->compression_type != region::ChunkData::COMPRESSION_GZIP)
+				continue;
+			payloads.push_back({chunk->compression_type, {chunk->data.begin(), chunk->data.end()}});
+		}
+	}
+	return payloads;
+}
+
+// Decompress every chunk like the workers do, returning the decompressed size
+static std::size_t replay(const std::vector<Payload> & payloads, std::vector<uint8_t> & buffer)
+{
+	std::size_t size = 0;
+	for (const auto & payload : payloads)
+	{
+		VectorView<const uint8_t> data{payload.data.data(), payload.data.size()};
+		bool ok = payload.type == region::ChunkData::COMPRESSION_GZIP
+			? Compression::loadGZip(data, buffer)
+			: Compression::loadZLib(data, buffer);
+		if (ok)
+			size += buffer.size();
+	}
+	return size;
+}
+
+TEST_CASE("deflate backends", "[!benchmark]")
+{
+	auto path = std::getenv(REGION_VARIABLE);
+	if (!path)
+		SKIP("Set " << REGION_VARIABLE << " to a folder of region files");
+
+	auto payloads = loadPayloads(path);
+	REQUIRE_FALSE(payloads.empty());
+
+	auto previous = Compression::getBackend();
+	std::size_t expected = 0;
+
+	for (auto backend : {Compression::Backend::ZLIB, Compression::Backend::LIBDEFLATE, Compression::Backend::ZLIBNG})
+	{
+		if (!Compression::setBackend(backend))
+			continue;
+		std::string name = Compression::getBackendName(backend);
+		std::vector<uint8_t> buffer;
+
+		// All backends should agree, which also warms up the buffer
+		auto size = replay(payloads, buffer);
+		if (expected == 0)
+		{
+			expected = size;
+			// Throughput is the decompressed data over the mean of a benchmark
+			std::cout << "replay: " << payloads.size() << " chunks, "
+				<< double(size) / 1e6 << " MB decompressed" << std::endl;
+		}
+		CHECK(size == expected);
+
+		BENCHMARK(std::string(name))
+		{
+			return replay(payloads, buffer);
+		};
+	}
+
+	Compression::setBackend(previous);
+}
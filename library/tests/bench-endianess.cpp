@@ -0,0 +1,64 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "util/endianess.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Block states of a full chunk, 24 sections of 1024 longs
+constexpr std::size_t COUNT = 24 * 1024;
+
+template<typename T>
+static void benchmarkSwap(const std::string & name)
+{
+	// Offset by one, as arrays within NBT data are rarely aligned
+	std::vector<uint8_t> buffer(1 + COUNT * sizeof(T));
+	for (std::size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = uint8_t(i);
+	auto bytes = buffer.data() + 1;
+	auto data = reinterpret_cast<T *>(bytes);
+
+	// Convert one value at a time, like before
+	// Note: Copied through bytes, as the values are not aligned
+	auto elementwise = [bytes]()
+	{
+		for (std::size_t i = 0; i < COUNT; ++i)
+		{
+			auto v = endianess::fromBig<T>(bytes + i * sizeof(T));
+			std::memcpy(bytes + i * sizeof(T), &v, sizeof(T));
+		}
+	};
+	auto bulk = [data]()
+	{
+		endianess::fromBigArray(data, COUNT);
+	};
+
+	// Both should end up with the same
+	// Note: Restored in place, as the conversions point into the buffer
+	auto original = buffer;
+	elementwise();
+	auto expected = buffer;
+	std::copy(original.begin(), original.end(), buffer.begin());
+	bulk();
+	REQUIRE(expected == buffer);
+
+	BENCHMARK(name + " elementwise")
+	{
+		elementwise();
+		return buffer[1];
+	};
+	BENCHMARK(name + " bulk")
+	{
+		bulk();
+		return buffer[1];
+	};
+}
+
+TEST_CASE("endianess swap", "[!benchmark]")
+{
+	benchmarkSwap<int32_t>("int");
+	benchmarkSwap<int64_t>("long");
+}
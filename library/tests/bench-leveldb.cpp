@@ -0,0 +1,52 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+#include "format/leveldb.hpp"
+
+#include "leveldb-builder.hpp"
+
+#include <string>
+#include <vector>
+
+// Table resembling a Bedrock world, with sub chunks spread over blocks
+static std::vector<uint8_t> createTable(int entries)
+{
+	constexpr int ENTRIES_PER_BLOCK = 64;
+	std::vector<std::pair<uint8_t, Entries>> blocks;
+	for (int i = 0; i < entries; ++i)
+	{
+		if (i % ENTRIES_PER_BLOCK == 0)
+			blocks.emplace_back(0, Entries{});
+		int chunk = i / 16;
+		std::string key(10, '\0');
+		for (int b = 0; b < 4; ++b)
+		{
+			key[b] = char((chunk % 1024) >> (b * 8));
+			key[4 + b] = char((chunk / 1024) >> (b * 8));
+		}
+		key[8] = char(47); // SubChunkPrefix
+		key[9] = char(i % 16);
+		// Internal key trailer
+		key.append(8, '\1');
+		blocks.back().second.emplace_back(key, std::string(100, char(i)));
+	}
+	return build_table(blocks);
+}
+
+TEST_CASE("leveldb parse", "[!benchmark]")
+{
+	auto entries = GENERATE(10000, 1000000);
+	auto table = createTable(entries);
+
+	// Entries per second is the amount of entries over the mean time
+	BENCHMARK("entries " + std::to_string(entries))
+	{
+		std::size_t count = 0;
+		LevelDB::LevelReader reader;
+		reader.parse(table, [&count](const LevelDB::VectorData & key, const LevelDB::VectorData &) {
+			count += key.size();
+		});
+		return count;
+	};
+}
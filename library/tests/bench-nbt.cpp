@@ -0,0 +1,182 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "format/nbt.hpp"
+#include "format/nbtparser.hpp"
+#include "util/endianess.hpp"
+
+#include "nbt-writer.hpp"
+
+#include <string>
+#include <vector>
+
+// Something resembling a chunk, with sections and block entities
+template<NBT::Endianess E>
+static std::vector<uint8_t> createChunk()
+{
+	Writer<E> w;
+	w.tag(NBT::TAG_Compound, "");
+	w.tag(NBT::TAG_Int, "DataVersion"); w.template number<int32_t>(3120);
+	w.tag(NBT::TAG_Int, "xPos"); w.template number<int32_t>(0);
+	w.tag(NBT::TAG_Int, "zPos"); w.template number<int32_t>(0);
+	w.tag(NBT::TAG_Compound, "Heightmaps");
+	w.tag(NBT::TAG_Long_Array, "WORLD_SURFACE"); w.template number<int32_t>(37);
+	for (int i = 0; i < 37; ++i)
+		w.template number<int64_t>(i);
+	w.end();
+	w.tag(NBT::TAG_List, "sections"); w.list(NBT::TAG_Compound, 24);
+	for (int s = 0; s < 24; ++s)
+	{
+		w.tag(NBT::TAG_Byte, "Y"); w.template number<int8_t>(int8_t(s - 4));
+		w.tag(NBT::TAG_Compound, "block_states");
+		w.tag(NBT::TAG_List, "palette"); w.list(NBT::TAG_Compound, 8);
+		for (int p = 0; p < 8; ++p)
+		{
+			w.tag(NBT::TAG_String, "Name"); w.string("minecraft:block_" + std::to_string(p));
+			w.tag(NBT::TAG_Compound, "Properties");
+			w.tag(NBT::TAG_String, "axis"); w.string("y");
+			w.end();
+			w.end();
+		}
+		w.tag(NBT::TAG_Long_Array, "data"); w.template number<int32_t>(256);
+		for (int i = 0; i < 256; ++i)
+			w.template number<int64_t>(i);
+		w.end();
+		w.tag(NBT::TAG_Byte_Array, "SkyLight"); w.template number<int32_t>(2048);
+		w.data.resize(w.data.size() + 2048);
+		w.end();
+	}
+	w.tag(NBT::TAG_List, "block_entities"); w.list(NBT::TAG_Compound, 50);
+	for (int e = 0; e < 50; ++e)
+	{
+		w.tag(NBT::TAG_String, "id"); w.string("minecraft:chest");
+		w.tag(NBT::TAG_Int, "x"); w.template number<int32_t>(e);
+		w.tag(NBT::TAG_Int, "y"); w.template number<int32_t>(64);
+		w.tag(NBT::TAG_Int, "z"); w.template number<int32_t>(e);
+		w.tag(NBT::TAG_List, "Items"); w.list(NBT::TAG_Compound, 4);
+		for (int i = 0; i < 4; ++i)
+		{
+			w.tag(NBT::TAG_String, "id"); w.string("minecraft:stone");
+			w.tag(NBT::TAG_Byte, "Count"); w.template number<int8_t>(64);
+			w.end();
+		}
+		w.end();
+	}
+	w.end();
+	return w.data;
+}
+
+// Counts everything visited, without touching the arrays
+struct Counter final : NBT::Visitor
+{
+	std::size_t tags = 0, values = 0;
+	bool visit(const NBT::Tag &) override { ++tags; return false; }
+	bool visit(const NBT::Value &) override { ++values; return false; }
+};
+
+template<NBT::Endianess E>
+static void benchmarkParse(const std::string & name)
+{
+	auto data = createChunk<E>();
+	NBT::Reader reader;
+
+	// All of them should see the same
+	Counter functions, visitor, parser;
+	REQUIRE(reader.parse(data, [&functions](const NBT::Tag & t) { return functions.visit(t); },
+		[&functions](const NBT::Value & v) { return functions.visit(v); }, E) == std::ptrdiff_t(data.size()));
+	REQUIRE(reader.parse(data, static_cast<NBT::Visitor &>(visitor), E) == std::ptrdiff_t(data.size()));
+	REQUIRE(reader.parse<E>(data, parser) == std::ptrdiff_t(data.size()));
+	CHECK(visitor.tags == functions.tags);
+	CHECK(parser.tags == functions.tags);
+	CHECK(parser.values == functions.values);
+
+	BENCHMARK(name + " functions")
+	{
+		return reader.parse(data, [&functions](const NBT::Tag & t) { return functions.visit(t); },
+			[&functions](const NBT::Value & v) { return functions.visit(v); }, E);
+	};
+	BENCHMARK(name + " visitor")
+	{
+		return reader.parse(data, static_cast<NBT::Visitor &>(visitor), E);
+	};
+	BENCHMARK(name + " parser")
+	{
+		return reader.parse<E>(data, parser);
+	};
+}
+
+TEST_CASE("nbt parse", "[!benchmark]")
+{
+	benchmarkParse<NBT::Endianess::BIG>("big");
+	benchmarkParse<NBT::Endianess::LITTLE>("little");
+}
+
+// Finds the heightmap, without touching the arrays
+struct Surface final : NBT::Visitor
+{
+	std::size_t found = 0;
+	bool visit(const NBT::Tag & t) override
+	{
+		if (t.id() == NBT::Id::WORLD_SURFACE)
+			++found;
+		return false;
+	}
+	bool visit(const NBT::Value &) override { return false; }
+};
+
+TEST_CASE("nbt index", "[!benchmark]")
+{
+	constexpr auto E = NBT::Endianess::BIG;
+	auto data = createChunk<E>();
+	NBT::Reader reader;
+	NBT::Query query{"Heightmaps.WORLD_SURFACE"};
+	NBT::Index index;
+
+	auto full = [&]
+	{
+		Surface surface;
+		reader.parse(data, surface, E);
+		return surface.found;
+	};
+	auto queried = [&]
+	{
+		Surface surface;
+		reader.parse(data, query, surface, E);
+		return surface.found;
+	};
+	auto jump = [&]
+	{
+		Surface surface;
+		if (auto entry = index.find(data, "Heightmaps.WORLD_SURFACE"))
+			reader.parse(data, *entry, surface, E);
+		return surface.found;
+	};
+	auto indexed = [&]
+	{
+		reader.index(data, index, E);
+		return jump();
+	};
+
+	// All of them should find it
+	CHECK(full() == 1);
+	CHECK(queried() == 1);
+	CHECK(indexed() == 1);
+	CHECK(jump() == 1);
+
+	BENCHMARK("find visitor")
+	{
+		return full();
+	};
+	BENCHMARK("find query")
+	{
+		return queried();
+	};
+	BENCHMARK("find index")
+	{
+		return indexed();
+	};
+	BENCHMARK("find cached index")
+	{
+		return jump();
+	};
+}
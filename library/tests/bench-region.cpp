@@ -0,0 +1,76 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+#include "format/region.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <map>
+#include <memory>
+
+// Create a folder with empty region files, reused between runs
+static std::string createRegionFolder(int amount)
+{
+	auto path = std::filesystem::temp_directory_path() / ("pixelmap-bench-region-" + std::to_string(amount));
+	std::filesystem::create_directories(path);
+	int side = 1;
+	while (side * side < amount)
+		++side;
+	for (int i = 0; i < amount; ++i)
+	{
+		auto file = path / ("r." + std::to_string(i % side - side / 2) + "." + std::to_string(i / side - side / 2) + ".mca");
+		if (!std::filesystem::exists(file))
+			std::ofstream(file).close();
+	}
+	return path.string();
+}
+
+TEST_CASE("region enumeration", "[!benchmark]")
+{
+	auto amount = GENERATE(10000, 100000);
+	auto path = createRegionFolder(amount);
+
+	BENCHMARK("regex " + std::to_string(amount))
+	{
+		std::map<std::pair<int, int>, int> regions;
+		std::regex r("^r\\.(-?[0-9]+)\\.(-?[0-9]+)\\.mca$");
+		for (const auto & entry : std::filesystem::directory_iterator{path})
+		{
+			if (entry.is_directory())
+				continue;
+			auto name = entry.path().filename().string();
+			std::smatch m;
+			if (!std::regex_match(name, m, r))
+				continue;
+			regions.insert({{std::stoi(m[1].str()), std::stoi(m[2].str())}, 0});
+		}
+		return regions.size();
+	};
+
+	// Same container as the regions, without reading any headers
+	BENCHMARK("parser " + std::to_string(amount))
+	{
+		region::Region::RegionsMap regions;
+		for (const auto & entry : std::filesystem::directory_iterator{path})
+		{
+			if (entry.is_directory())
+				continue;
+			int x, z;
+			if (region::parseFileName(entry.path().filename().string(), region::RegionType::ANVIL, x, z))
+				regions.emplace(std::make_pair(x, z), std::make_shared<region::RegionFile>(x, z, region::RegionType::ANVIL));
+		}
+		return regions.size();
+	};
+
+	BENCHMARK("region " + std::to_string(amount))
+	{
+		region::Region region(path);
+		std::size_t count = 0;
+		for (auto it = region.begin(); it != region.end(); ++it)
+			++count;
+		return count;
+	};
+}
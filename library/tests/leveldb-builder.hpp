@@ -0,0 +1,298 @@
+#pragma once
+#ifndef LEVELDB_BUILDER_HPP
+#define LEVELDB_BUILDER_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Helpers to build LevelDB data in memory
+
+using Entries = std::vector<std::pair<std::string, std::string>>;
+
+inline void write_varint(std::vector<uint8_t> & out, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		out.push_back(uint8_t(value | 0x80));
+	out.push_back(uint8_t(value));
+}
+
+inline void write_fixed32(std::vector<uint8_t> & out, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		out.push_back(uint8_t(value >> (i * 8)));
+}
+
+// Block with keys sharing prefix between restart points
+inline std::vector<uint8_t> build_block(const Entries & entries)
+{
+	constexpr std::size_t RESTART_INTERVAL = 16;
+	std::vector<uint8_t> block;
+	std::vector<uint32_t> restarts;
+	std::string prev;
+	for (std::size_t i = 0; i < entries.size(); ++i)
+	{
+		const auto & [key, value] = entries[i];
+		std::size_t shared = 0;
+		if (i % RESTART_INTERVAL == 0)
+			restarts.push_back(uint32_t(block.size()));
+		else
+			while (shared < prev.size() && shared < key.size() && prev[shared] == key[shared])
+				++shared;
+		write_varint(block, shared);
+		write_varint(block, key.size() - shared);
+		write_varint(block, value.size());
+		block.insert(block.end(), key.begin() + shared, key.end());
+		block.insert(block.end(), value.begin(), value.end());
+		prev = key;
+	}
+	if (restarts.empty())
+		restarts.push_back(0);
+	for (auto restart : restarts)
+		write_fixed32(block, restart);
+	write_fixed32(block, uint32_t(restarts.size()));
+	return block;
+}
+
+// Snappy stream made only of literals
+inline std::vector<uint8_t> compress_snappy(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out;
+	write_varint(out, data.size());
+	for (std::size_t i = 0; i < data.size(); i += 60)
+	{
+		auto len = std::min<std::size_t>(60, data.size() - i);
+		out.push_back(uint8_t((len - 1) << 2));
+		out.insert(out.end(), data.begin() + i, data.begin() + i + len);
+	}
+	return out;
+}
+
+// Zstandard frame with a single raw block
+inline std::vector<uint8_t> compress_zstd(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out;
+	write_fixed32(out, 0xFD2FB528);
+	// Single segment, with the content size in one or two bytes
+	if (data.size() < 256)
+	{
+		out.push_back(0x20);
+		out.push_back(uint8_t(data.size()));
+	}
+	else
+	{
+		out.push_back(0x60);
+		out.push_back(uint8_t((data.size() - 256)));
+		out.push_back(uint8_t((data.size() - 256) >> 8));
+	}
+	uint32_t header = 1 | uint32_t(data.size() << 3); // Last raw block
+	out.push_back(uint8_t(header));
+	out.push_back(uint8_t(header >> 8));
+	out.push_back(uint8_t(header >> 16));
+	out.insert(out.end(), data.begin(), data.end());
+	return out;
+}
+
+// Hash used by the bloom filter
+inline uint32_t bloom_hash(const std::string & key)
+{
+	constexpr uint32_t m = 0xc6a4a793;
+	uint32_t h = 0xbc9f1d34 ^ uint32_t(key.size() * m);
+	std::size_t i = 0;
+	for (; i + 4 <= key.size(); i += 4)
+	{
+		uint32_t w = 0;
+		for (int b = 0; b < 4; ++b)
+			w |= uint32_t(uint8_t(key[i + b])) << (b * 8);
+		h += w;
+		h *= m;
+		h ^= h >> 16;
+	}
+	if (i < key.size())
+	{
+		for (std::size_t b = key.size() - i; b-- > 0;)
+			h += uint32_t(uint8_t(key[i + b])) << (b * 8);
+		h *= m;
+		h ^= h >> 24;
+	}
+	return h;
+}
+
+// Bloom filter of the user keys, with 10 bits per key
+inline std::vector<uint8_t> build_bloom(const std::vector<std::string> & keys)
+{
+	constexpr std::size_t BITS_PER_KEY = 10;
+	constexpr uint8_t PROBES = 6;
+	auto bits = std::max<std::size_t>(keys.size() * BITS_PER_KEY, 64);
+	std::vector<uint8_t> filter((bits + 7) / 8, 0);
+	bits = filter.size() * 8;
+	for (const auto & key : keys)
+	{
+		auto h = bloom_hash(key);
+		auto delta = (h >> 17) | (h << 15);
+		for (uint8_t i = 0; i < PROBES; ++i)
+		{
+			auto pos = h % bits;
+			filter[pos / 8] |= uint8_t(1 << (pos % 8));
+			h += delta;
+		}
+	}
+	filter.push_back(PROBES);
+	return filter;
+}
+
+// Table with each block stored with the compression given, and a
+// filter block when asked for
+inline std::vector<uint8_t> build_table(const std::vector<std::pair<uint8_t, Entries>> & blocks, bool bloom = false)
+{
+	constexpr uint8_t BASE_LG = 11;
+	std::vector<uint8_t> table;
+	Entries index;
+	auto add_block = [&table](const std::vector<uint8_t> & block, uint8_t type) {
+		std::string handle;
+		std::vector<uint8_t> h;
+		write_varint(h, table.size());
+		write_varint(h, block.size());
+		table.insert(table.end(), block.begin(), block.end());
+		table.push_back(type);
+		write_fixed32(table, 0); // crc
+		return std::string(h.begin(), h.end());
+	};
+	std::vector<uint8_t> filters;
+	std::vector<uint32_t> filter_offsets;
+	std::vector<std::string> filter_keys;
+	auto add_filter = [&]() {
+		filter_offsets.push_back(uint32_t(filters.size()));
+		if (filter_keys.empty())
+			return;
+		auto filter = build_bloom(filter_keys);
+		filters.insert(filters.end(), filter.begin(), filter.end());
+		filter_keys.clear();
+	};
+	for (const auto & [type, entries] : blocks)
+	{
+		// Each filter covers the blocks starting within its range
+		while (filter_offsets.size() < (table.size() >> BASE_LG))
+			add_filter();
+		for (const auto & entry : entries)
+			filter_keys.emplace_back(entry.first.substr(0, entry.first.size() - 8));
+		auto block = build_block(entries);
+		if (type == 1)
+			block = compress_snappy(block);
+		else if (type == 3)
+			block = compress_zstd(block);
+		index.emplace_back(entries.back().first, add_block(block, type));
+	}
+	Entries meta;
+	if (bloom)
+	{
+		if (!filter_keys.empty())
+			add_filter();
+		auto offsets_start = uint32_t(filters.size());
+		for (auto offset : filter_offsets)
+			write_fixed32(filters, offset);
+		write_fixed32(filters, offsets_start);
+		filters.push_back(BASE_LG);
+		meta.emplace_back("filter.leveldb.BuiltinBloomFilter2", add_block(filters, 0));
+	}
+	auto metaindex = add_block(build_block(meta), 0);
+	auto indexHandle = add_block(build_block(index), 0);
+	std::vector<uint8_t> footer(metaindex.begin(), metaindex.end());
+	footer.insert(footer.end(), indexHandle.begin(), indexHandle.end());
+	footer.resize(40);
+	write_fixed32(footer, 0x8b80fb57);
+	write_fixed32(footer, 0xdb477524);
+	table.insert(table.end(), footer.begin(), footer.end());
+	return table;
+}
+
+// Log of records, split over blocks when needed
+inline std::vector<uint8_t> build_records(const std::vector<std::vector<uint8_t>> & records)
+{
+	constexpr std::size_t BLOCK_SIZE = 32768;
+	constexpr std::size_t HEADER_SIZE = 7;
+	std::vector<uint8_t> log;
+	for (const auto & record : records)
+	{
+		std::size_t offset = 0;
+		do
+		{
+			auto left = BLOCK_SIZE - log.size() % BLOCK_SIZE;
+			if (left < HEADER_SIZE)
+			{
+				log.resize(log.size() + left);
+				continue;
+			}
+			auto length = std::min(left - HEADER_SIZE, record.size() - offset);
+			bool first = offset == 0, last = offset + length == record.size();
+			uint8_t type = first ? (last ? 1 : 2) : (last ? 4 : 3);
+			write_fixed32(log, 0); // crc
+			log.push_back(uint8_t(length));
+			log.push_back(uint8_t(length >> 8));
+			log.push_back(type);
+			log.insert(log.end(), record.begin() + offset, record.begin() + offset + length);
+			offset += length;
+		}
+		while (offset < record.size());
+	}
+	return log;
+}
+
+// Log with each batch written as a record, followed by a batch deleting
+// keys if any
+inline std::vector<uint8_t> build_log(const std::vector<Entries> & batches, const std::vector<std::string> & deleted = {})
+{
+	std::vector<std::vector<uint8_t>> records;
+	for (const auto & entries : batches)
+	{
+		std::vector<uint8_t> batch(8, 0); // sequence
+		write_fixed32(batch, uint32_t(entries.size()));
+		for (const auto & [key, value] : entries)
+		{
+			batch.push_back(1);
+			write_varint(batch, key.size());
+			batch.insert(batch.end(), key.begin(), key.end());
+			write_varint(batch, value.size());
+			batch.insert(batch.end(), value.begin(), value.end());
+		}
+		records.emplace_back(std::move(batch));
+	}
+	if (!deleted.empty())
+	{
+		auto & batch = records.emplace_back(8, 0);
+		write_fixed32(batch, uint32_t(deleted.size()));
+		for (const auto & key : deleted)
+		{
+			batch.push_back(0);
+			write_varint(batch, key.size());
+			batch.insert(batch.end(), key.begin(), key.end());
+		}
+	}
+	return build_records(records);
+}
+
+// Manifest edit adding a file, with keys given as user keys
+inline void edit_new_file(std::vector<uint8_t> & edit, int level, uint64_t number, std::string smallest, std::string largest)
+{
+	write_varint(edit, 7);
+	write_varint(edit, level);
+	write_varint(edit, number);
+	write_varint(edit, 1024);
+	for (auto key : {smallest, largest})
+	{
+		key.append(8, '\1');
+		write_varint(edit, key.size());
+		edit.insert(edit.end(), key.begin(), key.end());
+	}
+}
+
+// Manifest edit removing a file
+inline void edit_deleted_file(std::vector<uint8_t> & edit, int level, uint64_t number)
+{
+	write_varint(edit, 6);
+	write_varint(edit, level);
+	write_varint(edit, number);
+}
+
+#endif // LEVELDB_BUILDER_HPP
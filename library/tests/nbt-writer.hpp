@@ -0,0 +1,46 @@
+#pragma once
+#ifndef NBT_WRITER_HPP
+#define NBT_WRITER_HPP
+
+#include "format/nbt.hpp"
+#include "util/endianess.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes NBT data in either byte order
+template<NBT::Endianess E>
+struct Writer
+{
+	std::vector<uint8_t> data;
+
+	template<typename T>
+	void number(T v)
+	{
+		auto size = data.size();
+		data.resize(size + sizeof(T));
+		if constexpr (E == NBT::Endianess::BIG)
+			endianess::toBig<T>(v, data.data() + size);
+		else
+			endianess::toLittle<T>(v, data.data() + size);
+	}
+	void string(const std::string & str)
+	{
+		number<uint16_t>(uint16_t(str.size()));
+		data.insert(data.end(), str.begin(), str.end());
+	}
+	void tag(NBT::Type type, const std::string & name)
+	{
+		data.push_back(type);
+		string(name);
+	}
+	void list(NBT::Type type, int32_t count)
+	{
+		data.push_back(type);
+		number<int32_t>(count);
+	}
+	void end() { data.push_back(NBT::TAG_End); }
+};
+
+#endif // NBT_WRITER_HPP
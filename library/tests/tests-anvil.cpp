@@ -0,0 +1,210 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+#include "anvil/factory.hpp"
+#include "anvil/version.hpp"
+#include "anvil/limits.hpp"
+#include "chunk.hpp"
+
+#include "nbt-writer.hpp"
+
+#include <string>
+#include <vector>
+
+using BigWriter = Writer<NBT::Endianess::BIG>;
+
+// Deterministic longs, so that every index of the palette is used
+static void write_longs(BigWriter & w, const std::string & name, int32_t count, uint64_t seed)
+{
+	w.tag(NBT::TAG_Long_Array, name);
+	w.number<int32_t>(count);
+	for (int32_t i = 0; i < count; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		w.number<int64_t>(int64_t(seed));
+	}
+}
+
+static void write_light(BigWriter & w, const std::string & name, uint8_t seed)
+{
+	w.tag(NBT::TAG_Byte_Array, name);
+	w.number<int32_t>(SECTION_SIZE >> 1);
+	for (std::size_t i = 0; i < (SECTION_SIZE >> 1); ++i)
+		w.data.push_back(uint8_t(i * 7 + seed));
+}
+
+// Palette of 16 blocks, some with properties to skip
+static void write_palette(BigWriter & w, const std::string & name, int32_t count, int section)
+{
+	w.tag(NBT::TAG_List, name);
+	w.list(NBT::TAG_Compound, count);
+	for (int32_t p = 0; p < count; ++p)
+	{
+		if (p % 3 == 1)
+		{
+			w.tag(NBT::TAG_Compound, "Properties");
+			w.tag(NBT::TAG_String, "axis"); w.string("y");
+			w.end();
+		}
+		w.tag(NBT::TAG_String, "Name"); w.string("minecraft:block_" + std::to_string(section * 3 + p));
+		w.end();
+	}
+}
+
+// Tags that are not read, placed between those that are
+static void write_noise(BigWriter & w, const std::string & entities)
+{
+	w.tag(NBT::TAG_Long, "LastUpdate"); w.number<int64_t>(1234);
+	w.tag(NBT::TAG_List, entities);
+	w.list(NBT::TAG_Compound, 2);
+	for (int e = 0; e < 2; ++e)
+	{
+		w.tag(NBT::TAG_String, "id"); w.string("minecraft:chest");
+		w.tag(NBT::TAG_List, "Items"); w.list(NBT::TAG_Compound, 1);
+		w.tag(NBT::TAG_String, "id"); w.string("minecraft:stone");
+		w.end();
+		w.end();
+	}
+	w.tag(NBT::TAG_Compound, "Structures");
+	w.tag(NBT::TAG_Compound, "References");
+	w.end();
+	w.end();
+}
+
+// Chunk as written by the versions before 1.18, within a Level compound
+static std::vector<uint8_t> createLevelChunk(int32_t dataVersion, int32_t heightmapLongs)
+{
+	BigWriter w;
+	w.tag(NBT::TAG_Compound, "");
+	w.tag(NBT::TAG_Int, "DataVersion"); w.number<int32_t>(dataVersion);
+	w.tag(NBT::TAG_Compound, "Level");
+	w.tag(NBT::TAG_Int, "xPos"); w.number<int32_t>(-3);
+	write_noise(w, "TileEntities");
+	w.tag(NBT::TAG_Int, "zPos"); w.number<int32_t>(7);
+	w.tag(NBT::TAG_Compound, "Heightmaps");
+	write_longs(w, "MOTION_BLOCKING", heightmapLongs, 1);
+	write_longs(w, "WORLD_SURFACE", heightmapLongs, 2);
+	w.end();
+	w.tag(NBT::TAG_List, "Sections");
+	w.list(NBT::TAG_Compound, 5);
+	for (int s = -1; s < 4; ++s)
+	{
+		w.tag(NBT::TAG_Byte, "Y"); w.number<int8_t>(int8_t(s));
+		// Sections below the world only have light
+		if (s >= 0)
+		{
+			write_palette(w, "Palette", 16, s);
+			write_longs(w, "BlockStates", 256, uint64_t(s + 10));
+			write_light(w, "BlockLight", uint8_t(s));
+		}
+		write_light(w, "SkyLight", uint8_t(s + 100));
+		w.end();
+	}
+	w.tag(NBT::TAG_Int_Array, "Biomes"); w.number<int32_t>(4);
+	for (int i = 0; i < 4; ++i)
+		w.number<int32_t>(i);
+	w.end();
+	w.end();
+	return w.data;
+}
+
+// Chunk as written from 1.18, with block states bundled in each section
+static std::vector<uint8_t> createChunk18(int32_t dataVersion)
+{
+	BigWriter w;
+	w.tag(NBT::TAG_Compound, "");
+	w.tag(NBT::TAG_Int, "DataVersion"); w.number<int32_t>(dataVersion);
+	w.tag(NBT::TAG_Int, "xPos"); w.number<int32_t>(-3);
+	w.tag(NBT::TAG_Int, "yPos"); w.number<int32_t>(-4);
+	w.tag(NBT::TAG_Int, "zPos"); w.number<int32_t>(7);
+	w.tag(NBT::TAG_String, "Status"); w.string("minecraft:full");
+	write_noise(w, "block_entities");
+	w.tag(NBT::TAG_List, "sections");
+	w.list(NBT::TAG_Compound, 6);
+	for (int s = -5; s < 1; ++s)
+	{
+		w.tag(NBT::TAG_Byte, "Y"); w.number<int8_t>(int8_t(s));
+		if (s >= -4)
+		{
+			w.tag(NBT::TAG_Compound, "block_states");
+			// Sections with a single block have no data
+			if (s == 0)
+				write_palette(w, "palette", 1, s);
+			else
+			{
+				write_palette(w, "palette", 16, s);
+				write_longs(w, "data", 256, uint64_t(s + 10));
+			}
+			w.end();
+			w.tag(NBT::TAG_Compound, "biomes");
+			w.tag(NBT::TAG_List, "palette"); w.list(NBT::TAG_String, 1);
+			w.string("minecraft:plains");
+			w.end();
+			write_light(w, "BlockLight", uint8_t(s));
+		}
+		write_light(w, "SkyLight", uint8_t(s + 100));
+		w.end();
+	}
+	w.tag(NBT::TAG_Compound, "Heightmaps");
+	write_longs(w, "MOTION_BLOCKING", 37, 1);
+	write_longs(w, "WORLD_SURFACE", 37, 2);
+	w.end();
+	w.tag(NBT::TAG_List, "PostProcessing"); w.list(NBT::TAG_List, 1);
+	w.list(NBT::TAG_Short, 1); w.number<int16_t>(3);
+	w.end();
+	return w.data;
+}
+
+// Parse a chunk like the anvil worker does, either fully or with the query
+static Chunk parseChunk(std::vector<uint8_t> data, bool query)
+{
+	Chunk chunk;
+	NBT::Reader reader;
+	anvil::V version(chunk);
+	auto scan = [&version](const NBT::Tag & tag) { return version.scan(tag); };
+	REQUIRE(reader.scan(data, scan, NBT::Endianess::BIG) > 0);
+	auto chunkReader = anvil::Factory::create(chunk);
+	REQUIRE(chunkReader->query());
+	auto read = query
+		? reader.parse(data, *chunkReader->query(), *chunkReader, NBT::Endianess::BIG)
+		: reader.parse(data, *chunkReader, NBT::Endianess::BIG);
+	REQUIRE(read > 0);
+	return chunk;
+}
+
+TEST_CASE("anvil query", "[anvil]")
+{
+	auto [name, data] = GENERATE(
+		std::make_pair("V13", createLevelChunk(DATA_VERSION_1_13, 36)),
+		std::make_pair("V16", createLevelChunk(DATA_VERSION_1_16, 37)),
+		std::make_pair("V18", createChunk18(DATA_VERSION_1_18)));
+	CAPTURE(name);
+
+	auto full = parseChunk(data, false);
+	auto queried = parseChunk(data, true);
+
+	REQUIRE(full.isValid());
+	CHECK(queried.isValid());
+	CHECK(queried.getDataVersion() == full.getDataVersion());
+	CHECK(queried.getX() == full.getX());
+	CHECK(queried.getZ() == full.getZ());
+	CHECK(queried.getY() == full.getY());
+	REQUIRE(queried.getMinY() == full.getMinY());
+	REQUIRE(queried.getMaxY() == full.getMaxY());
+	CHECK(queried.getNSPalette() == full.getNSPalette());
+	// Every palette entry was read
+	CHECK(full.getNSPalette().size() > 16);
+	for (int z = 0; z < SECTION_Z; ++z)
+		for (int x = 0; x < SECTION_X; ++x)
+			REQUIRE(queried.getHeight({x, z}) == full.getHeight({x, z}));
+	for (int y = full.getMinY(); y <= full.getMaxY(); ++y)
+		for (int z = 0; z < SECTION_Z; ++z)
+			for (int x = 0; x < SECTION_X; ++x)
+			{
+				auto a = full.getTile({x, y, z});
+				auto b = queried.getTile({x, y, z});
+				REQUIRE(b.index == a.index);
+				REQUIRE(b.blockLight == a.blockLight);
+				REQUIRE(b.skyLight == a.skyLight);
+			}
+}
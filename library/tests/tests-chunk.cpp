@@ -0,0 +1,161 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+#include "chunk.hpp"
+#include "anvil/limits.hpp"
+
+#include <vector>
+
+TEST_CASE("chunk", "[chunk]")
+{
+	SECTION("empty")
+	{
+		SectionData section;
+		CHECK_FALSE(section.allocated());
+		auto tile = section.getTile({1, 2, 3});
+		CHECK(tile.index == 0);
+		CHECK(tile.blockLight == 0);
+		CHECK(tile.skyLight == 0);
+	}
+	SECTION("uniform")
+	{
+		SectionData section;
+		section.setBlocks({7});
+		CHECK(section.allocated());
+		CHECK(section.getTile({0, 0, 0}).index == 7);
+		CHECK(section.getTile({15, 15, 15}).index == 7);
+
+		section.transform([](uint16_t i) -> uint16_t { return i + 1; });
+		CHECK(section.getTile({3, 4, 5}).index == 8);
+
+		section.clear();
+		CHECK(section.allocated());
+		CHECK(section.getTile({3, 4, 5}).index == 0);
+	}
+	SECTION("packed")
+	{
+		// Widths that do and do not divide into words
+		auto palette = GENERATE(2, 3, 16, 17, 100, 4096);
+		std::vector<uint16_t> blocks(SECTION_SIZE);
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+			blocks[i] = uint16_t((i * 31 + 7) % std::size_t(palette));
+
+		SectionData section;
+		section.setBlocks(blocks);
+		auto check = [&section, &blocks](auto convert)
+		{
+			for (int y = 0; y < SECTION_Y; ++y)
+				for (int z = 0; z < SECTION_Z; ++z)
+					for (int x = 0; x < SECTION_X; ++x)
+						REQUIRE(section.getTile({x, y, z}).index == convert(blocks[std::size_t(y * SECTION_X * SECTION_Z + z * SECTION_X + x)]));
+		};
+		check([](uint16_t i) { return i; });
+
+		// May need more bits afterwards
+		section.transform([](uint16_t i) -> uint16_t { return i * 3; });
+		check([](uint16_t i) { return uint16_t(i * 3); });
+	}
+	SECTION("block order")
+	{
+		std::vector<uint16_t> blocks(SECTION_SIZE);
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+			blocks[i] = uint16_t(i);
+		SectionData section;
+		section.setBlockOrder(BlockOrder::XZY);
+		section.setBlocks(blocks);
+		CHECK(section.getTile({1, 2, 3}).index == 1 * SECTION_Y * SECTION_Z + 3 * SECTION_Y + 2);
+	}
+	SECTION("light")
+	{
+		std::vector<int8_t> nibbles(SECTION_SIZE >> 1);
+		for (std::size_t i = 0; i < nibbles.size(); ++i)
+			nibbles[i] = int8_t(i * 17);
+		std::vector<uint8_t> values(SECTION_SIZE);
+		for (std::size_t i = 0; i < values.size(); ++i)
+			values[i] = uint8_t(i % 16);
+
+		SectionData section;
+		section.setSkyLight(nibbles);
+		CHECK(section.allocated());
+		section.setBlockLight(values);
+		for (int x = 0; x < SECTION_X; ++x)
+		{
+			auto tile = section.getTile({x, 1, 0});
+			auto i = std::size_t(SECTION_X * SECTION_Z + x);
+			CHECK(tile.index == 0);
+			CHECK(tile.skyLight == ((i % 2 == 0 ? uint8_t(nibbles[i >> 1]) : uint8_t(nibbles[i >> 1]) >> 4) & 0x0F));
+			CHECK(tile.blockLight == values[i]);
+		}
+
+		section.clear();
+		CHECK(section.getTile({5, 1, 0}).skyLight == 0);
+		CHECK(section.getTile({5, 1, 0}).blockLight == 0);
+	}
+	SECTION("chunk")
+	{
+		Chunk chunk;
+		SectionData section;
+		section.setY(-1);
+		section.setBlocks({3});
+		chunk.setSection(std::move(section));
+		CHECK(chunk.hasSection({0, -5, 0}));
+		CHECK(chunk.getTile({0, -5, 0}).index == 3);
+		CHECK(chunk.getTile({-20, -16, 40}).index == 3);
+		CHECK(chunk.getTile({0, 5, 0}).index == 0);
+	}
+	SECTION("merge")
+	{
+		auto section = [](int32_t y, uint16_t index) {
+			SectionData section;
+			section.setY(y);
+			section.setBlocks({index});
+			return section;
+		};
+		auto name = [](const Chunk & chunk, utility::BlockPosition pos) {
+			return chunk.getNSPalette()[chunk.getTile(pos).index];
+		};
+
+		Chunk chunk;
+		chunk.setPaletteType(PaletteType::NAMESPACEID);
+		chunk.addPalette("air");
+		chunk.addPalette("stone");
+		chunk.setSection(section(0, 1));
+		chunk.setHeightMap(std::vector<int32_t>(SECTION_AREA, 5));
+		chunk.setDataVersion(100);
+
+		// Partial chunks without anything keep what is there
+		Chunk empty;
+		chunk.merge(empty);
+		CHECK(name(chunk, {0, 0, 0}) == "stone");
+		CHECK(chunk.getHeight({0, 0}) == 5);
+		CHECK(chunk.getDataVersion() == 100);
+
+		// Sections are added and the palettes combined
+		Chunk other;
+		other.setPaletteType(PaletteType::NAMESPACEID);
+		other.addPalette("dirt");
+		other.addPalette("stone");
+		other.setSection(section(1, 0));
+		chunk.merge(other);
+		CHECK(name(chunk, {0, 0, 0}) == "stone");
+		CHECK(name(chunk, {0, 16, 0}) == "dirt");
+		CHECK(chunk.getMinY() == 0);
+		CHECK(chunk.getMaxY() == 31);
+		CHECK(chunk.getHeight({0, 0}) == 5);
+		CHECK(chunk.getDataVersion() == 100);
+
+		// Other palettes replace everything
+		Chunk ids;
+		ids.setPaletteType(PaletteType::BLOCKID);
+		ids.addPalette(uint16_t(42));
+		ids.setSection(section(2, 0));
+		ids.setHeightMap(std::vector<int32_t>(SECTION_AREA, 40));
+		ids.setDataVersion(200);
+		chunk.merge(ids);
+		CHECK(chunk.getPaletteType() == PaletteType::BLOCKID);
+		CHECK_FALSE(chunk.hasSection({0, 0, 0}));
+		CHECK(chunk.getIDPalette()[chunk.getTile({0, 32, 0}).index] == 42);
+		CHECK(chunk.getHeight({0, 0}) == 40);
+		CHECK(chunk.getDataVersion() == 200);
+	}
+}
@@ -0,0 +1,217 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "util/compression.hpp"
+
+#include <cstdint>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Deflate stream made only of stored blocks
+static std::vector<uint8_t> compress_raw(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out;
+	std::size_t i = 0;
+	do
+	{
+		auto len = std::min<std::size_t>(65535, data.size() - i);
+		out.push_back(i + len == data.size() ? 1 : 0);
+		out.push_back(uint8_t(len));
+		out.push_back(uint8_t(len >> 8));
+		out.push_back(uint8_t(~len));
+		out.push_back(uint8_t(~len >> 8));
+		out.insert(out.end(), data.begin() + i, data.begin() + i + len);
+		i += len;
+	}
+	while (i < data.size());
+	return out;
+}
+
+static std::vector<uint8_t> compress_zlib(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out{0x78, 0x01};
+	auto raw = compress_raw(data);
+	out.insert(out.end(), raw.begin(), raw.end());
+	uint32_t a = 1, b = 0;
+	for (auto c : data)
+	{
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+	uint32_t adler = (b << 16) | a;
+	for (int s = 24; s >= 0; s -= 8)
+		out.push_back(uint8_t(adler >> s));
+	return out;
+}
+
+static std::vector<uint8_t> compress_gzip(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out{0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+	auto raw = compress_raw(data);
+	out.insert(out.end(), raw.begin(), raw.end());
+	uint32_t crc = 0xFFFFFFFF;
+	for (auto c : data)
+	{
+		crc ^= c;
+		for (int k = 0; k < 8; ++k)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	crc = ~crc;
+	for (auto value : {crc, uint32_t(data.size())})
+		for (int s = 0; s < 32; s += 8)
+			out.push_back(uint8_t(value >> s));
+	return out;
+}
+
+// LZ4 block made of a single literal run
+static std::vector<uint8_t> compress_lz4(const std::vector<uint8_t> & data)
+{
+	std::vector<uint8_t> out;
+	auto len = data.size();
+	out.push_back(uint8_t(std::min<std::size_t>(len, 15) << 4));
+	if (len >= 15)
+	{
+		for (len -= 15; len >= 255; len -= 255)
+			out.push_back(255);
+		out.push_back(uint8_t(len));
+	}
+	out.insert(out.end(), data.begin(), data.end());
+	return out;
+}
+
+static std::vector<uint8_t> create_data(std::size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (std::size_t i = 0; i < size; ++i)
+		data[i] = uint8_t(i * 7 + i / 251);
+	return data;
+}
+
+static VectorView<const uint8_t> view(const std::vector<uint8_t> & data)
+{
+	return {data.data(), data.size()};
+}
+
+TEST_CASE("deflate", "[compression]")
+{
+	auto small = create_data(100);
+	// Larger than any initial buffer
+	auto large = create_data(300000);
+
+	SECTION("formats")
+	{
+		REQUIRE(Compression::loadZLib(compress_zlib(small)) == small);
+		REQUIRE(Compression::loadZLibRaw(compress_raw(small)) == small);
+		REQUIRE(Compression::loadGZip(compress_gzip(small)) == small);
+		REQUIRE(Compression::loadZLib(compress_zlib(large)) == large);
+		REQUIRE(Compression::loadGZip(compress_gzip(large)) == large);
+	}
+
+	SECTION("reuse")
+	{
+		std::vector<uint8_t> data;
+		REQUIRE(Compression::loadZLib(view(compress_zlib(large)), data));
+		REQUIRE(data == large);
+		auto capacity = data.capacity();
+		REQUIRE(Compression::loadZLib(view(compress_zlib(small)), data));
+		REQUIRE(data == small);
+		REQUIRE(data.capacity() == capacity);
+		// Switch format on the same thread
+		REQUIRE(Compression::loadGZip(view(compress_gzip(small)), data));
+		REQUIRE(data == small);
+		REQUIRE(Compression::loadZLibRaw(view(compress_raw(large)), data));
+		REQUIRE(data == large);
+		REQUIRE(Compression::loadZLib(view(compress_zlib(small)), data));
+		REQUIRE(data == small);
+	}
+
+	SECTION("hint")
+	{
+		// Sized up front, so never grown
+		std::vector<uint8_t> data;
+		REQUIRE(Compression::loadZLib(view(compress_zlib(large)), data, large.size()));
+		REQUIRE(data == large);
+		REQUIRE(data.capacity() == large.size());
+		// Stored in the trailer
+		std::vector<uint8_t> gzip;
+		REQUIRE(Compression::loadGZip(view(compress_gzip(large)), gzip));
+		REQUIRE(gzip == large);
+		REQUIRE(gzip.capacity() == large.size());
+		// Too small still works
+		std::vector<uint8_t> raw;
+		REQUIRE(Compression::loadZLibRaw(view(compress_raw(large)), raw, small.size()));
+		REQUIRE(raw == large);
+	}
+
+	SECTION("invalid")
+	{
+		std::vector<uint8_t> data = small;
+		std::vector<uint8_t> invalid{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+		REQUIRE_FALSE(Compression::loadZLib(view(invalid), data));
+		REQUIRE(data.empty());
+		REQUIRE(Compression::loadGZip(invalid).empty());
+		REQUIRE_FALSE(Compression::loadZLib(view({}), data));
+		// Still usable after an error
+		REQUIRE(Compression::loadZLib(view(compress_zlib(small)), data));
+		REQUIRE(data == small);
+	}
+}
+
+TEST_CASE("deflate backends", "[compression]")
+{
+	auto large = create_data(300000);
+	auto previous = Compression::getBackend();
+
+	REQUIRE(Compression::hasBackend(Compression::Backend::ZLIB));
+	for (auto backend : {Compression::Backend::ZLIB, Compression::Backend::LIBDEFLATE, Compression::Backend::ZLIBNG})
+	{
+		if (!Compression::hasBackend(backend))
+		{
+			REQUIRE_FALSE(Compression::setBackend(backend));
+			continue;
+		}
+		INFO(Compression::getBackendName(backend));
+		REQUIRE(Compression::setBackend(backend));
+		REQUIRE(Compression::getBackend() == backend);
+		std::vector<uint8_t> data;
+		REQUIRE(Compression::loadZLib(view(compress_zlib(large)), data));
+		REQUIRE(data == large);
+		REQUIRE(Compression::loadGZip(view(compress_gzip(large)), data));
+		REQUIRE(data == large);
+		REQUIRE(Compression::loadZLibRaw(view(compress_raw(large)), data, 100));
+		REQUIRE(data == large);
+		REQUIRE_FALSE(Compression::loadZLib(view({0xFF, 0xFF, 0xFF, 0xFF}), data));
+	}
+
+	Compression::setBackend(previous);
+}
+
+TEST_CASE("lz4", "[compression]")
+{
+	auto small = create_data(100);
+	auto large = create_data(300000);
+
+	REQUIRE(Compression::loadLZ4(compress_lz4(small)) == small);
+	REQUIRE(Compression::loadLZ4(compress_lz4(large)) == large);
+
+	// Sized exactly from the sequences
+	std::vector<uint8_t> data;
+	REQUIRE(Compression::loadLZ4(view(compress_lz4(large)), data));
+	REQUIRE(data == large);
+	REQUIRE(data.capacity() == large.size());
+	REQUIRE(Compression::loadLZ4(view(compress_lz4(small)), data));
+	REQUIRE(data == small);
+
+	// Literals, a match repeating them, then the last literals
+	std::vector<uint8_t> matched{0x84, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 8, 0,
+		0x80, 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p'};
+	std::string expected = "abcdefghabcdefghijklmnop";
+	REQUIRE(Compression::loadLZ4(view(matched), data));
+	REQUIRE(std::string(data.begin(), data.end()) == expected);
+
+	// Claims more literals than there are
+	auto invalid = compress_lz4(small);
+	invalid.resize(50);
+	REQUIRE_FALSE(Compression::loadLZ4(view(invalid), data));
+	REQUIRE(data.empty());
+}
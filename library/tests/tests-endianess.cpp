@@ -202,4 +202,56 @@ TEST_CASE("endianess", "[utility]")
 			REQUIRE(_out == _test);
 		}
 	}
+	SECTION("swap")
+	{
+		// Cover both vectors and the remaining values, unaligned
+		auto check = [](auto tag)
+		{
+			using T = decltype(tag);
+			for (std::size_t count = 0; count < 40; ++count)
+			{
+				std::vector<uint8_t> _buf(1 + count * sizeof(T)), _verify(_buf.size());
+				for (std::size_t i = 0; i < _buf.size(); ++i)
+					_buf[i] = uint8_t(i * 7 + 1);
+				_verify[0] = _buf[0];
+				for (std::size_t i = 0; i < count; ++i)
+					for (std::size_t j = 0; j < sizeof(T); ++j)
+						_verify[1 + i * sizeof(T) + j] = _buf[1 + i * sizeof(T) + sizeof(T) - 1 - j];
+				endianess::swap<sizeof(T)>(_buf.data() + 1, count);
+				REQUIRE_THAT(_buf, Equals(_verify));
+			}
+		};
+		SECTION("short")
+		{
+			check(uint16_t());
+		}
+		SECTION("int")
+		{
+			check(uint32_t());
+		}
+		SECTION("long")
+		{
+			check(uint64_t());
+		}
+	}
+	SECTION("array")
+	{
+		std::vector<int64_t> _test = {0, 1, -1, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(), 0x0102030405060708};
+		SECTION("big")
+		{
+			std::vector<int64_t> _out(_test.size());
+			for (std::size_t i = 0; i < _test.size(); ++i)
+				endianess::toBig<int64_t>(_test[i], reinterpret_cast<uint8_t *>(&_out[i]));
+			endianess::fromBigArray(_out.data(), _out.size());
+			REQUIRE_THAT(_out, Equals(_test));
+		}
+		SECTION("little")
+		{
+			std::vector<int64_t> _out(_test.size());
+			for (std::size_t i = 0; i < _test.size(); ++i)
+				endianess::toLittle<int64_t>(_test[i], reinterpret_cast<uint8_t *>(&_out[i]));
+			endianess::fromLittleArray(_out.data(), _out.size());
+			REQUIRE_THAT(_out, Equals(_test));
+		}
+	}
 }
@@ -0,0 +1,150 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "filecache.hpp"
+#include "sharedfile.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+TEST_CASE("file cache", "[utility]")
+{
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-filecache";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+	std::vector<std::string> files;
+	for (int i = 0; i < 4; ++i)
+	{
+		auto file = (path / std::to_string(i)).string();
+		std::ofstream out(file, std::ios::binary);
+		out << "file " << i;
+		files.push_back(file);
+	}
+
+	FileCache cache(2);
+	SECTION("read")
+	{
+		auto handle = cache.acquire(files[1]);
+		REQUIRE(handle);
+		CHECK(handle.size() == 6);
+		char buffer[6];
+		REQUIRE(handle.read(buffer, 6, 0) == 6);
+		CHECK(std::memcmp(buffer, "file 1", 6) == 0);
+		CHECK(handle.read(buffer, 6, 4) == 2);
+		CHECK_FALSE(cache.acquire((path / "missing").string()));
+	}
+	SECTION("map")
+	{
+		std::size_t size = 0;
+		std::shared_ptr<void> mapped;
+		{
+			auto handle = cache.acquire(files[2]);
+			REQUIRE(handle);
+			mapped = handle.map(size);
+		}
+		// Valid after the file is returned and closed
+		cache.clear();
+		REQUIRE(mapped);
+		REQUIRE(size == 6);
+		CHECK(std::memcmp(mapped.get(), "file 2", 6) == 0);
+	}
+	SECTION("changed")
+	{
+		{
+			auto handle = cache.acquire(files[3]);
+			REQUIRE(handle);
+			CHECK(handle.size() == 6);
+		}
+		// Grown while idle, like a log still being written
+		std::ofstream(files[3], std::ios::binary | std::ios::app) << " grown";
+		auto handle = cache.acquire(files[3]);
+		REQUIRE(handle);
+		REQUIRE(handle.size() == 12);
+		char buffer[12];
+		REQUIRE(handle.read(buffer, 12, 0) == 12);
+		CHECK(std::memcmp(buffer, "file 3 grown", 12) == 0);
+		handle.release();
+		// Replaced while idle
+		std::ofstream(files[3] + ".new", std::ios::binary) << "new";
+		std::filesystem::rename(files[3] + ".new", files[3]);
+		handle = cache.acquire(files[3]);
+		REQUIRE(handle);
+		CHECK(handle.size() == 3);
+		handle.release();
+		// Gone while idle
+		std::filesystem::remove(files[3]);
+		CHECK_FALSE(cache.acquire(files[3]));
+	}
+	SECTION("borrowed are kept open")
+	{
+		// Above capacity while borrowed
+		auto first = cache.acquire(files[0]);
+		auto second = cache.acquire(files[1]);
+		auto third = cache.acquire(files[2]);
+		REQUIRE(first);
+		REQUIRE(second);
+		REQUIRE(third);
+		char c;
+		CHECK(first.read(&c, 1, 5) == 1);
+		CHECK(c == '0');
+		first.release();
+		second.release();
+		third.release();
+		// Each may be borrowed again, evicting the least recently used
+		for (int round = 0; round < 3; ++round)
+			for (std::size_t i = 0; i < files.size(); ++i)
+			{
+				auto handle = cache.acquire(files[i]);
+				REQUIRE(handle);
+				REQUIRE(handle.read(&c, 1, 5) == 1);
+				CHECK(c == char('0' + i));
+			}
+	}
+
+	std::filesystem::remove_all(path);
+}
+
+// Shared file of a file given by path
+class PlainFile : public SharedFile
+{
+public:
+	bool open(const std::string & path) override { _path = path; return openFile(path); }
+	std::string file() const override { return _path; }
+
+private:
+	std::string _path;
+};
+
+TEST_CASE("shared file", "[utility]")
+{
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-sharedfile";
+	std::filesystem::create_directories(path);
+	auto file = (path / "file").string();
+	auto empty = (path / "empty").string();
+	std::ofstream(file, std::ios::binary) << "content";
+	std::ofstream(empty, std::ios::binary).close();
+
+	SECTION("load")
+	{
+		PlainFile shared;
+		REQUIRE(shared.open(file));
+		auto data = shared.load();
+		REQUIRE(data.size() == 7);
+		CHECK(std::memcmp(data.data(), "content", 7) == 0);
+		CHECK(shared.getLastError().empty());
+	}
+	SECTION("not mapped")
+	{
+		// Nothing to map, so it is read instead without an error
+		PlainFile shared;
+		REQUIRE(shared.open(empty));
+		CHECK(shared.load().empty());
+		CHECK(shared.getLastError().empty());
+		CHECK(shared.map().empty());
+		CHECK_FALSE(shared.getLastError().empty());
+	}
+
+	FileCache::global().clear();
+	std::filesystem::remove_all(path);
+}
@@ -0,0 +1,98 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "bedrock/fileranges.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using BlockHandle = LevelDB::LevelReader::BlockHandle;
+
+// Parse the blocks in ranges over several threads, returning the blocks parsed by each range
+static std::vector<std::vector<BlockHandle>> parse_ranges(const std::vector<BlockHandle> & blocks, std::size_t count, std::size_t threads)
+{
+	std::mutex mutex;
+	std::vector<std::vector<BlockHandle>> parsed(count);
+	int finished = 0;
+	bool complete = true;
+	auto parse = [&mutex, &parsed](std::size_t i, VectorView<const BlockHandle> range) {
+		std::lock_guard<std::mutex> lock(mutex);
+		parsed[i].assign(range.begin(), range.end());
+		return i == 1 ? std::string("failed") : std::string();
+	};
+	// Note: May be called on any of the threads, so check afterwards
+	auto finish = [&mutex, &parsed, &finished, &complete](bedrock::FileRanges & ranges) {
+		std::lock_guard<std::mutex> lock(mutex);
+		++finished;
+		// Every range is parsed before finishing
+		for (std::size_t i = 0; i < ranges.size(); ++i)
+			complete = complete && parsed[i].size() == ranges.range(i).size() && ranges.error(i) == (i == 1 ? "failed" : "");
+	};
+	auto copy = blocks;
+	bedrock::FileRanges ranges(std::move(copy), count, std::move(parse), std::move(finish));
+	REQUIRE(ranges.size() == count);
+	std::vector<std::thread> helpers;
+	for (std::size_t i = 1; i < threads; ++i)
+		helpers.emplace_back([&ranges]() { ranges.work(); });
+	ranges.work();
+	for (auto & helper : helpers)
+		helper.join();
+	CHECK(finished == 1);
+	CHECK(complete);
+	return parsed;
+}
+
+// Every block is parsed once, in order, by ranges of about the same size
+static void check_ranges(const std::vector<BlockHandle> & blocks, const std::vector<std::vector<BlockHandle>> & parsed)
+{
+	std::vector<BlockHandle> all;
+	std::size_t smallest = blocks.size(), largest = 0;
+	for (const auto & range : parsed)
+	{
+		all.insert(all.end(), range.begin(), range.end());
+		smallest = (std::min)(smallest, range.size());
+		largest = (std::max)(largest, range.size());
+	}
+	REQUIRE(all.size() == blocks.size());
+	for (std::size_t i = 0; i < all.size(); ++i)
+	{
+		CHECK(all[i].offset == blocks[i].offset);
+		CHECK(all[i].size == blocks[i].size);
+	}
+	CHECK(largest - smallest <= 1);
+}
+
+TEST_CASE("file ranges", "[bedrock]")
+{
+	SECTION("adjacent")
+	{
+		std::vector<BlockHandle> blocks;
+		for (uint64_t i = 0; i < 100; ++i)
+			blocks.push_back({i * 4096, 4091});
+		for (std::size_t threads = 1; threads <= 4; ++threads)
+			check_ranges(blocks, parse_ranges(blocks, 4, threads));
+	}
+	SECTION("overlapping")
+	{
+		std::vector<BlockHandle> blocks;
+		for (uint64_t i = 0; i < 9; ++i)
+			blocks.push_back({i * 100, 250});
+		check_ranges(blocks, parse_ranges(blocks, 3, 3));
+	}
+	SECTION("disjoint")
+	{
+		// Blocks filtered out leave gaps
+		std::vector<BlockHandle> blocks{{0, 10}, {4096, 10}, {65536, 10}};
+		auto parsed = parse_ranges(blocks, 5, 2);
+		check_ranges(blocks, parsed);
+		CHECK(parsed[0].empty());
+	}
+	SECTION("single")
+	{
+		std::vector<BlockHandle> blocks{{0, 10}, {15, 10}};
+		auto parsed = parse_ranges(blocks, 1, 1);
+		REQUIRE(parsed.size() == 1);
+		check_ranges(blocks, parsed);
+	}
+}
@@ -2,9 +2,38 @@
 #include "catch2/generators/catch_generators.hpp"
 
 #include "format/varint.hpp"
+#include "format/leveldb.hpp"
+#include "util/compression.hpp"
+
+#include "bedrock/parse.hpp"
+
+#include "leveldb-builder.hpp"
+
+#ifdef USE_SNAPPY
+#include "snappy.h"
+#endif
+#ifdef USE_ZSTD
+#include "zstd.h"
+#endif
 
 #include <limits>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <cmath>
+#include <string>
+#include <vector>
+
+static Entries parse_table(std::vector<uint8_t> & table)
+{
+	Entries entries;
+	LevelDB::LevelReader reader;
+	auto ret = reader.parse(table, [&entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+		entries.emplace_back(std::string(key.begin(), key.end()), std::string(value.begin(), value.end()));
+	});
+	REQUIRE(ret == 0);
+	return entries;
+}
 
 TEST_CASE("varint", "[format]")
 {
@@ -135,6 +164,585 @@ TEST_CASE("varint", "[format]")
 	}
 }
 
+TEST_CASE("leveldb table", "[format]")
+{
+	Entries first, second;
+	for (int i = 0; i < 40; ++i)
+		first.emplace_back("key" + std::to_string(100 + i), std::string(i, char('a' + i % 26)));
+	for (int i = 0; i < 40; ++i)
+		second.emplace_back("key" + std::to_string(200 + i), std::string(i * 3, char('A' + i % 26)));
+	auto all = first;
+	all.insert(all.end(), second.begin(), second.end());
+
+	SECTION("raw")
+	{
+		auto table = build_table({{0, first}, {0, second}});
+		REQUIRE(parse_table(table) == all);
+	}
+	SECTION("prefix")
+	{
+		// Keys both growing and shrinking from the previous one
+		Entries keys{{"a", "1"}, {"abcdef", "2"}, {"abcdeg", "3"}, {"abd", "4"}, {"abdx", ""}, {"b", "5"}};
+		auto table = build_table({{0, keys}});
+		REQUIRE(parse_table(table) == keys);
+	}
+	SECTION("broken block")
+	{
+		// Marked as zlib, which the raw content is not
+		auto table = build_table({{0, first}, {0, second}});
+		table[build_block(first).size()] = 2;
+		LevelDB::LevelReader reader;
+		REQUIRE(reader.parse(table, [](const LevelDB::VectorData &, const LevelDB::VectorData &) {}) < 0);
+	}
+#ifdef USE_SNAPPY
+	SECTION("snappy")
+	{
+		auto table = build_table({{1, first}, {1, second}});
+		REQUIRE(parse_table(table) == all);
+	}
+#endif
+#ifdef USE_ZSTD
+	SECTION("zstd")
+	{
+		auto table = build_table({{3, first}, {3, second}});
+		REQUIRE(parse_table(table) == all);
+	}
+#endif
+#if defined(USE_SNAPPY) && defined(USE_ZSTD)
+	SECTION("mixed")
+	{
+		auto table = build_table({{1, first}, {3, second}});
+		REQUIRE(parse_table(table) == all);
+	}
+#endif
+}
+
+TEST_CASE("leveldb log", "[format]")
+{
+	std::vector<Entries> batches;
+	Entries all;
+	// Small batches fitting in a record, and large ones spanning blocks
+	for (int i = 0; i < 20; ++i)
+	{
+		Entries entries;
+		for (int j = 0; j < 4; ++j)
+			entries.emplace_back("key" + std::to_string(i * 4 + j), std::string(i % 3 == 0 ? 20000 : 10 + j, char('a' + i)));
+		all.insert(all.end(), entries.begin(), entries.end());
+		batches.emplace_back(std::move(entries));
+	}
+	auto log = build_log(batches);
+	REQUIRE(log.size() > 32768 * 4);
+
+	Entries entries;
+	LevelDB::LogReader reader;
+	auto ret = reader.parse(log, [&entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+		entries.emplace_back(std::string(key.begin(), key.end()), std::string(value.begin(), value.end()));
+	});
+	REQUIRE(ret == 0);
+	REQUIRE(entries == all);
+
+	SECTION("trailer")
+	{
+		// First record ends 3 bytes before the end of the block
+		std::vector<Entries> padded{{{"key0", std::string(32737, 'a')}}, {{"key1", "b"}}};
+		auto padded_log = build_log(padded);
+		REQUIRE(padded_log.size() == 32768 + 7 + 12 + 8);
+		Entries padded_entries;
+		REQUIRE(reader.parse(padded_log, [&padded_entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+			padded_entries.emplace_back(std::string(key.begin(), key.end()), std::string(value.begin(), value.end()));
+		}) == 0);
+		REQUIRE(padded_entries == Entries{padded[0][0], padded[1][0]});
+	}
+	SECTION("fragment")
+	{
+		// Turn the first record into the middle of a fragment
+		log[6] = 3;
+		REQUIRE(reader.parse(log, [](const LevelDB::VectorData &, const LevelDB::VectorData &) {}) < 0);
+	}
+}
+
+// Key as stored in a table, with a sequence number and type
+static std::string internal_key(std::string key)
+{
+	return key.append(8, '\1');
+}
+
+static void write_file(const std::filesystem::path & file, const std::vector<uint8_t> & data)
+{
+	std::ofstream out(file, std::ios::binary);
+	out.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+TEST_CASE("leveldb manifest", "[format]")
+{
+	std::vector<uint8_t> first, second;
+	std::string comparator = "leveldb.BytewiseComparator";
+	write_varint(first, 1);
+	write_varint(first, comparator.size());
+	first.insert(first.end(), comparator.begin(), comparator.end());
+	write_varint(first, 2);
+	write_varint(first, 5);
+	edit_new_file(first, 1, 2, "a", "m");
+	edit_new_file(first, 1, 3, "n", "z");
+	// Move a file down and add a new one
+	edit_deleted_file(second, 1, 2);
+	edit_new_file(second, 2, 2, "a", "m");
+	edit_new_file(second, 0, 7, "c", "d");
+	write_varint(second, 2);
+	write_varint(second, 8);
+	write_varint(second, 3);
+	write_varint(second, 9);
+
+	LevelDB::ManifestReader reader;
+	LevelDB::Version version;
+
+	SECTION("edits")
+	{
+		auto manifest = build_records({first, second});
+		REQUIRE(reader.parse(manifest, version) == 0);
+		REQUIRE(version.logNumber == 8);
+		REQUIRE(version.nextFileNumber == 9);
+		REQUIRE(version.files.size() == 3);
+		CHECK(version.files[0].number == 2);
+		CHECK(version.files[0].level == 2);
+		CHECK(version.files[1].number == 3);
+		CHECK(version.files[1].level == 1);
+		CHECK(version.files[2].number == 7);
+		CHECK(version.files[2].level == 0);
+		CHECK(version.files[2].smallest == std::vector<uint8_t>{'c', 1, 1, 1, 1, 1, 1, 1, 1});
+	}
+	SECTION("truncated")
+	{
+		second.pop_back();
+		second.back() |= 128;
+		auto manifest = build_records({first, second});
+		REQUIRE(reader.parse(manifest, version) < 0);
+	}
+	SECTION("unknown tag")
+	{
+		write_varint(second, 8);
+		auto manifest = build_records({first, second});
+		REQUIRE(reader.parse(manifest, version) < 0);
+	}
+}
+
+TEST_CASE("leveldb live files", "[format]")
+{
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-leveldb";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+
+	std::vector<uint8_t> edit;
+	write_varint(edit, 2);
+	write_varint(edit, 8);
+	// Previous log, still being compacted
+	write_varint(edit, 9);
+	write_varint(edit, 5);
+	edit_new_file(edit, 2, 2, "a", "m");
+	edit_new_file(edit, 1, 3, "n", "z");
+	edit_new_file(edit, 2, 11, "q", "q");
+	edit_new_file(edit, 0, 6, "d", "e");
+	edit_new_file(edit, 0, 7, "c", "d");
+	write_file(path / "MANIFEST-000001", build_records({edit}));
+	std::ofstream(path / "CURRENT") << "MANIFEST-000001\n";
+
+	write_file(path / "000002.ldb", build_table({{0, {{internal_key("a"), "old"}, {internal_key("c"), "old"}, {internal_key("m"), "old"}}}}));
+	write_file(path / "000003.ldb", build_table({{0, {{internal_key("n"), "old"}}}}));
+	// Left behind by a compaction
+	write_file(path / "000004.ldb", build_table({{0, {{internal_key("c"), "dead"}}}}));
+	write_file(path / "000006.ldb", build_table({{0, {{internal_key("d"), "new"}, {internal_key("e"), "new"}}}}));
+	write_file(path / "000007.ldb", build_table({{0, {{internal_key("c"), "new"}, {internal_key("d"), "new"}}}}));
+	write_file(path / "000011.ldb", build_table({{0, {{internal_key("q"), "old"}}}}));
+	// Already written to tables
+	write_file(path / "000004.log", {});
+	write_file(path / "000005.log", {});
+	write_file(path / "000008.log", {});
+	write_file(path / "000010.log", {});
+
+	LevelDB::LevelDB leveldb(path.string());
+	std::vector<std::vector<std::string>> passes, keys;
+	for (auto & pass : leveldb.passes())
+	{
+		passes.emplace_back();
+		for (auto & file : pass)
+		{
+			passes.back().emplace_back(file->file());
+			keys.emplace_back(file->readKeys(nullptr));
+		}
+	}
+	// Newest first, with each file in level 0 a pass of its own
+	REQUIRE(passes == std::vector<std::vector<std::string>>{{"000007.ldb"}, {"000006.ldb"}, {"000003.ldb"}, {"000011.ldb", "000002.ldb"}});
+	CHECK(keys[0] == std::vector<std::string>{"c", "d"});
+	CHECK(keys[1] == std::vector<std::string>{"d", "e"});
+	CHECK(keys[2] == std::vector<std::string>{"n"});
+	CHECK(keys[3] == std::vector<std::string>{"q"});
+	CHECK(keys[4] == std::vector<std::string>{"a", "c", "m"});
+	std::vector<std::string> logs;
+	for (auto log : leveldb.getLogs())
+		logs.emplace_back(log->file());
+	CHECK(logs == std::vector<std::string>{"000005.log", "000008.log", "000010.log"});
+
+	SECTION("no manifest")
+	{
+		std::filesystem::remove(path / "CURRENT");
+		LevelDB::LevelDB all(path.string());
+		REQUIRE(all.size() == 6);
+		// Unknown which file is newer, so nothing is replaced
+		auto allPasses = all.passes();
+		REQUIRE(allPasses.size() == 1);
+		CHECK(allPasses[0].size() == 6);
+		CHECK(all.getLogs().size() == 4);
+	}
+
+	std::filesystem::remove_all(path);
+}
+
+TEST_CASE("leveldb get", "[format]")
+{
+	auto key = [](char c, int i) {
+		return std::string(1, c) + std::to_string(10 + i);
+	};
+	Entries a, b, c;
+	for (int i = 0; i < 40; ++i)
+	{
+		a.emplace_back(internal_key(key('a', i)), "a" + std::to_string(i));
+		b.emplace_back(internal_key(key('b', i * 2)), "b" + std::to_string(i));
+		c.emplace_back(internal_key(key('c', i)), "c" + std::to_string(i));
+	}
+	// Older entry of the same key follows the newer one
+	c.emplace_back(key('d', 0) + std::string("\1\2\0\0\0\0\0\0", 8), "new");
+	c.emplace_back(key('d', 0) + std::string("\1\1\0\0\0\0\0\0", 8), "old");
+
+	auto get = [](std::vector<uint8_t> & table, std::vector<std::string> keys, std::ptrdiff_t & ret) {
+		std::vector<LevelDB::VectorData> views;
+		for (const auto & k : keys)
+			views.emplace_back(reinterpret_cast<const uint8_t *>(k.data()), k.size());
+		Entries entries;
+		LevelDB::LevelReader reader;
+		ret = reader.get({table.data(), table.size()}, {views.data(), views.size()}, [&entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+			auto user = LevelDB::userKey(key);
+			entries.emplace_back(std::string(user.begin(), user.end()), std::string(value.begin(), value.end()));
+		});
+		return entries;
+	};
+	std::ptrdiff_t ret;
+
+	SECTION("found")
+	{
+		auto table = build_table({{0, a}, {0, b}, {0, c}}, true);
+		auto entries = get(table, {key('a', 3), key('b', 3), key('b', 4), key('c', 39), key('d', 0), key('e', 0)}, ret);
+		REQUIRE(ret == 0);
+		REQUIRE(entries == Entries{{key('a', 3), "a3"}, {key('b', 4), "b2"}, {key('c', 39), "c39"}, {key('d', 0), "new"}});
+	}
+	SECTION("filter")
+	{
+		// Blocks that cannot be read are only touched without a filter
+		auto table = build_table({{0, a}, {9, b}, {0, c}}, true);
+		auto entries = get(table, {key('a', 5), key('b', 5), key('c', 5)}, ret);
+		REQUIRE(ret == 0);
+		REQUIRE(entries == Entries{{key('a', 5), "a5"}, {key('c', 5), "c5"}});
+		table = build_table({{0, a}, {9, b}, {0, c}});
+		get(table, {key('a', 5), key('b', 5), key('c', 5)}, ret);
+		REQUIRE(ret < 0);
+	}
+	SECTION("small blocks")
+	{
+		// Data block too small for its restarts, with an empty metaindex
+		std::vector<uint8_t> table{0, 0, 0, 0, 0, 0, 0};
+		std::vector<uint8_t> handle, footer;
+		write_varint(handle, 0);
+		write_varint(handle, 2);
+		write_varint(footer, table.size());
+		write_varint(footer, 0);
+		table.insert(table.end(), 5, 0);
+		auto index = build_block({{internal_key(key('a', 0)), std::string(handle.begin(), handle.end())}});
+		write_varint(footer, table.size());
+		write_varint(footer, index.size());
+		table.insert(table.end(), index.begin(), index.end());
+		table.insert(table.end(), 5, 0);
+		footer.resize(40);
+		write_fixed32(footer, 0x8b80fb57);
+		write_fixed32(footer, 0xdb477524);
+		table.insert(table.end(), footer.begin(), footer.end());
+		get(table, {key('a', 0)}, ret);
+		REQUIRE(ret < 0);
+	}
+}
+
+static std::string chunk_key(int32_t x, int32_t z, uint8_t type, int index = -1, int32_t dimension = 0)
+{
+	std::string key(8, '\0');
+	for (int b = 0; b < 4; ++b)
+	{
+		key[b] = char(uint32_t(x) >> (b * 8));
+		key[4 + b] = char(uint32_t(z) >> (b * 8));
+	}
+	for (int b = 0; dimension != 0 && b < 4; ++b)
+		key.push_back(char(uint32_t(dimension) >> (b * 8)));
+	key.push_back(char(type));
+	if (index >= 0)
+		key.push_back(char(index));
+	return key;
+}
+
+TEST_CASE("leveldb chunk", "[format]")
+{
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-leveldb-chunk";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+
+	auto sorted = [](Entries entries) {
+		std::sort(entries.begin(), entries.end());
+		return entries;
+	};
+	write_file(path / "000002.ldb", build_table({{0, sorted({
+		{internal_key(chunk_key(1, -2, 43)), "old"},
+		{internal_key(chunk_key(1, -2, 47, 0)), "old"},
+		{internal_key(chunk_key(1, -2, 47, 1)), "old"},
+		{internal_key(chunk_key(5, 5, 47, 0)), "other"},
+		// Not a type of chunk data, though sorted between them
+		{internal_key(chunk_key(1, -2, 100)), "unknown"},
+		{internal_key(chunk_key(1, -2, 43, -1, 1)), "nether"},
+		{internal_key("~local_player"), "player"},
+	})}}, true));
+	write_file(path / "000003.ldb", build_table({{0, sorted({
+		{internal_key(chunk_key(1, -2, 47, 0)), "new"},
+		// Deleted
+		{chunk_key(1, -2, 47, 1) + std::string(1, '\0') + std::string(7, '\1'), ""},
+	})}}, true));
+	// Logs are replayed in order
+	write_file(path / "000004.log", build_log({{{chunk_key(1, -2, 43), "log"}, {chunk_key(1, -2, 44), "older"}}}));
+	write_file(path / "000005.log", build_log({{{chunk_key(1, -2, 44), "log"}}}));
+
+	LevelDB::LevelDB leveldb(path.string());
+	Entries entries;
+	auto visit = [&entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+		entries.emplace_back(std::string(key.begin(), key.end()), std::string(value.begin(), value.end()));
+	};
+
+	SECTION("single")
+	{
+		REQUIRE(leveldb.getChunk(1, -2, 0, visit));
+		REQUIRE(sorted(entries) == sorted({
+			{chunk_key(1, -2, 43), "log"},
+			{chunk_key(1, -2, 44), "log"},
+			{chunk_key(1, -2, 47, 0), "new"},
+		}));
+	}
+	SECTION("range")
+	{
+		REQUIRE(leveldb.getChunks(5, 5, 0, -2, 0, visit));
+		REQUIRE(entries.size() == 4);
+		REQUIRE(std::count(entries.begin(), entries.end(), std::make_pair(chunk_key(5, 5, 47, 0), std::string("other"))) == 1);
+	}
+	SECTION("other dimension")
+	{
+		REQUIRE(leveldb.getChunk(1, -2, 1, visit));
+		REQUIRE(entries == Entries{{chunk_key(1, -2, 43, -1, 1), "nether"}});
+		entries.clear();
+		REQUIRE(leveldb.getChunk(1, -2, 2, visit));
+		REQUIRE(entries.empty());
+	}
+	SECTION("deleted in log")
+	{
+		// Empty values are still values
+		write_file(path / "000006.log", build_log({{{chunk_key(1, -2, 45), ""}}}, {chunk_key(1, -2, 47, 0)}));
+		LevelDB::LevelDB logged(path.string());
+		REQUIRE(logged.getChunk(1, -2, 0, visit));
+		REQUIRE(sorted(entries) == sorted({
+			{chunk_key(1, -2, 43), "log"},
+			{chunk_key(1, -2, 44), "log"},
+			{chunk_key(1, -2, 45), ""},
+		}));
+	}
+
+	std::filesystem::remove_all(path);
+}
+
+TEST_CASE("leveldb chunk filter", "[format]")
+{
+	auto may_contain = [](const std::string & lower, const std::string & upper, int32_t dimension) {
+		auto l = internal_key(lower);
+		auto u = internal_key(upper);
+		return parse::may_contain_chunk_data(
+			{reinterpret_cast<const uint8_t *>(l.data()), l.size()},
+			{reinterpret_cast<const uint8_t *>(u.data()), u.size()},
+			dimension);
+	};
+	SECTION("unbounded")
+	{
+		CHECK(parse::may_contain_chunk_data({}, {}, 0));
+		auto key = internal_key(chunk_key(0, 0, 44));
+		CHECK(parse::may_contain_chunk_data({}, {reinterpret_cast<const uint8_t *>(key.data()), key.size()}, 0));
+	}
+	SECTION("single chunk")
+	{
+		CHECK(may_contain(chunk_key(1, 2, 43), chunk_key(1, 2, 43), 0));
+		CHECK(may_contain(chunk_key(1, 2, 47, 0), chunk_key(1, 2, 47, 9), 0));
+		CHECK(may_contain(chunk_key(1, 2, 43), chunk_key(1, 2, 118), 0));
+		// Boundaries of the range
+		CHECK(may_contain(chunk_key(1, 2, 42), chunk_key(1, 2, 43), 0));
+		CHECK(may_contain(chunk_key(1, 2, 47, 3), chunk_key(1, 2, 59), 0));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 48), chunk_key(1, 2, 59), 0));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 59), chunk_key(1, 2, 118), 0));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 118), chunk_key(1, 2, 118), 0));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 44), chunk_key(1, 2, 44), 0));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 0), chunk_key(1, 2, 42), 0));
+	}
+	SECTION("several chunks")
+	{
+		CHECK(may_contain(chunk_key(1, 2, 59), chunk_key(2, 2, 44), 0));
+		CHECK(may_contain(chunk_key(-5, 3, 118), chunk_key(7, 3, 59), 0));
+	}
+	SECTION("other keys")
+	{
+		CHECK_FALSE(may_contain("~local_player", "~local_player", 0));
+		CHECK_FALSE(may_contain("scoreboard", "scores", 0));
+		CHECK(may_contain("AutonomousEntities", "~local_player", 0));
+	}
+	SECTION("dimension")
+	{
+		CHECK(may_contain(chunk_key(1, 2, 43, -1, 1), chunk_key(1, 2, 59, -1, 1), 1));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 59, -1, 1), chunk_key(1, 2, 118, -1, 1), 1));
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 43, -1, 1), chunk_key(1, 2, 47, 3, 1), 2));
+		// Nether keys in a range of the overworld
+		CHECK_FALSE(may_contain(chunk_key(1, 2, 43, -1, 1), chunk_key(1, 2, 118, -1, 1), 0));
+		CHECK(may_contain(chunk_key(1, 2, 43, -1, 1), chunk_key(1, 2, 43), 1));
+	}
+	SECTION("table")
+	{
+		// Only the second block is known to have no chunk data
+		auto table = build_table({
+			{0, {{internal_key(chunk_key(1, 2, 43)), "a"}, {internal_key(chunk_key(1, 2, 47, 0)), "b"}, {internal_key(chunk_key(1, 2, 50)), "c"}}},
+			{0, {{internal_key(chunk_key(1, 2, 54)), "d"}, {internal_key(chunk_key(1, 2, 118)), "e"}}},
+			{0, {{internal_key(chunk_key(2, 2, 44)), "f"}, {internal_key(chunk_key(2, 2, 47, 1)), "g"}}},
+			{0, {{internal_key("~local_player"), "h"}}},
+		});
+		LevelDB::LevelReader reader;
+		VectorView<uint8_t> data{table.data(), table.size()};
+		std::vector<LevelDB::LevelReader::BlockHandle> handles;
+		REQUIRE(reader.blocks(data, handles, [](const LevelDB::VectorData & lower, const LevelDB::VectorData & upper) {
+			return parse::may_contain_chunk_data(lower, upper, 0);
+		}) == 0);
+		Entries entries;
+		REQUIRE(reader.parse(data, {handles.data(), handles.size()}, [&entries](const LevelDB::VectorData & key, const LevelDB::VectorData & value) {
+			entries.emplace_back(std::string(key.begin(), key.end() - 8), std::string(value.begin(), value.end()));
+		}) == 0);
+		REQUIRE(handles.size() == 3);
+		REQUIRE(entries == Entries{
+			{chunk_key(1, 2, 43), "a"},
+			{chunk_key(1, 2, 47, 0), "b"},
+			{chunk_key(1, 2, 50), "c"},
+			{chunk_key(2, 2, 44), "f"},
+			{chunk_key(2, 2, 47, 1), "g"},
+			{"~local_player", "h"},
+		});
+	}
+}
+
+#if defined(USE_SNAPPY) || defined(USE_ZSTD)
+// Something resembling block data, with runs and repeating patterns
+static std::vector<uint8_t> compressible_data(std::size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = uint8_t((i / 64) % 7 == 0 ? 0 : (i * 13 + i / 4096) % 11);
+	return data;
+}
+#endif
+
+#ifdef USE_SNAPPY
+TEST_CASE("snappy", "[compression]")
+{
+	// Literal "abcd" followed by a copy of 8 bytes from 4 bytes back
+	const std::vector<uint8_t> compressed{12, 0x0C, 'a', 'b', 'c', 'd', 0x11, 0x04};
+	auto data = Compression::loadSnappy(compressed);
+	REQUIRE(std::string(data.begin(), data.end()) == "abcdabcdabcd");
+	// Copy from before the start
+	const std::vector<uint8_t> invalid{12, 0x0C, 'a', 'b', 'c', 'd', 0x11, 0x08};
+	REQUIRE(Compression::loadSnappy(invalid).empty());
+
+	SECTION("round trip")
+	{
+		for (std::size_t size : {1, 100, 65536, 1 << 20})
+		{
+			auto raw = compressible_data(size);
+			std::string out;
+			snappy::Compress(reinterpret_cast<const char *>(raw.data()), raw.size(), &out);
+			REQUIRE(Compression::loadSnappy(std::vector<uint8_t>(out.begin(), out.end())) == raw);
+		}
+	}
+	SECTION("size too large")
+	{
+		// Claims 1 GiB from a few bytes
+		std::vector<uint8_t> huge;
+		write_varint(huge, 1 << 30);
+		huge.insert(huge.end(), {0x0C, 'a', 'b', 'c', 'd'});
+		std::vector<uint8_t> out;
+		REQUIRE_FALSE(Compression::loadSnappy(VectorView<const uint8_t>{huge.data(), huge.size()}, out));
+		REQUIRE(out.capacity() < 1024);
+	}
+}
+#endif
+
+#ifdef USE_ZSTD
+TEST_CASE("zstd", "[compression]")
+{
+	std::vector<uint8_t> raw(1000);
+	for (std::size_t i = 0; i < raw.size(); ++i)
+		raw[i] = uint8_t(i * 7);
+	REQUIRE(Compression::loadZstd(compress_zstd(raw)) == raw);
+	// Without the content size, using a window of 1 KiB instead
+	auto streamed = compress_zstd(raw);
+	streamed.erase(streamed.begin() + 4, streamed.begin() + 7);
+	streamed.insert(streamed.begin() + 4, {0x00, 0x00});
+	REQUIRE(Compression::loadZstd(streamed) == raw);
+	auto truncated = compress_zstd(raw);
+	truncated.resize(truncated.size() / 2);
+	REQUIRE(Compression::loadZstd(truncated).empty());
+
+	SECTION("round trip")
+	{
+		for (std::size_t size : {1, 100, 65536, 1 << 20})
+		{
+			auto data = compressible_data(size);
+			std::vector<uint8_t> out(ZSTD_compressBound(data.size()));
+			auto length = ZSTD_compress(out.data(), out.size(), data.data(), data.size(), 3);
+			REQUIRE_FALSE(ZSTD_isError(length));
+			out.resize(length);
+			REQUIRE(Compression::loadZstd(out) == data);
+		}
+	}
+	SECTION("round trip streamed")
+	{
+		// Without the content size in the frame, so it has to grow the buffer
+		auto data = compressible_data(1 << 20);
+		auto context = ZSTD_createCCtx();
+		REQUIRE(context);
+		ZSTD_CCtx_setParameter(context, ZSTD_c_contentSizeFlag, 0);
+		std::vector<uint8_t> out(ZSTD_compressBound(data.size()));
+		auto length = ZSTD_compress2(context, out.data(), out.size(), data.data(), data.size());
+		ZSTD_freeCCtx(context);
+		REQUIRE_FALSE(ZSTD_isError(length));
+		out.resize(length);
+		REQUIRE(ZSTD_getFrameContentSize(out.data(), out.size()) == ZSTD_CONTENTSIZE_UNKNOWN);
+		REQUIRE(Compression::loadZstd(out) == data);
+	}
+	SECTION("size too large")
+	{
+		// Single segment frame claiming 2^62 bytes, followed by a last RLE block
+		std::vector<uint8_t> huge{0x28, 0xB5, 0x2F, 0xFD, 0xE0};
+		for (int i = 0; i < 8; ++i)
+			huge.push_back(i == 7 ? 0x40 : 0x00);
+		huge.insert(huge.end(), {0x0B, 0x00, 0x00, 'a'});
+		REQUIRE(ZSTD_getFrameContentSize(huge.data(), huge.size()) == uint64_t(1) << 62);
+		std::vector<uint8_t> out;
+		REQUIRE_FALSE(Compression::loadZstd(VectorView<const uint8_t>{huge.data(), huge.size()}, out));
+		REQUIRE(out.capacity() < 1024);
+	}
+}
+#endif
+
 TEST_CASE("nibble")
 {
 	uint8_t bits = GENERATE(1, 2, 3, 4, 5, 6, 8, 10, 14, 16, 32);
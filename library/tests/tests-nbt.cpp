@@ -3,8 +3,13 @@
 #include "catch2/generators/catch_generators.hpp"
 
 #include "format/nbt.hpp"
+#include "format/nbtparser.hpp"
 #include "util/endianess.hpp"
 
+// Count allocations, to check that parsing does not allocate
+#include "alloc-counter.hpp"
+
+#include <string>
 #include <vector>
 
 template<typename T>
@@ -183,6 +188,26 @@ TEST_CASE("NBT", "[format]")
 		tag.setName(test_name);
 		CHECK(tag.isName(test_name));
 		CHECK(tag.getName() == test_name);
+		CHECK(tag.id() == NBT::Id::UNKNOWN);
+		// Identifier follows the name
+		tag.setName("sections");
+		CHECK(tag.id() == NBT::Id::sections);
+		tag.setName("Sections");
+		CHECK(tag.id() == NBT::Id::Sections);
+		tag.set();
+		CHECK(tag.id() == NBT::Id::EMPTY);
+	}
+	SECTION("Id")
+	{
+		// Every known name is found by the hash
+		for (std::size_t i = std::size_t(NBT::Id::EMPTY); i < NBT::names::COUNT; ++i)
+			CHECK(NBT::identify(NBT::names::strings[i]) == NBT::Id(i));
+		static_assert(NBT::identify("block_states") == NBT::Id::block_states);
+		CHECK(NBT::identify("") == NBT::Id::EMPTY);
+		CHECK(NBT::identify("Y") == NBT::Id::Y);
+		CHECK(NBT::identify("y") == NBT::Id::UNKNOWN);
+		CHECK(NBT::identify("xPosition") == NBT::Id::UNKNOWN);
+		CHECK(NBT::identify("minecraft:stone") == NBT::Id::UNKNOWN);
 	}
 	SECTION("examples")
 	{
@@ -510,5 +535,189 @@ TEST_CASE("NBT", "[format]")
 		{
 			NBT::to_snbt(big_test, NBT::Endianess::BIG);
 		}
+
+		SECTION("scan")
+		{
+			NBT::Reader reader;
+			std::vector<std::string> names;
+			auto scan = [&names](const NBT::Tag & t) {
+				names.emplace_back(t.getName());
+				if (t.isName("Level") || t.isName("nested compound test"))
+					return NBT::Scan::ENTER;
+				if (t.isName("intTest"))
+					CHECK(t.get<int32_t>() == 2147483647);
+				return NBT::Scan::SKIP;
+			};
+			REQUIRE(reader.scan(big_test, scan, NBT::Endianess::BIG) == std::ptrdiff_t(big_test.size()));
+			CHECK(names == std::vector<std::string>{
+				"Level", "longTest", "shortTest", "stringTest", "floatTest", "intTest",
+				"nested compound test", "ham", "egg", "listTest (long)", "listTest (compound)",
+				"byteTest", "byteArrayTest (the first 1000 values of (n*n*255+n*7)%100, starting with n=0 (0, 62, 34, 16, 8, ...))",
+				"doubleTest", "intArrayTest", "longArrayTest"});
+
+			// Stop before the rest is read
+			auto stop = reader.scan(big_test, [](const NBT::Tag & t) {
+				if (t.isName("intTest"))
+					return NBT::Scan::STOP;
+				return t.isName("Level") ? NBT::Scan::ENTER : NBT::Scan::SKIP;
+			}, NBT::Endianess::BIG);
+			CHECK(stop > 0);
+			CHECK(stop < 150);
+
+			// Skipped structures are still checked
+			std::vector<uint8_t> truncated(big_test.begin(), big_test.begin() + 500);
+			REQUIRE(reader.scan(truncated, scan, NBT::Endianess::BIG) < 0);
+		}
+
+		SECTION("query")
+		{
+			struct Names : NBT::Visitor
+			{
+				std::vector<std::string> tags, strings;
+				int values = 0;
+				bool visit(const NBT::Value &) override { ++values; return false; }
+				bool visit(const NBT::Tag & t) override
+				{
+					tags.emplace_back(t.getName());
+					if (t == NBT::TAG_String)
+						strings.emplace_back(t.get<NBT::NBTString>());
+					return false;
+				}
+			};
+			NBT::Reader reader;
+
+			NBT::Query query{"intTest", "nested compound test.{egg.name}", "listTest (compound)[].name"};
+			Names names;
+			auto stop = reader.parse(big_test, query, names, NBT::Endianess::BIG);
+			CHECK(stop > 0);
+			// Stops at the end of the last requested tag
+			CHECK(stop < std::ptrdiff_t(big_test.size()));
+			CHECK(names.tags == std::vector<std::string>{
+				"Level", "intTest", "nested compound test", "egg", "name", "", "",
+				"listTest (compound)", "name", "", "name", ""});
+			CHECK(names.strings == std::vector<std::string>{"Eggbert", "Compound tag #0", "Compound tag #1"});
+			CHECK(names.values == 2);
+
+			// Ending on a structure reads all of it
+			NBT::Query whole{"nested compound test"};
+			Names all;
+			REQUIRE(reader.parse(big_test, whole, all, NBT::Endianess::BIG) > 0);
+			CHECK(all.tags == std::vector<std::string>{
+				"Level", "nested compound test", "ham", "name", "value", "", "egg", "name", "value", "", ""});
+
+			// Missing tags skips everything
+			NBT::Query missing{"missing", "Level.missing"};
+			Names none;
+			CHECK(reader.parse(big_test, missing, none, NBT::Endianess::BIG) == std::ptrdiff_t(big_test.size()));
+			CHECK(none.tags == std::vector<std::string>{"Level", ""});
+
+			// Skipped structures are still checked
+			std::vector<uint8_t> truncated(big_test.begin(), big_test.begin() + 500);
+			Names broken;
+			REQUIRE(reader.parse(truncated, missing, broken, NBT::Endianess::BIG) < 0);
+		}
+
+		SECTION("index")
+		{
+			struct Names : NBT::Visitor
+			{
+				std::vector<std::string> tags, strings;
+				int values = 0;
+				bool visit(const NBT::Value &) override { ++values; return false; }
+				bool visit(const NBT::Tag & t) override
+				{
+					tags.emplace_back(t.getName());
+					if (t == NBT::TAG_String)
+						strings.emplace_back(t.get<NBT::NBTString>());
+					return false;
+				}
+			};
+			NBT::Reader reader;
+			NBT::Index index;
+
+			REQUIRE(reader.index(big_test, index, NBT::Endianess::BIG) == std::ptrdiff_t(big_test.size()));
+			// Everything within compounds, but not within lists
+			CHECK(index.entries().size() == 19);
+
+			auto entry = index.find(big_test, "intTest");
+			REQUIRE(entry != nullptr);
+			CHECK(entry->type == NBT::TAG_Int);
+			CHECK(entry->parent == NBT::Index::ROOT);
+			Names single;
+			CHECK(reader.parse(big_test, *entry, single, NBT::Endianess::BIG) == std::ptrdiff_t(entry->offset + entry->length));
+			CHECK(single.tags == std::vector<std::string>{"intTest"});
+
+			entry = index.find(big_test, "nested compound test.egg.name");
+			REQUIRE(entry != nullptr);
+			CHECK(entry->type == NBT::TAG_String);
+			Names name;
+			REQUIRE(reader.parse(big_test, *entry, name, NBT::Endianess::BIG) > 0);
+			CHECK(name.strings == std::vector<std::string>{"Eggbert"});
+
+			// Structures are read with everything within them
+			entry = index.find(big_test, "nested compound test.egg");
+			REQUIRE(entry != nullptr);
+			Names egg;
+			REQUIRE(reader.parse(big_test, *entry, egg, NBT::Endianess::BIG) > 0);
+			CHECK(egg.tags == std::vector<std::string>{"egg", "name", "value", ""});
+
+			entry = index.find(big_test, "listTest (compound)");
+			REQUIRE(entry != nullptr);
+			CHECK(entry->type == NBT::TAG_List);
+			Names list;
+			REQUIRE(reader.parse(big_test, *entry, list, NBT::Endianess::BIG) > 0);
+			CHECK(list.strings == std::vector<std::string>{"Compound tag #0", "Compound tag #1"});
+			CHECK(list.values == 2);
+
+			CHECK(index.find(big_test, "missing") == nullptr);
+			CHECK(index.find(big_test, "egg") == nullptr);
+			CHECK(index.find(big_test, "intTest.missing") == nullptr);
+			CHECK(index.find(big_test, "nested compound test.missing") == nullptr);
+
+			// An entry must belong to the data
+			std::vector<uint8_t> other = {NBT::TAG_Compound, 0, 0, NBT::TAG_End};
+			Names wrong;
+			CHECK(reader.parse(other, index.entries().back(), wrong, NBT::Endianess::BIG) < 0);
+
+			std::vector<uint8_t> truncated(big_test.begin(), big_test.begin() + 500);
+			CHECK(reader.index(truncated, index, NBT::Endianess::BIG) < 0);
+		}
+
+		SECTION("allocations")
+		{
+			struct Counter final : NBT::Visitor
+			{
+				std::size_t tags = 0, values = 0;
+				bool visit(const NBT::Value &) override { ++values; return false; }
+				bool visit(const NBT::Tag & t) override
+				{
+					++tags;
+					// Transform the arrays as well
+					if (t == NBT::TAG_Int_Array)
+						t.get<NBT::NBTIntArray>();
+					if (t == NBT::TAG_Long_Array)
+						t.get<NBT::NBTLongArray>();
+					return false;
+				}
+			} counter;
+			NBT::Reader reader;
+			NBT::Query query{"nested compound test.egg", "listTest (compound)[].name", "intArrayTest"};
+			auto scan = [](const NBT::Tag & t) { return t.isName("Level") ? NBT::Scan::ENTER : NBT::Scan::SKIP; };
+			std::function<NBT::Scan(const NBT::Tag &)> scanner = scan;
+
+			auto before = allocations.load();
+			auto parsed = reader.parse<NBT::Endianess::BIG>(big_test, counter);
+			auto visited = reader.parse(big_test, static_cast<NBT::Visitor &>(counter), NBT::Endianess::BIG);
+			auto queried = reader.parse(big_test, query, counter, NBT::Endianess::BIG);
+			auto scanned = reader.scan(big_test, scanner, NBT::Endianess::BIG);
+			auto after = allocations.load();
+
+			CHECK(parsed == std::ptrdiff_t(big_test.size()));
+			CHECK(visited == std::ptrdiff_t(big_test.size()));
+			CHECK(queried > 0);
+			CHECK(scanned == std::ptrdiff_t(big_test.size()));
+			CHECK(counter.tags > 0);
+			CHECK(after - before == 0);
+		}
 	}
 }
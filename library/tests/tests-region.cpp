@@ -0,0 +1,290 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "format/region.hpp"
+#include "filecache.hpp"
+#include "minecraft.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <tuple>
+
+TEST_CASE("region", "[format]")
+{
+	using namespace region;
+	int x = 0, z = 0;
+	SECTION("file name")
+	{
+		SECTION("anvil")
+		{
+			REQUIRE(parseFileName("r.0.0.mca", RegionType::ANVIL, x, z));
+			CHECK(x == 0);
+			CHECK(z == 0);
+			REQUIRE(parseFileName("r.-12.345.mca", RegionType::ANVIL, x, z));
+			CHECK(x == -12);
+			CHECK(z == 345);
+			REQUIRE(parseFileName("r.7.-1.mca", RegionType::ANVIL, x, z));
+			CHECK(x == 7);
+			CHECK(z == -1);
+		}
+		SECTION("beta")
+		{
+			REQUIRE(parseFileName("r.3.4.mcr", RegionType::BETA, x, z));
+			CHECK(x == 3);
+			CHECK(z == 4);
+			REQUIRE_FALSE(parseFileName("r.3.4.mca", RegionType::BETA, x, z));
+		}
+		SECTION("invalid")
+		{
+			CHECK_FALSE(parseFileName("r.0.0.mcr", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r..0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.0..mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.+1.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.1.0.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.a.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("c.0.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.0.0.mca.tmp", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName("r.99999999999.0.mca", RegionType::ANVIL, x, z));
+			CHECK_FALSE(parseFileName(".mca", RegionType::ANVIL, x, z));
+		}
+	}
+}
+
+// Region file with each chunk in the sector given, filled with its index
+static std::vector<uint8_t> build_region(const std::vector<std::tuple<int, uint32_t, uint32_t>> & chunks)
+{
+	std::vector<uint8_t> data(8192, 0);
+	for (const auto & [i, sector, length] : chunks)
+	{
+		uint8_t sectors = uint8_t((length + 4 + 4095) / 4096);
+		data[i * 4] = uint8_t(sector >> 16);
+		data[i * 4 + 1] = uint8_t(sector >> 8);
+		data[i * 4 + 2] = uint8_t(sector);
+		data[i * 4 + 3] = sectors;
+		data.resize(std::max<std::size_t>(data.size(), (sector + sectors) * 4096));
+		auto ptr = data.data() + sector * 4096;
+		ptr[0] = uint8_t(length >> 24);
+		ptr[1] = uint8_t(length >> 16);
+		ptr[2] = uint8_t(length >> 8);
+		ptr[3] = uint8_t(length);
+		ptr[4] = 2; // zlib
+		std::fill(ptr + 5, ptr + 4 + length, uint8_t(i));
+	}
+	return data;
+}
+
+TEST_CASE("region chunks", "[format]")
+{
+	using namespace region;
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-region";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+
+	// Two neighbouring chunks, one spanning sectors after a gap, and one last
+	auto data = build_region({{0, 2, 100}, {1, 3, 5000}, {33, 8, 9000}, {1023, 11, 10}});
+	// Last sector is not padded
+	data.resize(11 * 4096 + 4 + 10);
+	{
+		std::ofstream out(path / "r.-1.0.mca", std::ios::binary);
+		out.write(reinterpret_cast<const char *>(data.data()), data.size());
+	}
+
+	auto check = [](const std::shared_ptr<ChunkData> & chunk, int i, uint32_t length) {
+		REQUIRE(chunk);
+		CHECK(chunk->xPos == -32 + (i & 31));
+		CHECK(chunk->zPos == (i >> 5));
+		CHECK(chunk->compression_type == ChunkData::COMPRESSION_ZLIB);
+		REQUIRE(chunk->data.size() == length - 1);
+		CHECK(std::all_of(chunk->data.begin(), chunk->data.end(), [i](uint8_t v) { return v == uint8_t(i); }));
+	};
+
+	Region region(path.string());
+	SECTION("single")
+	{
+		check(region.getChunk(-32, 0), 0, 100);
+		check(region.getChunk(-1, 31), 1023, 10);
+		CHECK_FALSE(region.getChunk(-30, 0));
+	}
+	SECTION("several")
+	{
+		auto chunks = region.getChunks({{-31, 0}, {-31, 1}, {-30, 0}, {-32, 0}, {-1, 31}, {0, 0}});
+		REQUIRE(chunks.size() == 6);
+		check(chunks[0], 1, 5000);
+		check(chunks[1], 33, 9000);
+		CHECK_FALSE(chunks[2]);
+		check(chunks[3], 0, 100);
+		check(chunks[4], 1023, 10);
+		CHECK_FALSE(chunks[5]);
+	}
+	SECTION("iterate")
+	{
+		std::vector<int> found;
+		for (auto file : region)
+		{
+			for (auto chunk : *file)
+			{
+				auto i = (chunk->xPos & 31) + (chunk->zPos & 31) * 32;
+				check(chunk, i, i == 0 ? 100 : i == 1 ? 5000 : i == 33 ? 9000 : 10);
+				found.push_back(i);
+			}
+		}
+		REQUIRE(found == std::vector<int>{0, 1, 33, 1023});
+	}
+	SECTION("kept after clear")
+	{
+		std::vector<std::shared_ptr<ChunkData>> chunks;
+		for (auto file : region)
+		{
+			// Loaded into memory when iterating
+			for (auto chunk : *file)
+				chunks.push_back(chunk);
+			auto found = file->getChunks({{0, 0}, {31, 31}});
+			chunks.insert(chunks.end(), found.begin(), found.end());
+			file->clear();
+		}
+		REQUIRE(chunks.size() == 6);
+		check(chunks[0], 0, 100);
+		check(chunks[3], 1023, 10);
+		check(chunks[4], 0, 100);
+		check(chunks[5], 1023, 10);
+	}
+	SECTION("lookup while iterating")
+	{
+		int amount = 0;
+		for (auto file : region)
+		{
+			// Regions not existing are added while iterating
+			for (int i = 0; i < 64; ++i)
+				CHECK_FALSE(region.getChunk(i * 32, 64));
+			amount += file->getAmountChunks();
+		}
+		CHECK(amount == 4);
+	}
+	SECTION("broken")
+	{
+		// Empty chunk, and one cut off before its end
+		auto broken = build_region({{0, 2, 10}, {1, 3, 100}});
+		broken[2 * 4096 + 3] = 0;
+		broken.resize(3 * 4096 + 4 + 99);
+		{
+			std::ofstream out(path / "r.0.0.mca", std::ios::binary);
+			out.write(reinterpret_cast<const char *>(broken.data()), broken.size());
+		}
+		CHECK_FALSE(region.getChunk(0, 0));
+		CHECK_FALSE(region.getChunk(1, 0));
+		auto chunks = region.getChunks({{0, 0}, {1, 0}});
+		CHECK_FALSE(chunks[0]);
+		CHECK_FALSE(chunks[1]);
+	}
+
+	std::filesystem::remove_all(path);
+}
+
+TEST_CASE("region index", "[format]")
+{
+	using namespace region;
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-region-index";
+	auto world = path / "world";
+	auto output = path / "output";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(world);
+
+	auto write = [&world](const std::vector<uint8_t> & data) {
+		std::ofstream out(world / "r.0.0.mca", std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char *>(data.data()), data.size());
+	};
+	auto count = [](Region & region) {
+		int amount = 0;
+		for (auto file : region)
+			amount += file->getAmountChunks();
+		return amount;
+	};
+	write(build_region({{0, 2, 100}}));
+	auto index = (output / INDEX_FILE).string();
+
+	{
+		Region region(world.string(), RegionType::ANVIL, index);
+		CHECK(count(region) == 1);
+	}
+	// Kept with the output and not in the world
+	CHECK(std::filesystem::exists(index));
+	CHECK_FALSE(std::filesystem::exists(world / INDEX_FILE));
+
+	Region region(world.string(), RegionType::ANVIL, index);
+	CHECK(count(region) == 1);
+	REQUIRE(region.getChunk(0, 0));
+	CHECK_FALSE(region.getChunk(1, 0));
+
+	// Changed after the header was loaded
+	write(build_region({{0, 2, 100}, {1, 3, 200}}));
+	FileCache::global().clear();
+	auto chunk = region.getChunk(1, 0);
+	REQUIRE(chunk);
+	CHECK(chunk->data.size() == 199);
+
+	// Index of other regions are not used
+	auto other = path / "other";
+	std::filesystem::create_directories(other);
+	std::filesystem::copy_file(world / "r.0.0.mca", other / "r.0.0.mca");
+	Region copy(other.string(), RegionType::ANVIL, index);
+	CHECK(count(copy) == 2);
+
+	std::filesystem::remove_all(path);
+}
+
+TEST_CASE("world info index", "[format]")
+{
+	using namespace region;
+	auto path = std::filesystem::temp_directory_path() / "pixelmap-tests-world-info";
+	auto world = path / "world";
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(world / "region");
+	std::filesystem::create_directories(world / "DIM-1" / "region");
+
+	std::vector<std::filesystem::path> files{world / "region" / "r.0.0.mca", world / "DIM-1" / "region" / "r.0.0.mca"};
+	auto write = [](const std::filesystem::path & file, const std::vector<uint8_t> & data) {
+		std::ofstream out(file, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char *>(data.data()), data.size());
+	};
+	write(files[0], build_region({{0, 2, 100}, {1, 3, 200}}));
+	write(files[1], build_region({{0, 2, 100}}));
+	auto chunks = [](const Minecraft::WorldInfo & info) {
+		std::map<int32_t, std::size_t> amount;
+		for (const auto & dim : info.dimensions)
+			amount[dim.dimension] = dim.amount_chunks;
+		return amount;
+	};
+	std::map<int32_t, std::size_t> expected{{0, 2}, {-1, 1}};
+	auto index = getIndexFile((path / "output").string(), true);
+	REQUIRE(chunks(*Minecraft::JE::getWorldInfo(world.string(), index)) == expected);
+	// Only read, so browsing a world does not create the output
+	CHECK_FALSE(std::filesystem::exists(path / "output"));
+
+	// Indexed by rendering each dimension
+	for (const auto & file : files)
+	{
+		Region region(file.parent_path().string(), RegionType::ANVIL, index);
+		region.begin();
+	}
+	REQUIRE(std::filesystem::exists(index));
+
+	// Clear the headers, while keeping the size and time of the files, so
+	// only reading them would notice
+	for (const auto & file : files)
+	{
+		auto time = std::filesystem::last_write_time(file);
+		{
+			std::fstream out(file, std::ios::binary | std::ios::in | std::ios::out);
+			std::vector<char> header(8192, 0);
+			out.write(header.data(), header.size());
+		}
+		std::filesystem::last_write_time(file, time);
+	}
+	// Every dimension is kept in the same index
+	CHECK(chunks(*Minecraft::JE::getWorldInfo(world.string(), index)) == expected);
+	CHECK(chunks(*Minecraft::JE::getWorldInfo(world.string())).empty());
+
+	std::filesystem::remove_all(path);
+}
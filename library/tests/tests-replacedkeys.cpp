@@ -0,0 +1,100 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "bedrock/replacedkeys.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::vector<std::vector<std::vector<std::string>>> Passes;
+
+// Read the files of every pass but the last over several threads, returning the keys announced for each pass
+static std::vector<std::vector<std::string>> announce_passes(const Passes & passes, std::size_t threads)
+{
+	std::mutex mutex;
+	std::vector<std::size_t> files;
+	for (const auto & pass : passes)
+		files.emplace_back(pass.size());
+	std::vector<std::vector<bool>> read(passes.size());
+	for (std::size_t p = 0; p < passes.size(); ++p)
+		read[p].assign(passes[p].size(), false);
+	std::vector<std::vector<std::string>> announced;
+	bool ordered = true;
+	auto readKeys = [&mutex, &passes, &read](std::size_t pass, std::size_t file) {
+		std::lock_guard<std::mutex> lock(mutex);
+		read[pass][file] = true;
+		return passes[pass][file];
+	};
+	// Note: May be called on any of the threads, so check afterwards
+	auto ready = [&mutex, &read, &announced, &ordered](std::size_t pass, const bedrock::ReplacedKeys::Keys & keys) {
+		std::lock_guard<std::mutex> lock(mutex);
+		ordered = ordered && pass == announced.size();
+		// Every file before the pass is read before announcing it
+		for (std::size_t p = 0; p < pass; ++p)
+			for (auto file : read[p])
+				ordered = ordered && file;
+		announced.emplace_back(*keys);
+	};
+	bedrock::ReplacedKeys replaced(files, std::move(readKeys), std::move(ready));
+	REQUIRE(replaced.size() == passes.size());
+
+	std::vector<std::pair<std::size_t, std::size_t>> work;
+	for (std::size_t p = 0; p + 1 < passes.size(); ++p)
+		for (std::size_t f = 0; f < passes[p].size(); ++f)
+			work.emplace_back(p, f);
+	std::atomic_size_t next{0};
+	auto worker = [&replaced, &work, &next]() {
+		for (std::size_t i; (i = next++) < work.size();)
+			replaced.work(work[i].first, work[i].second);
+	};
+	std::vector<std::thread> helpers;
+	for (std::size_t i = 1; i < threads; ++i)
+		helpers.emplace_back(worker);
+	replaced.start();
+	worker();
+	for (auto & helper : helpers)
+		helper.join();
+	CHECK(ordered);
+	return announced;
+}
+
+TEST_CASE("replaced keys", "[bedrock]")
+{
+	SECTION("passes")
+	{
+		Passes passes{
+			{{"c", "d"}},
+			{{"d", "e"}},
+			{{"b"}, {"n", "z"}, {}},
+			{{"a", "c"}, {"m"}}};
+		std::vector<std::vector<std::string>> expected{
+			{},
+			{"c", "d"},
+			{"c", "d", "e"},
+			{"b", "c", "d", "e", "n", "z"}};
+		for (std::size_t threads = 1; threads <= 4; ++threads)
+			CHECK(announce_passes(passes, threads) == expected);
+	}
+	SECTION("single")
+	{
+		// Nothing to read, so only the first pass is announced
+		Passes passes{{{"a"}, {"b"}}};
+		CHECK(announce_passes(passes, 1) == std::vector<std::vector<std::string>>{{}});
+	}
+	SECTION("not started")
+	{
+		std::vector<std::size_t> ready;
+		bedrock::ReplacedKeys replaced({1, 1}, [](std::size_t, std::size_t) {
+			return std::vector<std::string>{"a"};
+		}, [&ready](std::size_t pass, const bedrock::ReplacedKeys::Keys &) {
+			ready.emplace_back(pass);
+		});
+		// Later passes wait for the first
+		replaced.work(0, 0);
+		CHECK(ready.empty());
+		replaced.start();
+		CHECK(ready == std::vector<std::size_t>{0, 1});
+	}
+}